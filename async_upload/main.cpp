@@ -0,0 +1,304 @@
+#include <glad/glad.h>
+#include <GLFW/glfw3.h>
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <iostream>
+#include <random>
+#include <vector>
+#include "upload_thread.h"
+
+// Throw an exception and terminate GLFW
+void throw_ex(const char* msg)
+{
+   std::cout << msg << '\n';
+   glfwTerminate();
+   std::exit(-1);
+}
+
+// Resize callback function
+void framebuffer_size_callback(GLFWwindow*, int width, int height)
+{
+   assert(width > 0 && height > 0);
+   glViewport(0, 0, width, height);
+}
+
+// Compile a shader and print the info log if it fails
+unsigned compile_shader(GLenum type, const char* source)
+{
+   unsigned shader = glCreateShader(type);
+   glShaderSource(shader, 1, &source, nullptr);
+   glCompileShader(shader);
+
+   int success = 0;
+   char info_log[512] = "\0";
+   glGetShaderiv(shader, GL_COMPILE_STATUS, &success);
+
+   if (!success)
+   {
+      glGetShaderInfoLog(shader, sizeof(info_log), nullptr, info_log);
+      std::cout << "Failed to compile the shader: " << info_log;
+   }
+   return shader;
+}
+
+// Link a vertex and a fragment shader into a program and clean up the shaders
+unsigned link_program(const char* vertex_source, const char* fragment_source)
+{
+   unsigned vertex_shader = compile_shader(GL_VERTEX_SHADER, vertex_source);
+   unsigned fragment_shader = compile_shader(GL_FRAGMENT_SHADER, fragment_source);
+
+   unsigned program = glCreateProgram();
+   glAttachShader(program, vertex_shader);
+   glAttachShader(program, fragment_shader);
+   glLinkProgram(program);
+
+   int success = 0;
+   char info_log[512] = "\0";
+   glGetProgramiv(program, GL_LINK_STATUS, &success);
+
+   if (!success)
+   {
+      glGetProgramInfoLog(program, sizeof(info_log), nullptr, info_log);
+      std::cout << "Failed to link the shader program: " << info_log;
+   }
+
+   glDeleteShader(vertex_shader);
+   glDeleteShader(fragment_shader);
+   return program;
+}
+
+// Source data for one upload: a big RGBA image and a big point cloud
+struct Asset
+{
+   int size;
+   std::vector<unsigned char> pixels;
+   std::vector<float> points;
+};
+
+// Rings on the image and a spiral of points, different for every seed
+Asset make_asset(int size, size_t point_count, unsigned seed)
+{
+   Asset asset { size, std::vector<unsigned char>(size_t(size) * size * 4), std::vector<float>(point_count * 2) };
+
+   const float frequency = .02f + .01f * seed;
+   for (int y = 0; y < size; ++y)
+      for (int x = 0; x < size; ++x)
+      {
+         const float dx = float(x - size / 2), dy = float(y - size / 2);
+         const float wave = .5f + .5f * std::sin(std::sqrt(dx * dx + dy * dy) * frequency);
+         unsigned char* pixel = &asset.pixels[(size_t(y) * size + x) * 4];
+         pixel[0] = (unsigned char)(255 * wave);
+         pixel[1] = (unsigned char)(128 * wave);
+         pixel[2] = (unsigned char)(255 * (1.f - wave) * (seed % 2));
+         pixel[3] = 255;
+      }
+
+   std::mt19937 random(seed);
+   std::normal_distribution<float> spread(0.f, .03f);
+   for (size_t i = 0; i < point_count; ++i)
+   {
+      const float t = float(i) / point_count, angle = t * 40.f + seed;
+      asset.points[i * 2 + 0] = std::cos(angle) * t * .9f + spread(random);
+      asset.points[i * 2 + 1] = std::sin(angle) * t * .9f + spread(random);
+   }
+   return asset;
+}
+
+// Main function
+int main()
+{
+   // Vertex shader, a full screen quad from gl_VertexID or a point from the cloud
+   const char* vertex_shader_source =
+      "#version 330 core\n"
+      "layout (location = 0) in vec2 aPos;\n"
+      "uniform bool quad;\n"
+      "out vec2 TexCoord;\n"
+      "void main()\n"
+      "{\n"
+      "   vec2 corner = vec2(gl_VertexID & 1, gl_VertexID >> 1);\n"
+      "   TexCoord = corner;\n"
+      "   gl_Position = vec4(quad ? corner * 2.0 - 1.0 : aPos, 0.0, 1.0);\n"
+      "}\0";
+
+   // Fragment shader
+   const char* fragment_shader_source =
+      "#version 330 core\n"
+      "in vec2 TexCoord;\n"
+      "uniform bool quad;\n"
+      "uniform sampler2D image;\n"
+      "out vec4 FragColor;\n"
+      "void main()\n"
+      "{\n"
+      "   FragColor = quad ? texture(image, TexCoord) : vec4(1.0f);\n"
+      "}\0";
+
+   // Initialize GLFW and tell it the version and profile
+   glfwInit();
+   glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
+   glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
+   glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+
+   // Initialize the window
+   GLFWwindow* window = glfwCreateWindow(800, 600, "Async upload.", nullptr, nullptr);
+   if (!window)
+      throw_ex("Failed to create the window!");
+
+   // Set the current window
+   glfwMakeContextCurrent(window);
+
+   // Initialize GLAD
+   if (!gladLoadGLLoader(GLADloadproc(glfwGetProcAddress)))
+      throw_ex("Failed to initialize GLAD!");
+
+   // Set the viewport
+   glViewport(0, 0, 800, 600);
+
+   // Set window resize callback
+   glfwSetFramebufferSizeCallback(window, framebuffer_size_callback);
+
+   // Create the shader program
+   unsigned shader_program = link_program(vertex_shader_source, fragment_shader_source);
+   const int quad_location = glGetUniformLocation(shader_program, "quad");
+
+   // Two assets to swap between, 16 MB of pixels and 512 KB of points each
+   const size_t point_count = 1 << 16;
+   const Asset assets[] { make_asset(2048, point_count, 1), make_asset(2048, point_count, 2) };
+
+   // The VAO stays on the render thread, only its buffer changes
+   unsigned VAO = 0;
+   glGenVertexArrays(1, &VAO);
+
+   // The scope makes sure the loader is joined before glfwTerminate
+   {
+      UploadThread loader(window);
+      if (!loader.valid())
+         throw_ex("Failed to create the loader context!");
+
+      // B switches between the loader thread and uploading on the render thread
+      bool use_loader = true, b_down = false;
+      unsigned texture = 0, VBO = 0;
+      unsigned next_asset = 0;
+      std::vector<CompletedUpload> ready;
+
+      double stats_time = glfwGetTime(), last_frame = stats_time, worst_frame = 0.0;
+      int frames = 0, swaps = 0;
+      unsigned frame = 0;
+
+      // Create the render loop
+      while (!glfwWindowShouldClose(window))
+      {
+         // Check if the window should close
+         if (glfwGetKey(window, GLFW_KEY_ESCAPE) == GLFW_PRESS)
+            glfwSetWindowShouldClose(window, true);
+
+         const bool b_pressed = glfwGetKey(window, GLFW_KEY_B) == GLFW_PRESS;
+         if (b_pressed && !b_down)
+            use_loader = !use_loader;
+         b_down = b_pressed;
+
+         // Start the next asset every 20 frames
+         if (frame++ % 20 == 0)
+         {
+            const Asset& asset = assets[next_asset++ % 2];
+            if (use_loader)
+            {
+               // Only one asset in flight, the next one waits for the previous to land
+               if (loader.pending() == 0)
+               {
+                  loader.upload_texture(asset.pixels.data(), asset.size, asset.size);
+                  loader.upload_buffer(asset.points.data(), asset.points.size() * sizeof(float));
+               }
+            }
+            else
+            {
+               // The same work right here, the frame waits for it
+               unsigned name = 0;
+               glGenTextures(1, &name);
+               glBindTexture(GL_TEXTURE_2D, name);
+               glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, asset.size, asset.size, 0, GL_RGBA, GL_UNSIGNED_BYTE, asset.pixels.data());
+               glGenerateMipmap(GL_TEXTURE_2D);
+               glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+               glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+               ready.push_back({ 0, UploadKind::Texture, name });
+
+               glGenBuffers(1, &name);
+               glBindBuffer(GL_ARRAY_BUFFER, name);
+               glBufferData(GL_ARRAY_BUFFER, asset.points.size() * sizeof(float), asset.points.data(), GL_STATIC_DRAW);
+               ready.push_back({ 0, UploadKind::Buffer, name });
+            }
+         }
+
+         // Swap in whatever has finished uploading
+         loader.poll(ready);
+         for (const CompletedUpload& upload : ready)
+         {
+            if (upload.kind == UploadKind::Texture)
+            {
+               glDeleteTextures(1, &texture);
+               texture = upload.name;
+               ++swaps;
+            }
+            else
+            {
+               glDeleteBuffers(1, &VBO);
+               VBO = upload.name;
+
+               // Binding the buffer here is what makes the loader's contents visible to this context
+               glBindVertexArray(VAO);
+               glBindBuffer(GL_ARRAY_BUFFER, VBO);
+               glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, 2 * sizeof(float), (void*)0);
+               glEnableVertexAttribArray(0);
+               glBindVertexArray(0);
+            }
+         }
+         ready.clear();
+
+         // Render
+         glClearColor(.5f, .5f, .5f, 1.f);
+         glClear(GL_COLOR_BUFFER_BIT);
+
+         glUseProgram(shader_program);
+         glBindVertexArray(VAO);
+         if (texture)
+         {
+            glBindTexture(GL_TEXTURE_2D, texture);
+            glUniform1i(quad_location, 1);
+            glDrawArrays(GL_TRIANGLE_STRIP, 0, 4);
+         }
+         if (VBO)
+         {
+            glUniform1i(quad_location, 0);
+            glDrawArrays(GL_POINTS, 0, GLsizei(point_count));
+         }
+         glBindVertexArray(0);
+
+         // Swap buffers and check and call events
+         glfwSwapBuffers(window);
+         glfwPollEvents();
+
+         // Print the average and the worst frame once a second, the worst frame is where upload spikes show
+         ++frames;
+         const double now = glfwGetTime();
+         worst_frame = std::max(worst_frame, now - last_frame);
+         last_frame = now;
+         if (now - stats_time >= 1.0)
+         {
+            std::cout << (use_loader ? "Loader thread: " : "Render thread: ") << (now - stats_time) * 1000.0 / frames
+                      << " ms/frame, worst " << worst_frame * 1000.0 << " ms, " << swaps << " assets swapped in\n";
+            stats_time = now;
+            worst_frame = 0.0;
+            frames = swaps = 0;
+         }
+      }
+
+      glDeleteTextures(1, &texture);
+      glDeleteBuffers(1, &VBO);
+   }
+
+   // Clean up
+   glDeleteVertexArrays(1, &VAO);
+   glDeleteProgram(shader_program);
+   glfwTerminate();
+   return 0;
+}
@@ -0,0 +1,215 @@
+#pragma once
+#include <glad/glad.h>
+#include <GLFW/glfw3.h>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Buffer and texture uploads on a loader thread with its own GL context
+// The loader context belongs to a hidden window that shares objects with the render window. Every upload
+// creates a new object there and is followed by a fence, the render thread polls the fences without waiting
+// and only uses an object once its fence has signaled. Buffers, textures and fences are shared between the
+// contexts but VAOs are not, so VAOs around uploaded buffers are set up on the render thread.
+
+// Kinds of uploads
+enum class UploadKind
+{
+   Buffer,
+   Texture
+};
+
+// Upload the render thread can use now
+struct CompletedUpload
+{
+   std::uint64_t id;
+   UploadKind kind;
+   unsigned name;
+};
+
+class UploadThread
+{
+public:
+   // Call on the main thread with the render context current, GLFW only creates windows there
+   explicit UploadThread(GLFWwindow* render_window)
+   {
+      glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
+      loader_window = glfwCreateWindow(1, 1, "Loader.", nullptr, render_window);
+      glfwWindowHint(GLFW_VISIBLE, GLFW_TRUE);
+
+      if (loader_window)
+         worker = std::thread(&UploadThread::run, this);
+   }
+
+   UploadThread(const UploadThread&) = delete;
+   UploadThread& operator=(const UploadThread&) = delete;
+
+   // Call on the main thread with the render context current
+   ~UploadThread()
+   {
+      {
+         std::lock_guard<std::mutex> lock(mutex);
+         stopping = true;
+      }
+      wake.notify_one();
+
+      if (worker.joinable())
+         worker.join();
+      if (loader_window)
+         glfwDestroyWindow(loader_window);
+
+      // Nobody picked these up, the objects are shared so they can be deleted from here
+      in_flight.insert(in_flight.end(), finished.begin(), finished.end());
+      for (const Finished& upload : in_flight)
+      {
+         glDeleteSync(upload.fence);
+         if (upload.result.kind == UploadKind::Buffer)
+            glDeleteBuffers(1, &upload.result.name);
+         else
+            glDeleteTextures(1, &upload.result.name);
+      }
+   }
+
+   // False if the loader context could not be created
+   bool valid() const { return loader_window != nullptr; }
+
+   // Upload into a new buffer, data has to stay valid until the upload comes out of poll
+   std::uint64_t upload_buffer(const void* data, size_t bytes, GLenum usage = GL_STATIC_DRAW)
+   {
+      return push({ 0, UploadKind::Buffer, data, bytes, usage, 0, 0 });
+   }
+
+   // Upload into a new mipmapped RGBA8 texture, same lifetime rule for the pixels
+   std::uint64_t upload_texture(const void* rgba, int width, int height)
+   {
+      return push({ 0, UploadKind::Texture, rgba, 0, 0, width, height });
+   }
+
+   // Move uploads whose fence has signaled into ready, never blocks
+   void poll(std::vector<CompletedUpload>& ready)
+   {
+      {
+         std::lock_guard<std::mutex> lock(mutex);
+         in_flight.insert(in_flight.end(), finished.begin(), finished.end());
+         finished.clear();
+      }
+
+      for (auto it = in_flight.begin(); it != in_flight.end();)
+      {
+         const GLenum status = glClientWaitSync(it->fence, 0, 0);
+         if (status != GL_ALREADY_SIGNALED && status != GL_CONDITION_SATISFIED)
+         {
+            ++it;
+            continue;
+         }
+
+         glDeleteSync(it->fence);
+         ready.push_back(it->result);
+         it = in_flight.erase(it);
+      }
+   }
+
+   // Uploads requested but not handed out by poll yet, call on the render thread
+   size_t pending() const
+   {
+      std::lock_guard<std::mutex> lock(mutex);
+      return queued.size() + finished.size() + in_flight.size() + (busy ? 1 : 0);
+   }
+
+private:
+   struct Request
+   {
+      std::uint64_t id;
+      UploadKind kind;
+      const void* data;
+      size_t bytes;
+      GLenum usage;
+      int width, height;
+   };
+
+   struct Finished
+   {
+      CompletedUpload result;
+      GLsync fence;
+   };
+
+   std::uint64_t push(Request request)
+   {
+      {
+         std::lock_guard<std::mutex> lock(mutex);
+         request.id = next_id++;
+         queued.push_back(request);
+      }
+      wake.notify_one();
+      return request.id;
+   }
+
+   void run()
+   {
+      glfwMakeContextCurrent(loader_window);
+
+      std::unique_lock<std::mutex> lock(mutex);
+      while (true)
+      {
+         wake.wait(lock, [&] { return stopping || !queued.empty(); });
+         if (stopping)
+            break;
+
+         const Request request = queued.front();
+         queued.pop_front();
+         busy = true;
+         lock.unlock();
+
+         const unsigned name = execute(request);
+         const GLsync fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+
+         // Flush so the fence reaches the GPU, otherwise the render thread could poll it forever
+         glFlush();
+
+         lock.lock();
+         finished.push_back({ { request.id, request.kind, name }, fence });
+         busy = false;
+      }
+      lock.unlock();
+
+      glfwMakeContextCurrent(nullptr);
+   }
+
+   // Runs on the loader thread, binds to targets the render thread's state doesn't depend on
+   unsigned execute(const Request& request)
+   {
+      unsigned name = 0;
+      if (request.kind == UploadKind::Buffer)
+      {
+         glGenBuffers(1, &name);
+         glBindBuffer(GL_COPY_WRITE_BUFFER, name);
+         glBufferData(GL_COPY_WRITE_BUFFER, GLsizeiptr(request.bytes), request.data, request.usage);
+         glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+      }
+      else
+      {
+         glGenTextures(1, &name);
+         glBindTexture(GL_TEXTURE_2D, name);
+         glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, request.width, request.height, 0, GL_RGBA, GL_UNSIGNED_BYTE, request.data);
+         glGenerateMipmap(GL_TEXTURE_2D);
+         glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+         glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+         glBindTexture(GL_TEXTURE_2D, 0);
+      }
+      return name;
+   }
+
+   GLFWwindow* loader_window = nullptr;
+   std::thread worker;
+   mutable std::mutex mutex;
+   std::condition_variable wake;
+   std::deque<Request> queued;
+   std::vector<Finished> finished;
+   std::vector<Finished> in_flight;
+   std::uint64_t next_id = 1;
+   bool busy = false;
+   bool stopping = false;
+};
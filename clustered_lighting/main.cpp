@@ -0,0 +1,794 @@
+#include <glad/glad.h>
+#include <GLFW/glfw3.h>
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <iostream>
+#include <random>
+#include <thread>
+#include <vector>
+
+// Throw an exception and terminate GLFW
+void throw_ex(const char* msg)
+{
+   std::cout << msg << '\n';
+   glfwTerminate();
+   std::exit(-1);
+}
+
+// Resize callback function
+void framebuffer_size_callback(GLFWwindow*, int width, int height)
+{
+   // A minimized window has a 0x0 framebuffer, the render loop waits until it is restored
+   if (width == 0 || height == 0)
+      return;
+   glViewport(0, 0, width, height);
+}
+
+// Compile a shader and print the info log if it fails
+unsigned compile_shader(GLenum type, const char* source)
+{
+   unsigned shader = glCreateShader(type);
+   glShaderSource(shader, 1, &source, nullptr);
+   glCompileShader(shader);
+
+   int success = 0;
+   char info_log[512] = "\0";
+   glGetShaderiv(shader, GL_COMPILE_STATUS, &success);
+
+   if (!success)
+   {
+      glGetShaderInfoLog(shader, sizeof(info_log), nullptr, info_log);
+      std::cout << "Failed to compile the shader: " << info_log;
+   }
+   return shader;
+}
+
+// Link a vertex and a fragment shader into a program and clean up the shaders
+unsigned link_program(const char* vertex_source, const char* fragment_source)
+{
+   unsigned vertex_shader = compile_shader(GL_VERTEX_SHADER, vertex_source);
+   unsigned fragment_shader = compile_shader(GL_FRAGMENT_SHADER, fragment_source);
+
+   unsigned program = glCreateProgram();
+   glAttachShader(program, vertex_shader);
+   glAttachShader(program, fragment_shader);
+   glLinkProgram(program);
+
+   int success = 0;
+   char info_log[512] = "\0";
+   glGetProgramiv(program, GL_LINK_STATUS, &success);
+
+   if (!success)
+   {
+      glGetProgramInfoLog(program, sizeof(info_log), nullptr, info_log);
+      std::cout << "Failed to link the shader program: " << info_log;
+   }
+
+   glDeleteShader(vertex_shader);
+   glDeleteShader(fragment_shader);
+   return program;
+}
+
+// Column-major 4x4 matrix
+struct Mat4
+{
+   float m[16];
+};
+
+Mat4 identity()
+{
+   Mat4 r {};
+   r.m[0] = r.m[5] = r.m[10] = r.m[15] = 1.f;
+   return r;
+}
+
+Mat4 multiply(const Mat4& a, const Mat4& b)
+{
+   Mat4 r {};
+   for (int col = 0; col < 4; ++col)
+      for (int row = 0; row < 4; ++row)
+         r.m[col * 4 + row] =
+            a.m[0 * 4 + row] * b.m[col * 4 + 0] +
+            a.m[1 * 4 + row] * b.m[col * 4 + 1] +
+            a.m[2 * 4 + row] * b.m[col * 4 + 2] +
+            a.m[3 * 4 + row] * b.m[col * 4 + 3];
+   return r;
+}
+
+Mat4 translate(float x, float y, float z)
+{
+   Mat4 r = identity();
+   r.m[12] = x;
+   r.m[13] = y;
+   r.m[14] = z;
+   return r;
+}
+
+Mat4 rotate_x(float angle)
+{
+   Mat4 r = identity();
+   r.m[5] = std::cos(angle);
+   r.m[6] = std::sin(angle);
+   r.m[9] = -r.m[6];
+   r.m[10] = r.m[5];
+   return r;
+}
+
+Mat4 rotate_y(float angle)
+{
+   Mat4 r = identity();
+   r.m[0] = std::cos(angle);
+   r.m[2] = -std::sin(angle);
+   r.m[8] = -r.m[2];
+   r.m[10] = r.m[0];
+   return r;
+}
+
+Mat4 perspective(float fov_y, float aspect, float near_plane, float far_plane)
+{
+   const float f = 1.f / std::tan(fov_y * .5f);
+   Mat4 r {};
+   r.m[0] = f / aspect;
+   r.m[5] = f;
+   r.m[10] = (far_plane + near_plane) / (near_plane - far_plane);
+   r.m[11] = -1.f;
+   r.m[14] = 2.f * far_plane * near_plane / (near_plane - far_plane);
+   return r;
+}
+
+// Run fn(begin, end) over [0, count) split between all cores
+template <typename Fn>
+void parallel_for(size_t count, Fn fn)
+{
+   const size_t thread_count = std::min<size_t>(std::max(1u, std::thread::hardware_concurrency()), count);
+   if (thread_count <= 1)
+   {
+      fn(size_t(0), count);
+      return;
+   }
+
+   std::vector<std::thread> threads;
+   const size_t per_thread = (count + thread_count - 1) / thread_count;
+   for (size_t begin = 0; begin < count; begin += per_thread)
+      threads.emplace_back(fn, begin, std::min(begin + per_thread, count));
+
+   for (std::thread& thread : threads)
+      thread.join();
+}
+
+// Cluster grid, tiles across the screen and exponential slices in depth
+constexpr int cluster_x = 32, cluster_y = 18, cluster_z = 32;
+constexpr int cluster_count = cluster_x * cluster_y * cluster_z;
+constexpr float near_plane = .5f, far_plane = 150.f;
+
+// Point light, or a spot light when cos_outer is above -1
+struct Light
+{
+   float position[3];
+   float radius;
+   float color[3];
+   float cos_outer;
+   float direction[3];
+   float orbit;
+};
+
+// What the shaders read per light, three RGBA32F texels in view space
+struct GpuLight
+{
+   float position[3];
+   float radius;
+   float color[3];
+   float cos_outer;
+   float direction[3];
+   float padding;
+};
+
+// Lights sorted into clusters
+// Every cluster has an offset and a count into one compact index list
+class LightClusters
+{
+public:
+   LightClusters() : cluster_lights(cluster_count) {}
+
+   // Move the lights to view space and bin them into the compact lists
+   void build(const std::vector<Light>& lights, const Mat4& view, float fov_y, float aspect)
+   {
+      const size_t light_count = lights.size();
+      view_lights.resize(light_count);
+      ranges.resize(light_count);
+
+      // Cluster bounds only change with the projection
+      if (aspect != bounds_aspect)
+      {
+         compute_bounds(fov_y, aspect);
+         bounds_aspect = aspect;
+      }
+
+      // View space position and the conservative range of clusters every light can touch
+      const float tan_y = std::tan(fov_y * .5f), tan_x = tan_y * aspect;
+      const float slice_scale = cluster_z / std::log(far_plane / near_plane);
+      parallel_for(light_count, [&](size_t begin, size_t end)
+      {
+         for (size_t i = begin; i < end; ++i)
+         {
+            const Light& light = lights[i];
+            GpuLight& out = view_lights[i];
+            to_view(light, view, out);
+
+            ClusterRange& range = ranges[i];
+            const float depth = -out.position[2];
+            const float z_min = std::max(depth - light.radius, near_plane), z_max = std::min(depth + light.radius, far_plane);
+            if (z_min > z_max)
+            {
+               range.z0 = 1;
+               range.z1 = 0;
+               continue;
+            }
+
+            range.z0 = std::clamp(int(std::log(z_min / near_plane) * slice_scale), 0, cluster_z - 1);
+            range.z1 = std::clamp(int(std::log(z_max / near_plane) * slice_scale), 0, cluster_z - 1);
+
+            // Widest screen extent of the sphere's box over its depth range
+            auto tile_range = [&](float low, float high, float tan_half, int tiles, int& first, int& last)
+            {
+               const float ndc_low = low / ((low < 0.f ? z_min : z_max) * tan_half);
+               const float ndc_high = high / ((high > 0.f ? z_min : z_max) * tan_half);
+               first = std::clamp(int((ndc_low * .5f + .5f) * tiles), 0, tiles - 1);
+               last = std::clamp(int((ndc_high * .5f + .5f) * tiles), 0, tiles - 1);
+               if (ndc_high < -1.f || ndc_low > 1.f)
+                  last = first - 1;
+            };
+            tile_range(out.position[0] - light.radius, out.position[0] + light.radius, tan_x, cluster_x, range.x0, range.x1);
+            tile_range(out.position[1] - light.radius, out.position[1] + light.radius, tan_y, cluster_y, range.y0, range.y1);
+         }
+      });
+
+      // Every thread owns whole depth slices, so no two threads write the same cluster
+      parallel_for(cluster_z, [&](size_t slice_begin, size_t slice_end)
+      {
+         for (size_t slice = slice_begin; slice < slice_end; ++slice)
+         {
+            for (int tile = 0; tile < cluster_x * cluster_y; ++tile)
+               cluster_lights[slice * cluster_x * cluster_y + tile].clear();
+
+            for (size_t i = 0; i < light_count; ++i)
+            {
+               const ClusterRange& range = ranges[i];
+               if (int(slice) < range.z0 || int(slice) > range.z1)
+                  continue;
+
+               const GpuLight& light = view_lights[i];
+               for (int y = range.y0; y <= range.y1; ++y)
+                  for (int x = range.x0; x <= range.x1; ++x)
+                  {
+                     const size_t cluster = (slice * cluster_y + y) * cluster_x + x;
+                     if (sphere_touches_box(light, bounds[cluster]))
+                        cluster_lights[cluster].push_back(unsigned(i));
+                  }
+            }
+         }
+      });
+
+      // Compact the per cluster lists
+      grid.resize(cluster_count * 2);
+      size_t total = 0;
+      max_per_cluster = 0;
+      for (int cluster = 0; cluster < cluster_count; ++cluster)
+      {
+         grid[cluster * 2 + 0] = unsigned(total);
+         grid[cluster * 2 + 1] = unsigned(cluster_lights[cluster].size());
+         total += cluster_lights[cluster].size();
+         max_per_cluster = std::max(max_per_cluster, cluster_lights[cluster].size());
+      }
+
+      indices.resize(total);
+      parallel_for(cluster_count, [&](size_t begin, size_t end)
+      {
+         for (size_t cluster = begin; cluster < end; ++cluster)
+            std::copy(cluster_lights[cluster].begin(), cluster_lights[cluster].end(), indices.begin() + grid[cluster * 2]);
+      });
+   }
+
+   // Only move the lights to view space, for the naive path which doesn't read the clusters
+   void transform(const std::vector<Light>& lights, const Mat4& view)
+   {
+      view_lights.resize(lights.size());
+      parallel_for(lights.size(), [&](size_t begin, size_t end)
+      {
+         for (size_t i = begin; i < end; ++i)
+            to_view(lights[i], view, view_lights[i]);
+      });
+   }
+
+   const std::vector<GpuLight>& get_lights() const { return view_lights; }
+   const std::vector<unsigned>& get_grid() const { return grid; }
+   const std::vector<unsigned>& get_indices() const { return indices; }
+   size_t get_max_per_cluster() const { return max_per_cluster; }
+
+private:
+   struct ClusterRange
+   {
+      int x0, x1, y0, y1, z0, z1;
+   };
+
+   struct Box
+   {
+      float min[3], max[3];
+   };
+
+   static void to_view(const Light& light, const Mat4& view, GpuLight& out)
+   {
+      for (int row = 0; row < 3; ++row)
+      {
+         out.position[row] = view.m[row] * light.position[0] + view.m[4 + row] * light.position[1]
+            + view.m[8 + row] * light.position[2] + view.m[12 + row];
+         out.direction[row] = view.m[row] * light.direction[0] + view.m[4 + row] * light.direction[1]
+            + view.m[8 + row] * light.direction[2];
+      }
+      std::copy(light.color, light.color + 3, out.color);
+      out.radius = light.radius;
+      out.cos_outer = light.cos_outer;
+      out.padding = 0.f;
+   }
+
+   static bool sphere_touches_box(const GpuLight& light, const Box& box)
+   {
+      float distance = 0.f;
+      for (int axis = 0; axis < 3; ++axis)
+      {
+         const float nearest = std::clamp(light.position[axis], box.min[axis], box.max[axis]);
+         distance += (light.position[axis] - nearest) * (light.position[axis] - nearest);
+      }
+      return distance <= light.radius * light.radius;
+   }
+
+   // View space box around every cluster
+   void compute_bounds(float fov_y, float aspect)
+   {
+      bounds.resize(cluster_count);
+      const float tan_y = std::tan(fov_y * .5f), tan_x = tan_y * aspect;
+      for (int z = 0; z < cluster_z; ++z)
+      {
+         const float depth_near = near_plane * std::pow(far_plane / near_plane, float(z) / cluster_z);
+         const float depth_far = near_plane * std::pow(far_plane / near_plane, float(z + 1) / cluster_z);
+         for (int y = 0; y < cluster_y; ++y)
+            for (int x = 0; x < cluster_x; ++x)
+            {
+               const float ndc_x[2] { -1.f + 2.f * x / cluster_x, -1.f + 2.f * (x + 1) / cluster_x };
+               const float ndc_y[2] { -1.f + 2.f * y / cluster_y, -1.f + 2.f * (y + 1) / cluster_y };
+               Box& box = bounds[(z * cluster_y + y) * cluster_x + x];
+               box = { { 1e30f, 1e30f, -depth_far }, { -1e30f, -1e30f, -depth_near } };
+               for (float depth : { depth_near, depth_far })
+                  for (int i = 0; i < 2; ++i)
+                  {
+                     box.min[0] = std::min(box.min[0], ndc_x[i] * depth * tan_x);
+                     box.max[0] = std::max(box.max[0], ndc_x[i] * depth * tan_x);
+                     box.min[1] = std::min(box.min[1], ndc_y[i] * depth * tan_y);
+                     box.max[1] = std::max(box.max[1], ndc_y[i] * depth * tan_y);
+                  }
+            }
+      }
+   }
+
+   std::vector<std::vector<unsigned>> cluster_lights;
+   std::vector<Box> bounds;
+   float bounds_aspect = 0.f;
+   std::vector<GpuLight> view_lights;
+   std::vector<ClusterRange> ranges;
+   std::vector<unsigned> grid;
+   std::vector<unsigned> indices;
+   size_t max_per_cluster = 0;
+};
+
+// Texture buffer with its storage, orphaned and refilled every frame
+struct TextureBuffer
+{
+   unsigned buffer = 0, texture = 0;
+   size_t capacity = 0;
+
+   void create(GLenum format)
+   {
+      glGenBuffers(1, &buffer);
+      glGenTextures(1, &texture);
+      glBindBuffer(GL_TEXTURE_BUFFER, buffer);
+      glBufferData(GL_TEXTURE_BUFFER, 16, nullptr, GL_STREAM_DRAW);
+      glBindTexture(GL_TEXTURE_BUFFER, texture);
+      glTexBuffer(GL_TEXTURE_BUFFER, format, buffer);
+      glBindBuffer(GL_TEXTURE_BUFFER, 0);
+   }
+
+   void upload(const void* data, size_t bytes)
+   {
+      glBindBuffer(GL_TEXTURE_BUFFER, buffer);
+      if (bytes > capacity)
+         capacity = bytes + bytes / 2;
+
+      // Orphan the old storage so the upload doesn't wait for last frame's draw
+      glBufferData(GL_TEXTURE_BUFFER, capacity, nullptr, GL_STREAM_DRAW);
+      if (bytes)
+         glBufferSubData(GL_TEXTURE_BUFFER, 0, bytes, data);
+      glBindBuffer(GL_TEXTURE_BUFFER, 0);
+   }
+
+   void destroy()
+   {
+      glDeleteTextures(1, &texture);
+      glDeleteBuffers(1, &buffer);
+   }
+};
+
+// Lights scattered over the floor, a fifth of them spot lights pointing down
+std::vector<Light> make_lights(size_t count, unsigned seed)
+{
+   std::mt19937 random(seed);
+   std::uniform_real_distribution<float> spread(-40.f, 40.f), height(.3f, 3.f), radius(.6f, 1.6f), hue(0.f, 6.2831853f);
+
+   std::vector<Light> lights(count);
+   for (Light& light : lights)
+   {
+      light.position[0] = spread(random);
+      light.position[1] = height(random);
+      light.position[2] = spread(random);
+      light.radius = radius(random);
+
+      const float h = hue(random);
+      light.color[0] = .5f + .5f * std::cos(h);
+      light.color[1] = .5f + .5f * std::cos(h + 2.1f);
+      light.color[2] = .5f + .5f * std::cos(h + 4.2f);
+
+      const bool spot = random() % 5 == 0;
+      light.cos_outer = spot ? .7f : -2.f;
+      light.direction[0] = 0.f;
+      light.direction[1] = -1.f;
+      light.direction[2] = 0.f;
+      light.orbit = hue(random);
+   }
+   return lights;
+}
+
+// Main function
+int main()
+{
+   // Vertex shader, the floor or a grid of pillars, everything is shaded in view space
+   const char* vertex_shader_source =
+      "#version 330 core\n"
+      "layout (location = 0) in vec3 aPos;\n"
+      "layout (location = 1) in vec3 aNormal;\n"
+      "uniform mat4 view;\n"
+      "uniform mat4 projection;\n"
+      "uniform bool pillars;\n"
+      "out vec3 Position;\n"
+      "out vec3 Normal;\n"
+      "void main()\n"
+      "{\n"
+      "   vec3 world = pillars ? aPos * vec3(1.0, 3.0, 1.0) + vec3((gl_InstanceID % 10 - 4.5) * 8.0, 1.5, (gl_InstanceID / 10 - 4.5) * 8.0)\n"
+      "                        : aPos * vec3(45.0, 0.0, 45.0);\n"
+      "   vec4 position = view * vec4(world, 1.0);\n"
+      "   Position = position.xyz;\n"
+      "   Normal = mat3(view) * aNormal;\n"
+      "   gl_Position = projection * position;\n"
+      "}\0";
+
+   // Fragment shader, only the lights of the fragment's cluster, or every light when naive is set
+   const char* fragment_shader_source =
+      "#version 330 core\n"
+      "in vec3 Position;\n"
+      "in vec3 Normal;\n"
+      "uniform samplerBuffer lights;\n"
+      "uniform usamplerBuffer grid;\n"
+      "uniform usamplerBuffer indices;\n"
+      "uniform bool naive;\n"
+      "uniform int light_count;\n"
+      "uniform vec2 screen_size;\n"
+      "uniform float near_plane;\n"
+      "uniform float slice_scale;\n"
+      "uniform ivec3 clusters;\n"
+      "out vec4 FragColor;\n"
+      "vec3 shade(int light, vec3 N)\n"
+      "{\n"
+      "   vec4 a = texelFetch(lights, light * 3);\n"
+      "   vec3 L = a.xyz - Position;\n"
+      "   float distance = length(L);\n"
+      "   if (distance >= a.w)\n"
+      "      return vec3(0.0);\n"
+      "   vec4 b = texelFetch(lights, light * 3 + 1);\n"
+      "   L /= distance;\n"
+      "   float attenuation = 1.0 - distance / a.w;\n"
+      "   attenuation *= attenuation;\n"
+      "   if (b.w > -1.5)\n"
+      "      attenuation *= smoothstep(b.w, b.w + 0.1, dot(-L, texelFetch(lights, light * 3 + 2).xyz));\n"
+      "   return b.rgb * max(dot(N, L), 0.0) * attenuation;\n"
+      "}\n"
+      "void main()\n"
+      "{\n"
+      "   vec3 N = normalize(Normal);\n"
+      "   vec3 color = vec3(0.03);\n"
+      "   if (naive)\n"
+      "   {\n"
+      "      for (int i = 0; i < light_count; ++i)\n"
+      "         color += shade(i, N);\n"
+      "   }\n"
+      "   else\n"
+      "   {\n"
+      "      ivec2 tile = ivec2(gl_FragCoord.xy / screen_size * vec2(clusters.xy));\n"
+      "      int slice = clamp(int(log(-Position.z / near_plane) * slice_scale), 0, clusters.z - 1);\n"
+      "      uvec2 cluster = texelFetch(grid, (slice * clusters.y + tile.y) * clusters.x + tile.x).rg;\n"
+      "      for (uint i = 0u; i < cluster.y; ++i)\n"
+      "         color += shade(int(texelFetch(indices, int(cluster.x + i)).r), N);\n"
+      "   }\n"
+      "   FragColor = vec4(color, 1.0f);\n"
+      "}\0";
+
+   // Initialize GLFW and tell it the version and profile
+   glfwInit();
+   glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
+   glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
+   glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+
+   // Initialize the window
+   GLFWwindow* window = glfwCreateWindow(800, 600, "Clustered lighting.", nullptr, nullptr);
+   if (!window)
+      throw_ex("Failed to create the window!");
+
+   // Set the current window
+   glfwMakeContextCurrent(window);
+
+   // Initialize GLAD
+   if (!gladLoadGLLoader(GLADloadproc(glfwGetProcAddress)))
+      throw_ex("Failed to initialize GLAD!");
+
+   // Set the viewport
+   glViewport(0, 0, 800, 600);
+
+   // Set window resize callback
+   glfwSetFramebufferSizeCallback(window, framebuffer_size_callback);
+
+   // Create the shader program
+   unsigned shader_program = link_program(vertex_shader_source, fragment_shader_source);
+   const int view_location = glGetUniformLocation(shader_program, "view");
+   const int projection_location = glGetUniformLocation(shader_program, "projection");
+   const int pillars_location = glGetUniformLocation(shader_program, "pillars");
+   const int naive_location = glGetUniformLocation(shader_program, "naive");
+   const int light_count_location = glGetUniformLocation(shader_program, "light_count");
+   const int screen_size_location = glGetUniformLocation(shader_program, "screen_size");
+
+   // Samplers and cluster constants never change
+   glUseProgram(shader_program);
+   glUniform1i(glGetUniformLocation(shader_program, "lights"), 0);
+   glUniform1i(glGetUniformLocation(shader_program, "grid"), 1);
+   glUniform1i(glGetUniformLocation(shader_program, "indices"), 2);
+   glUniform1f(glGetUniformLocation(shader_program, "near_plane"), near_plane);
+   glUniform1f(glGetUniformLocation(shader_program, "slice_scale"), cluster_z / std::log(far_plane / near_plane));
+   glUniform3i(glGetUniformLocation(shader_program, "clusters"), cluster_x, cluster_y, cluster_z);
+
+   // Unit cube with normals, followed by the floor quad
+   float vertices[]
+   {
+      // Back face
+      -.5f, -.5f, -.5f,  0.f,  0.f, -1.f,   .5f,  .5f, -.5f,  0.f,  0.f, -1.f,   .5f, -.5f, -.5f,  0.f,  0.f, -1.f,
+       .5f,  .5f, -.5f,  0.f,  0.f, -1.f,  -.5f, -.5f, -.5f,  0.f,  0.f, -1.f,  -.5f,  .5f, -.5f,  0.f,  0.f, -1.f,
+      // Front face
+      -.5f, -.5f,  .5f,  0.f,  0.f,  1.f,   .5f, -.5f,  .5f,  0.f,  0.f,  1.f,   .5f,  .5f,  .5f,  0.f,  0.f,  1.f,
+       .5f,  .5f,  .5f,  0.f,  0.f,  1.f,  -.5f,  .5f,  .5f,  0.f,  0.f,  1.f,  -.5f, -.5f,  .5f,  0.f,  0.f,  1.f,
+      // Left face
+      -.5f,  .5f,  .5f, -1.f,  0.f,  0.f,  -.5f,  .5f, -.5f, -1.f,  0.f,  0.f,  -.5f, -.5f, -.5f, -1.f,  0.f,  0.f,
+      -.5f, -.5f, -.5f, -1.f,  0.f,  0.f,  -.5f, -.5f,  .5f, -1.f,  0.f,  0.f,  -.5f,  .5f,  .5f, -1.f,  0.f,  0.f,
+      // Right face
+       .5f,  .5f,  .5f,  1.f,  0.f,  0.f,   .5f, -.5f, -.5f,  1.f,  0.f,  0.f,   .5f,  .5f, -.5f,  1.f,  0.f,  0.f,
+       .5f, -.5f, -.5f,  1.f,  0.f,  0.f,   .5f,  .5f,  .5f,  1.f,  0.f,  0.f,   .5f, -.5f,  .5f,  1.f,  0.f,  0.f,
+      // Top face
+      -.5f,  .5f, -.5f,  0.f,  1.f,  0.f,   .5f,  .5f,  .5f,  0.f,  1.f,  0.f,   .5f,  .5f, -.5f,  0.f,  1.f,  0.f,
+       .5f,  .5f,  .5f,  0.f,  1.f,  0.f,  -.5f,  .5f, -.5f,  0.f,  1.f,  0.f,  -.5f,  .5f,  .5f,  0.f,  1.f,  0.f,
+      // Floor
+      -1.f,  0.f, -1.f,  0.f,  1.f,  0.f,  -1.f,  0.f,  1.f,  0.f,  1.f,  0.f,   1.f,  0.f,  1.f,  0.f,  1.f,  0.f,
+       1.f,  0.f,  1.f,  0.f,  1.f,  0.f,   1.f,  0.f, -1.f,  0.f,  1.f,  0.f,  -1.f,  0.f, -1.f,  0.f,  1.f,  0.f
+   };
+
+   // Create the buffer objects
+   unsigned VBO = 0;
+   glGenBuffers(1, &VBO);
+
+   unsigned VAO = 0;
+   glGenVertexArrays(1, &VAO);
+
+   // Initialize the VAO
+   glBindVertexArray(VAO);
+   glBindBuffer(GL_ARRAY_BUFFER, VBO);
+   glBufferData(GL_ARRAY_BUFFER, sizeof(vertices), vertices, GL_STATIC_DRAW);
+
+   // Link vertex attributes
+   glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 6 * sizeof(float), (void*)0);
+   glEnableVertexAttribArray(0);
+   glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, 6 * sizeof(float), (void*)(3 * sizeof(float)));
+   glEnableVertexAttribArray(1);
+
+   // Unbind VAO
+   glBindVertexArray(0);
+
+   // Light data and the cluster lists go through texture buffers
+   TextureBuffer light_buffer, grid_buffer, index_buffer;
+   light_buffer.create(GL_RGBA32F);
+   grid_buffer.create(GL_RG32UI);
+   index_buffer.create(GL_R32UI);
+
+   std::vector<Light> lights = make_lights(10000, 42);
+   LightClusters clusters;
+   std::vector<Light> frame_lights;
+   const float fov_y = .9f;
+   glEnable(GL_DEPTH_TEST);
+
+   // Bin, upload and draw one frame, returns the binning time in milliseconds
+   // The naive path only needs the lights in view space, so it neither bins nor pays for binning
+   auto render = [&](size_t light_count, bool naive, float time, int width, int height)
+   {
+      // Lights drift around their starting point
+      frame_lights.assign(lights.begin(), lights.begin() + light_count);
+      for (Light& light : frame_lights)
+      {
+         light.position[0] += std::cos(time + light.orbit) * 2.f;
+         light.position[2] += std::sin(time * .7f + light.orbit) * 2.f;
+      }
+
+      const Mat4 view = multiply(multiply(rotate_x(.6f), translate(0.f, -14.f, -30.f)), rotate_y(time * .05f));
+      const Mat4 projection = perspective(fov_y, float(width) / float(height), near_plane, far_plane);
+
+      const auto start = std::chrono::steady_clock::now();
+      if (naive)
+         clusters.transform(frame_lights, view);
+      else
+         clusters.build(frame_lights, view, fov_y, float(width) / float(height));
+      const std::chrono::duration<double, std::milli> binning = std::chrono::steady_clock::now() - start;
+
+      light_buffer.upload(clusters.get_lights().data(), light_count * sizeof(GpuLight));
+      if (!naive)
+      {
+         grid_buffer.upload(clusters.get_grid().data(), clusters.get_grid().size() * sizeof(unsigned));
+         index_buffer.upload(clusters.get_indices().data(), clusters.get_indices().size() * sizeof(unsigned));
+      }
+
+      // Render
+      glClearColor(.5f, .5f, .5f, 1.f);
+      glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+
+      glUseProgram(shader_program);
+      glUniformMatrix4fv(view_location, 1, GL_FALSE, view.m);
+      glUniformMatrix4fv(projection_location, 1, GL_FALSE, projection.m);
+      glUniform1i(naive_location, naive);
+      glUniform1i(light_count_location, int(light_count));
+      glUniform2f(screen_size_location, float(width), float(height));
+
+      glActiveTexture(GL_TEXTURE0);
+      glBindTexture(GL_TEXTURE_BUFFER, light_buffer.texture);
+      glActiveTexture(GL_TEXTURE1);
+      glBindTexture(GL_TEXTURE_BUFFER, grid_buffer.texture);
+      glActiveTexture(GL_TEXTURE2);
+      glBindTexture(GL_TEXTURE_BUFFER, index_buffer.texture);
+      glActiveTexture(GL_TEXTURE0);
+
+      glBindVertexArray(VAO);
+      glUniform1i(pillars_location, 0);
+      glDrawArrays(GL_TRIANGLES, 30, 6);
+      glUniform1i(pillars_location, 1);
+      glDrawArraysInstanced(GL_TRIANGLES, 0, 30, 100);
+      glBindVertexArray(0);
+      return binning.count();
+   };
+
+   // Benchmark both paths at the real framebuffer size, the naive one is a loop over every light in every fragment
+   // A full naive frame with 10k lights takes tens of seconds on a software rasterizer, so it is only shaded in
+   // a scissored tile of 1/64 of the screen and extrapolated, the cost is per fragment and the geometry is cheap
+   int bench_width = 0, bench_height = 0;
+   glfwGetFramebufferSize(window, &bench_width, &bench_height);
+   const int tile_divisions = 8;
+   auto begin_tile = [&]
+   {
+      glEnable(GL_SCISSOR_TEST);
+      glScissor(bench_width * 7 / 16, bench_height * 7 / 16, bench_width / tile_divisions, bench_height / tile_divisions);
+   };
+
+   // What the tile costs without any lights: uploads and geometry, which do not scale with the pixels
+   begin_tile();
+   render(0, true, 0.f, bench_width, bench_height);
+   glFinish();
+   const auto overhead_start = std::chrono::steady_clock::now();
+   render(0, true, 0.f, bench_width, bench_height);
+   glFinish();
+   const std::chrono::duration<double, std::milli> tile_overhead = std::chrono::steady_clock::now() - overhead_start;
+   glDisable(GL_SCISSOR_TEST);
+
+   double naive_ms_per_light = 0.0;
+   for (size_t light_count : { size_t(1000), size_t(10000) })
+      for (bool naive : { false, true })
+      {
+         if (naive)
+            begin_tile();
+         else
+         {
+            render(light_count, naive, 0.f, bench_width, bench_height);
+            glFinish();
+         }
+
+         const auto start = std::chrono::steady_clock::now();
+         const double binning = render(light_count, naive, 0.f, bench_width, bench_height);
+         glFinish();
+         std::chrono::duration<double, std::milli> frame = std::chrono::steady_clock::now() - start;
+         glDisable(GL_SCISSOR_TEST);
+
+         if (naive)
+         {
+            frame = (frame - tile_overhead) * double(tile_divisions * tile_divisions) + tile_overhead;
+            naive_ms_per_light = frame.count() / double(light_count);
+         }
+
+         std::cout << light_count << " lights, " << (naive ? "naive:     " : "clustered: ") << frame.count() << " ms/frame";
+         if (naive)
+            std::cout << " (estimated from a 1/" << tile_divisions * tile_divisions << " tile)";
+         else
+            std::cout << " (" << binning << " ms binning, " << clusters.get_indices().size() << " light references, at most "
+                      << clusters.get_max_per_cluster() << " per cluster)";
+         std::cout << '\n';
+      }
+
+   // N switches to the naive loop, over as many lights as fit about 100 ms a frame so the window stays responsive
+   const size_t naive_light_count = std::min(lights.size(), std::max(size_t(16), size_t(100.0 / std::max(naive_ms_per_light, 1e-6))));
+   bool naive = false, n_down = false;
+   double stats_time = glfwGetTime(), binning_ms = 0.0;
+   int frames = 0;
+
+   // Create the render loop
+   while (!glfwWindowShouldClose(window))
+   {
+      // Check if the window should close
+      if (glfwGetKey(window, GLFW_KEY_ESCAPE) == GLFW_PRESS)
+         glfwSetWindowShouldClose(window, true);
+
+      const bool n_pressed = glfwGetKey(window, GLFW_KEY_N) == GLFW_PRESS;
+      if (n_pressed && !n_down)
+         naive = !naive;
+      n_down = n_pressed;
+
+      // Nothing to render while minimized, the framebuffer is 0x0
+      int width = 0, height = 0;
+      glfwGetFramebufferSize(window, &width, &height);
+      if (width == 0 || height == 0)
+      {
+         glfwWaitEvents();
+         continue;
+      }
+
+      const size_t light_count = naive ? naive_light_count : lights.size();
+      binning_ms += render(light_count, naive, float(glfwGetTime()), width, height);
+
+      // Print the frame time once a second
+      ++frames;
+      const double now = glfwGetTime();
+      if (now - stats_time >= 1.0)
+      {
+         // The naive figure is for fewer lights, it says so rather than sit next to the clustered one as if comparable
+         if (naive)
+            std::cout << "Naive: " << (now - stats_time) * 1000.0 / frames << " ms/frame with only " << light_count << " of "
+                      << lights.size() << " lights, reduced to stay responsive, see the benchmark for the same load\n";
+         else
+            std::cout << "Clustered: " << (now - stats_time) * 1000.0 / frames << " ms/frame, " << binning_ms / frames
+                      << " ms binning " << light_count << " lights\n";
+         stats_time = now;
+         binning_ms = 0.0;
+         frames = 0;
+      }
+
+      // Swap buffers and check and call events
+      glfwSwapBuffers(window);
+      glfwPollEvents();
+   }
+
+   // Clean up
+   light_buffer.destroy();
+   grid_buffer.destroy();
+   index_buffer.destroy();
+   glDeleteVertexArrays(1, &VAO);
+   glDeleteBuffers(1, &VBO);
+   glDeleteProgram(shader_program);
+   glfwTerminate();
+   return 0;
+}
@@ -0,0 +1,376 @@
+#include <glad/glad.h>
+#include <GLFW/glfw3.h>
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <iostream>
+
+// Throw an exception and terminate GLFW
+void throw_ex(const char* msg)
+{
+   std::cout << msg << '\n';
+   glfwTerminate();
+   std::exit(-1);
+}
+
+// Resize callback function
+void framebuffer_size_callback(GLFWwindow*, int width, int height)
+{
+   // A minimized window has a 0x0 framebuffer, the render loop waits until it is restored
+   if (width == 0 || height == 0)
+      return;
+   glViewport(0, 0, width, height);
+}
+
+// Compile a shader and print the info log if it fails
+unsigned compile_shader(GLenum type, const char* source)
+{
+   unsigned shader = glCreateShader(type);
+   glShaderSource(shader, 1, &source, nullptr);
+   glCompileShader(shader);
+
+   int success = 0;
+   char info_log[512] = "\0";
+   glGetShaderiv(shader, GL_COMPILE_STATUS, &success);
+
+   if (!success)
+   {
+      glGetShaderInfoLog(shader, sizeof(info_log), nullptr, info_log);
+      std::cout << "Failed to compile the shader: " << info_log;
+   }
+   return shader;
+}
+
+// Link a vertex and a fragment shader into a program and clean up the shaders
+unsigned link_program(const char* vertex_source, const char* fragment_source)
+{
+   unsigned vertex_shader = compile_shader(GL_VERTEX_SHADER, vertex_source);
+   unsigned fragment_shader = compile_shader(GL_FRAGMENT_SHADER, fragment_source);
+
+   unsigned program = glCreateProgram();
+   glAttachShader(program, vertex_shader);
+   glAttachShader(program, fragment_shader);
+   glLinkProgram(program);
+
+   int success = 0;
+   char info_log[512] = "\0";
+   glGetProgramiv(program, GL_LINK_STATUS, &success);
+
+   if (!success)
+   {
+      glGetProgramInfoLog(program, sizeof(info_log), nullptr, info_log);
+      std::cout << "Failed to link the shader program: " << info_log;
+   }
+
+   glDeleteShader(vertex_shader);
+   glDeleteShader(fragment_shader);
+   return program;
+}
+
+// GL_TIME_ELAPSED queries in a ring, results are read a few frames late so reading never stalls
+class GpuTimer
+{
+public:
+   static constexpr int ring_size = 4;
+
+   GpuTimer() { glGenQueries(ring_size, queries); }
+   ~GpuTimer() { glDeleteQueries(ring_size, queries); }
+
+   GpuTimer(const GpuTimer&) = delete;
+   GpuTimer& operator=(const GpuTimer&) = delete;
+
+   // Skips the frame if the query it would reuse is still waiting for its result
+   void begin()
+   {
+      timing = !pending[next];
+      if (timing)
+         glBeginQuery(GL_TIME_ELAPSED, queries[next]);
+   }
+
+   void end()
+   {
+      if (!timing)
+         return;
+
+      glEndQuery(GL_TIME_ELAPSED);
+      pending[next] = true;
+      next = (next + 1) % ring_size;
+   }
+
+   // Oldest finished measurement in milliseconds, or a negative value if none is ready yet
+   double poll()
+   {
+      for (int i = 0; i < ring_size; ++i)
+      {
+         const int index = (next + i) % ring_size;
+         if (!pending[index])
+            continue;
+
+         int available = 0;
+         glGetQueryObjectiv(queries[index], GL_QUERY_RESULT_AVAILABLE, &available);
+         if (!available)
+            return -1.0;
+
+         GLuint64 nanoseconds = 0;
+         glGetQueryObjectui64v(queries[index], GL_QUERY_RESULT, &nanoseconds);
+         pending[index] = false;
+
+         // llvmpipe returns garbage for the very first query, nothing real takes a second
+         return nanoseconds < 1000000000ull ? nanoseconds / 1e6 : -1.0;
+      }
+      return -1.0;
+   }
+
+private:
+   unsigned queries[ring_size] {};
+   bool pending[ring_size] {};
+   int next = 0;
+   bool timing = false;
+};
+
+// Picks the render scale that holds the GPU time of the scene near the target
+// Cost is taken to follow the pixel count, so the scale moves by the square root of the time ratio,
+// only every few measurements, damped, and not at all within a small dead band to avoid flicker
+class ResolutionController
+{
+public:
+   ResolutionController(double target_ms, float min_scale, float max_scale)
+      : target_ms(target_ms), min_scale(min_scale), max_scale(max_scale) {}
+
+   void add_sample(double gpu_ms)
+   {
+      total_ms += gpu_ms;
+      if (++samples < samples_per_update)
+         return;
+
+      const double average = total_ms / samples;
+      total_ms = 0.0;
+      samples = 0;
+
+      const double ratio = target_ms / average;
+      if (ratio > .95 && ratio < 1.05)
+         return;
+
+      const float wanted = scale * float(std::sqrt(ratio));
+      scale = std::clamp(scale + (wanted - scale) * .7f, min_scale, max_scale);
+   }
+
+   float get_scale() const { return scale; }
+
+private:
+   static constexpr int samples_per_update = 4;
+   double target_ms;
+   float min_scale, max_scale;
+   float scale = 1.f;
+   double total_ms = 0.0;
+   int samples = 0;
+};
+
+// Main function
+int main(int argc, char** argv)
+{
+   // Full screen triangle
+   const char* vertex_shader_source =
+      "#version 330 core\n"
+      "out vec2 TexCoord;\n"
+      "void main()\n"
+      "{\n"
+      "   TexCoord = vec2((gl_VertexID << 1) & 2, gl_VertexID & 2);\n"
+      "   gl_Position = vec4(TexCoord * 2.0 - 1.0, 0.0, 1.0);\n"
+      "}\0";
+
+   // Fill heavy plasma, every instance is another blended layer over the whole target
+   const char* fragment_shader_source =
+      "#version 330 core\n"
+      "in vec2 TexCoord;\n"
+      "uniform float time;\n"
+      "uniform int layer;\n"
+      "out vec4 FragColor;\n"
+      "void main()\n"
+      "{\n"
+      "   vec2 p = TexCoord * 6.0 + float(layer) * 1.3;\n"
+      "   float v = 0.0;\n"
+      "   for (int i = 1; i <= 6; ++i)\n"
+      "      v += sin(p.x * float(i) + time) * cos(p.y * float(i) - time * 0.7) / float(i);\n"
+      "   vec3 color = 0.5 + 0.5 * cos(vec3(0.0, 2.1, 4.2) + v * 3.0 + float(layer));\n"
+      "   FragColor = vec4(color, 0.3);\n"
+      "}\0";
+
+   // Initialize GLFW and tell it the version and profile
+   glfwInit();
+   glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
+   glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
+   glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+
+   // Initialize the window
+   GLFWwindow* window = glfwCreateWindow(800, 600, "Dynamic resolution.", nullptr, nullptr);
+   if (!window)
+      throw_ex("Failed to create the window!");
+
+   // Set the current window
+   glfwMakeContextCurrent(window);
+
+   // Initialize GLAD
+   if (!gladLoadGLLoader(GLADloadproc(glfwGetProcAddress)))
+      throw_ex("Failed to initialize GLAD!");
+
+   // Set the viewport
+   glViewport(0, 0, 800, 600);
+
+   // Set window resize callback
+   glfwSetFramebufferSizeCallback(window, framebuffer_size_callback);
+
+   // The controller is fed the GPU time of the scene. Software rasterizers like llvmpipe rasterize after the
+   // query has ended, so their timer queries only cover command submission and the frame time is what shows
+   // their fill cost, --frame-time forces that fallback on any driver
+   const char* renderer = reinterpret_cast<const char*>(glGetString(GL_RENDERER));
+   const bool software = renderer && (std::strstr(renderer, "llvmpipe") || std::strstr(renderer, "softpipe") || std::strstr(renderer, "SwiftShader"));
+   const bool use_frame_time = software || (argc > 1 && std::strcmp(argv[1], "--frame-time") == 0);
+   std::cout << "Controller input: " << (use_frame_time ? "frame time" : "GPU time") << " (" << (renderer ? renderer : "?") << ")\n";
+
+   // Create the shader program
+   unsigned shader_program = link_program(vertex_shader_source, fragment_shader_source);
+   const int time_location = glGetUniformLocation(shader_program, "time");
+   const int layer_location = glGetUniformLocation(shader_program, "layer");
+
+   // The full screen triangle has no vertex input but core profile still wants a VAO
+   unsigned VAO = 0;
+   glGenVertexArrays(1, &VAO);
+
+   // Offscreen target at the window size, the scene only uses the scaled corner of it so changing
+   // the scale never reallocates, only a window resize does
+   unsigned FBO = 0, color_texture = 0;
+   glGenFramebuffers(1, &FBO);
+   glGenTextures(1, &color_texture);
+   int target_width = 0, target_height = 0;
+
+   // The scope makes sure the timer queries are deleted before glfwTerminate
+   {
+      GpuTimer timer;
+      ResolutionController controller(33.3, .25f, 1.f);
+
+      // D toggles the controller, +/- change the number of layers
+      bool dynamic = true, d_down = false, plus_down = false, minus_down = false;
+      int layers = 8;
+      double stats_time = glfwGetTime(), last_frame = stats_time, gpu_ms = 0.0;
+      int frames = 0, measured = 0;
+
+      // Create the render loop
+      while (!glfwWindowShouldClose(window))
+      {
+         // Check if the window should close
+         if (glfwGetKey(window, GLFW_KEY_ESCAPE) == GLFW_PRESS)
+            glfwSetWindowShouldClose(window, true);
+
+         const bool d_pressed = glfwGetKey(window, GLFW_KEY_D) == GLFW_PRESS;
+         if (d_pressed && !d_down)
+            dynamic = !dynamic;
+         d_down = d_pressed;
+
+         const bool plus_pressed = glfwGetKey(window, GLFW_KEY_EQUAL) == GLFW_PRESS;
+         if (plus_pressed && !plus_down)
+            layers *= 2;
+         plus_down = plus_pressed;
+
+         const bool minus_pressed = glfwGetKey(window, GLFW_KEY_MINUS) == GLFW_PRESS;
+         if (minus_pressed && !minus_down)
+            layers = std::max(1, layers / 2);
+         minus_down = minus_pressed;
+
+         // Nothing to render while minimized, wait for the window to come back without counting the wait as a frame
+         int width = 0, height = 0;
+         glfwGetFramebufferSize(window, &width, &height);
+         if (width == 0 || height == 0)
+         {
+            glfwWaitEvents();
+            last_frame = glfwGetTime();
+            continue;
+         }
+
+         // Reallocate the target only when the window size has changed
+         if (width != target_width || height != target_height)
+         {
+            target_width = width;
+            target_height = height;
+            glBindTexture(GL_TEXTURE_2D, color_texture);
+            glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, width, height, 0, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+            glBindFramebuffer(GL_FRAMEBUFFER, FBO);
+            glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, color_texture, 0);
+            if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
+               throw_ex("Failed to create the offscreen target!");
+         }
+
+         const double frame_start = glfwGetTime();
+         const double frame_ms = (frame_start - last_frame) * 1000.0;
+         last_frame = frame_start;
+
+         // Feed the controller with whatever measurement has come back
+         const double measurement = timer.poll();
+         if (measurement >= 0.0)
+         {
+            if (dynamic)
+               controller.add_sample(use_frame_time ? std::max(measurement, frame_ms) : measurement);
+            gpu_ms += measurement;
+            ++measured;
+         }
+
+         const float scale = dynamic ? controller.get_scale() : 1.f;
+         const int render_width = std::max(1, int(width * scale)), render_height = std::max(1, int(height * scale));
+
+         // Render the scene into the scaled corner of the target, timed
+         timer.begin();
+         glBindFramebuffer(GL_FRAMEBUFFER, FBO);
+         glViewport(0, 0, render_width, render_height);
+         glClearColor(.5f, .5f, .5f, 1.f);
+         glClear(GL_COLOR_BUFFER_BIT);
+
+         glEnable(GL_BLEND);
+         glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+         glUseProgram(shader_program);
+         glUniform1f(time_location, float(glfwGetTime()));
+         glBindVertexArray(VAO);
+         for (int layer = 0; layer < layers; ++layer)
+         {
+            glUniform1i(layer_location, layer);
+            glDrawArrays(GL_TRIANGLES, 0, 3);
+         }
+         glBindVertexArray(0);
+         glDisable(GL_BLEND);
+         timer.end();
+
+         // Upscale to the window
+         glBindFramebuffer(GL_READ_FRAMEBUFFER, FBO);
+         glBindFramebuffer(GL_DRAW_FRAMEBUFFER, 0);
+         glBlitFramebuffer(0, 0, render_width, render_height, 0, 0, width, height, GL_COLOR_BUFFER_BIT, GL_LINEAR);
+         glBindFramebuffer(GL_FRAMEBUFFER, 0);
+         glViewport(0, 0, width, height);
+
+         // Print the scale and timings once a second
+         ++frames;
+         const double now = glfwGetTime();
+         if (now - stats_time >= 1.0)
+         {
+            std::cout << (dynamic ? "Dynamic: " : "Fixed: ") << layers << " layers at " << render_width << 'x' << render_height
+                      << " (" << scale * 100.f << "%), " << (measured ? gpu_ms / measured : 0.0) << " ms GPU, "
+                      << (now - stats_time) * 1000.0 / frames << " ms/frame\n";
+            stats_time = now;
+            gpu_ms = 0.0;
+            frames = measured = 0;
+         }
+
+         // Swap buffers and check and call events
+         glfwSwapBuffers(window);
+         glfwPollEvents();
+      }
+   }
+
+   // Clean up
+   glDeleteFramebuffers(1, &FBO);
+   glDeleteTextures(1, &color_texture);
+   glDeleteVertexArrays(1, &VAO);
+   glDeleteProgram(shader_program);
+   glfwTerminate();
+   return 0;
+}
@@ -0,0 +1,173 @@
+#pragma once
+#include <algorithm>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+// Bump allocators for data that only lives for a frame or a scope
+// Nothing is freed one allocation at a time, the whole arena is reset at once. If an arena runs out it
+// takes an overflow block from the heap, and on the next reset it grows its main block to the peak it saw,
+// so after a few warm-up frames the render loop doesn't touch the heap at all.
+
+class LinearArena
+{
+public:
+   explicit LinearArena(size_t capacity) : block(new char[capacity]), size(capacity) {}
+
+   LinearArena(const LinearArena&) = delete;
+   LinearArena& operator=(const LinearArena&) = delete;
+
+   void* allocate(size_t bytes, size_t alignment = alignof(std::max_align_t))
+   {
+      const std::uintptr_t base = reinterpret_cast<std::uintptr_t>(block.get());
+      const std::uintptr_t aligned = (base + offset + alignment - 1) & ~std::uintptr_t(alignment - 1);
+
+      if (aligned + bytes <= base + size)
+      {
+         offset = aligned + bytes - base;
+         return reinterpret_cast<void*>(aligned);
+      }
+
+      // Out of room, take a block from the heap until the next reset
+      overflow.emplace_back(new char[bytes + alignment]);
+      overflow_bytes += bytes + alignment;
+      const std::uintptr_t overflow_base = reinterpret_cast<std::uintptr_t>(overflow.back().get());
+      return reinterpret_cast<void*>((overflow_base + alignment - 1) & ~std::uintptr_t(alignment - 1));
+   }
+
+   // Everything allocated so far becomes invalid
+   void reset()
+   {
+      peak = std::max(peak, offset + overflow_bytes);
+      if (!overflow.empty())
+      {
+         overflow.clear();
+         overflow_bytes = 0;
+         size = peak + peak / 2;
+         block.reset(new char[size]);
+      }
+      offset = 0;
+   }
+
+   // Rewind to an earlier mark, overflow blocks are kept until the next reset
+   size_t mark() const { return offset; }
+
+   void rewind(size_t marker)
+   {
+      assert(marker <= offset);
+      offset = marker;
+   }
+
+   size_t capacity() const { return size; }
+   size_t high_water() const { return std::max(peak, offset + overflow_bytes); }
+
+private:
+   std::unique_ptr<char[]> block;
+   size_t size;
+   size_t offset = 0;
+   std::vector<std::unique_ptr<char[]>> overflow;
+   size_t overflow_bytes = 0;
+   size_t peak = 0;
+};
+
+// One arena per frame in flight
+// Memory from begin_frame stays valid until the same slot comes around again, so it can be used for
+// staging that the GPU reads frames_in_flight - 1 frames later as long as the frames are fenced
+class FrameArena
+{
+public:
+   FrameArena(unsigned frames_in_flight, size_t capacity)
+   {
+      for (unsigned i = 0; i < frames_in_flight; ++i)
+         arenas.push_back(std::make_unique<LinearArena>(capacity));
+      current = arenas.front().get();
+   }
+
+   LinearArena& begin_frame(std::uint64_t frame)
+   {
+      current = arenas[frame % arenas.size()].get();
+      current->reset();
+      return *current;
+   }
+
+   LinearArena& get() { return *current; }
+
+   size_t high_water() const
+   {
+      size_t water = 0;
+      for (const std::unique_ptr<LinearArena>& arena : arenas)
+         water = std::max(water, arena->high_water());
+      return water;
+   }
+
+private:
+   std::vector<std::unique_ptr<LinearArena>> arenas;
+   LinearArena* current;
+};
+
+// Scratch arena of the calling thread, for temporaries inside a ScratchScope
+inline LinearArena& scratch_arena()
+{
+   thread_local LinearArena arena(64 * 1024);
+   return arena;
+}
+
+// Gives back everything allocated from the thread's scratch arena during its lifetime
+class ScratchScope
+{
+public:
+   ScratchScope() : arena(scratch_arena()), marker(arena.mark()) { ++depth(); }
+   ~ScratchScope()
+   {
+      // Only the outermost scope resets, which also folds any overflow into the main block. A mark of 0 does
+      // not prove a scope is outermost, overflow allocations don't move the mark, so the nesting is counted.
+      if (--depth() == 0)
+         arena.reset();
+      else
+         arena.rewind(marker);
+   }
+
+   ScratchScope(const ScratchScope&) = delete;
+   ScratchScope& operator=(const ScratchScope&) = delete;
+
+   LinearArena& get() { return arena; }
+
+private:
+   // Open scopes on the calling thread
+   static int& depth()
+   {
+      thread_local int scopes = 0;
+      return scopes;
+   }
+
+   LinearArena& arena;
+   size_t marker;
+};
+
+// STL allocator on top of an arena, deallocate does nothing
+template <typename T>
+struct ArenaAllocator
+{
+   using value_type = T;
+
+   explicit ArenaAllocator(LinearArena& arena) noexcept : arena(&arena) {}
+
+   template <typename U>
+   ArenaAllocator(const ArenaAllocator<U>& other) noexcept : arena(other.arena) {}
+
+   T* allocate(size_t count) { return static_cast<T*>(arena->allocate(count * sizeof(T), alignof(T))); }
+   void deallocate(T*, size_t) noexcept {}
+
+   LinearArena* arena;
+};
+
+template <typename T, typename U>
+bool operator==(const ArenaAllocator<T>& a, const ArenaAllocator<U>& b) { return a.arena == b.arena; }
+
+template <typename T, typename U>
+bool operator!=(const ArenaAllocator<T>& a, const ArenaAllocator<U>& b) { return a.arena != b.arena; }
+
+template <typename T>
+using ArenaVector = std::vector<T, ArenaAllocator<T>>;
@@ -0,0 +1,443 @@
+#include <glad/glad.h>
+#include <GLFW/glfw3.h>
+#include <algorithm>
+#include <atomic>
+#include <cassert>
+#include <cmath>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdlib>
+#include <iostream>
+#include <mutex>
+#include <new>
+#include <thread>
+#include <vector>
+#include "frame_arena.h"
+
+// Count every C++ heap allocation, the render loop should get to zero once warmed up
+std::atomic<size_t> allocation_count(0);
+
+// The replacements go through this pair rather than malloc and free directly, once those are inlined
+// into new and delete GCC sees malloc'd memory reach operator delete and warns about a mismatch
+[[gnu::noinline]] void* counted_allocate(std::size_t size)
+{
+   allocation_count.fetch_add(1, std::memory_order_relaxed);
+   return std::malloc(size ? size : 1);
+}
+
+[[gnu::noinline]] void counted_free(void* p)
+{
+   std::free(p);
+}
+
+void* operator new(std::size_t size)
+{
+   if (void* p = counted_allocate(size))
+      return p;
+   throw std::bad_alloc();
+}
+
+void operator delete(void* p) noexcept
+{
+   counted_free(p);
+}
+
+void operator delete(void* p, std::size_t) noexcept
+{
+   counted_free(p);
+}
+
+// Throw an exception and terminate GLFW
+void throw_ex(const char* msg)
+{
+   std::cout << msg << '\n';
+   glfwTerminate();
+   std::exit(-1);
+}
+
+// Resize callback function
+void framebuffer_size_callback(GLFWwindow*, int width, int height)
+{
+   assert(width > 0 && height > 0);
+   glViewport(0, 0, width, height);
+}
+
+// Compile a shader and print the info log if it fails
+unsigned compile_shader(GLenum type, const char* source)
+{
+   unsigned shader = glCreateShader(type);
+   glShaderSource(shader, 1, &source, nullptr);
+   glCompileShader(shader);
+
+   int success = 0;
+   char info_log[512] = "\0";
+   glGetShaderiv(shader, GL_COMPILE_STATUS, &success);
+
+   if (!success)
+   {
+      glGetShaderInfoLog(shader, sizeof(info_log), nullptr, info_log);
+      std::cout << "Failed to compile the shader: " << info_log;
+   }
+   return shader;
+}
+
+// Link a vertex and a fragment shader into a program and clean up the shaders
+unsigned link_program(const char* vertex_source, const char* fragment_source)
+{
+   unsigned vertex_shader = compile_shader(GL_VERTEX_SHADER, vertex_source);
+   unsigned fragment_shader = compile_shader(GL_FRAGMENT_SHADER, fragment_source);
+
+   unsigned program = glCreateProgram();
+   glAttachShader(program, vertex_shader);
+   glAttachShader(program, fragment_shader);
+   glLinkProgram(program);
+
+   int success = 0;
+   char info_log[512] = "\0";
+   glGetProgramiv(program, GL_LINK_STATUS, &success);
+
+   if (!success)
+   {
+      glGetProgramInfoLog(program, sizeof(info_log), nullptr, info_log);
+      std::cout << "Failed to link the shader program: " << info_log;
+   }
+
+   glDeleteShader(vertex_shader);
+   glDeleteShader(fragment_shader);
+   return program;
+}
+
+// Persistent worker threads, jobs are a plain function pointer so dispatching never allocates
+class WorkerPool
+{
+public:
+   using Job = void (*)(void* context, unsigned worker, unsigned worker_count);
+
+   explicit WorkerPool(unsigned count)
+   {
+      for (unsigned i = 0; i < count; ++i)
+         threads.emplace_back([this, i] { loop(i); });
+   }
+
+   ~WorkerPool()
+   {
+      {
+         std::lock_guard<std::mutex> lock(mutex);
+         running = false;
+      }
+      start.notify_all();
+
+      for (std::thread& thread : threads)
+         thread.join();
+   }
+
+   // Run job on every worker and wait for all of them
+   void run(Job new_job, void* context)
+   {
+      std::unique_lock<std::mutex> lock(mutex);
+      job = new_job;
+      job_context = context;
+      remaining = unsigned(threads.size());
+      ++generation;
+      start.notify_all();
+      done.wait(lock, [this] { return remaining == 0; });
+   }
+
+   unsigned size() const { return unsigned(threads.size()); }
+
+private:
+   void loop(unsigned index)
+   {
+      unsigned seen = 0;
+      while (true)
+      {
+         Job current = nullptr;
+         void* context = nullptr;
+         {
+            std::unique_lock<std::mutex> lock(mutex);
+            start.wait(lock, [&] { return !running || generation != seen; });
+            if (!running)
+               return;
+            seen = generation;
+            current = job;
+            context = job_context;
+         }
+
+         current(context, index, unsigned(threads.size()));
+
+         std::lock_guard<std::mutex> lock(mutex);
+         if (--remaining == 0)
+            done.notify_one();
+      }
+   }
+
+   std::vector<std::thread> threads;
+   std::mutex mutex;
+   std::condition_variable start, done;
+   Job job = nullptr;
+   void* job_context = nullptr;
+   unsigned generation = 0;
+   unsigned remaining = 0;
+   bool running = true;
+};
+
+// One sprite in the frame's draw list, sorted by key before it is turned into vertices
+struct DrawItem
+{
+   std::uint32_t sort_key;
+   float x, y, size;
+};
+
+// Vertex layout, position and color
+struct Vertex
+{
+   float x, y;
+   float r, g, b;
+};
+
+// Everything the workers need to fill their part of the draw list
+struct BuildContext
+{
+   DrawItem* items;
+   size_t item_count;
+   float time;
+   bool use_arenas;
+};
+
+// Per-item work, shared by both modes
+void fill_items(const BuildContext& context, size_t begin, size_t end, float* angles)
+{
+   // Temporaries go through the angles array, which comes from scratch or from the heap
+   for (size_t i = begin; i < end; ++i)
+      angles[i - begin] = context.time * (.2f + float(i % 97) * .01f) + float(i);
+
+   for (size_t i = begin; i < end; ++i)
+   {
+      const float radius = .1f + .85f * float((i * 2654435761u) % 1000) / 1000.f;
+      context.items[i] = { std::uint32_t((i * 7) % 8), std::cos(angles[i - begin]) * radius,
+         std::sin(angles[i - begin]) * radius, .004f + .004f * float(i % 3) };
+   }
+}
+
+// Worker job: fill this worker's slice of the draw list
+void build_items(void* data, unsigned worker, unsigned worker_count)
+{
+   const BuildContext& context = *static_cast<const BuildContext*>(data);
+   const size_t per_worker = (context.item_count + worker_count - 1) / worker_count;
+   const size_t begin = std::min(context.item_count, worker * per_worker);
+   const size_t end = std::min(context.item_count, begin + per_worker);
+
+   if (context.use_arenas)
+   {
+      ScratchScope scratch;
+      ArenaVector<float> angles(end - begin, 0.f, ArenaAllocator<float>(scratch.get()));
+      fill_items(context, begin, end, angles.data());
+   }
+   else
+   {
+      std::vector<float> angles(end - begin);
+      fill_items(context, begin, end, angles.data());
+   }
+}
+
+// Turn sorted draw items into two triangles each
+template <typename Items, typename Vertices>
+void build_vertices(const Items& items, Vertices& vertices)
+{
+   const float palette[8][3]
+   {
+      { 1.f, .5f, 0.f }, { 1.f, 1.f, 0.f }, { 0.f, .8f, .3f }, { 0.f, .5f, 1.f },
+      { .6f, 0.f, 1.f }, { 1.f, 0.f, .4f }, { 1.f, 1.f, 1.f }, { .2f, .2f, .2f }
+   };
+
+   for (const DrawItem& item : items)
+   {
+      const float* c = palette[item.sort_key];
+      const Vertex corners[4]
+      {
+         { item.x - item.size, item.y - item.size, c[0], c[1], c[2] },
+         { item.x + item.size, item.y - item.size, c[0], c[1], c[2] },
+         { item.x + item.size, item.y + item.size, c[0], c[1], c[2] },
+         { item.x - item.size, item.y + item.size, c[0], c[1], c[2] }
+      };
+      vertices.insert(vertices.end(), { corners[0], corners[1], corners[2], corners[0], corners[2], corners[3] });
+   }
+}
+
+// Main function
+int main()
+{
+   // Vertex shader
+   const char* vertex_shader_source =
+      "#version 330 core\n"
+      "layout (location = 0) in vec2 aPos;\n"
+      "layout (location = 1) in vec3 aColor;\n"
+      "out vec3 Color;\n"
+      "void main()\n"
+      "{\n"
+      "   Color = aColor;\n"
+      "   gl_Position = vec4(aPos, 0.0, 1.0);\n"
+      "}\0";
+
+   // Fragment shader
+   const char* fragment_shader_source =
+      "#version 330 core\n"
+      "in vec3 Color;\n"
+      "out vec4 FragColor;\n"
+      "void main()\n"
+      "{\n"
+      "   FragColor = vec4(Color, 1.0f);\n"
+      "}\0";
+
+   // Initialize GLFW and tell it the version and profile
+   glfwInit();
+   glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
+   glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
+   glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+
+   // Initialize the window
+   GLFWwindow* window = glfwCreateWindow(800, 600, "Frame allocator.", nullptr, nullptr);
+   if (!window)
+      throw_ex("Failed to create the window!");
+
+   // Set the current window
+   glfwMakeContextCurrent(window);
+
+   // Initialize GLAD
+   if (!gladLoadGLLoader(GLADloadproc(glfwGetProcAddress)))
+      throw_ex("Failed to initialize GLAD!");
+
+   // Set the viewport
+   glViewport(0, 0, 800, 600);
+
+   // Set window resize callback
+   glfwSetFramebufferSizeCallback(window, framebuffer_size_callback);
+
+   // Create the shader program
+   unsigned shader_program = link_program(vertex_shader_source, fragment_shader_source);
+
+   // Sprites rebuilt from scratch every frame
+   const size_t sprite_count = 20000;
+
+   // Create the buffer objects, the vertex buffer is refilled every frame
+   unsigned VBO = 0;
+   glGenBuffers(1, &VBO);
+
+   unsigned VAO = 0;
+   glGenVertexArrays(1, &VAO);
+
+   // Initialize the VAO
+   glBindVertexArray(VAO);
+   glBindBuffer(GL_ARRAY_BUFFER, VBO);
+   glBufferData(GL_ARRAY_BUFFER, sprite_count * 6 * sizeof(Vertex), nullptr, GL_STREAM_DRAW);
+
+   // Link vertex attributes
+   glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)0);
+   glEnableVertexAttribArray(0);
+   glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)(2 * sizeof(float)));
+   glEnableVertexAttribArray(1);
+
+   // Unbind VAO
+   glBindBuffer(GL_ARRAY_BUFFER, 0);
+   glBindVertexArray(0);
+
+   // Triple-buffered frame arena, starts small on purpose so the warm-up growth shows
+   FrameArena frame_arena(3, 64 * 1024);
+   WorkerPool workers(std::max(2u, std::thread::hardware_concurrency()));
+
+   // H switches to plain std::vector for everything
+   bool use_arenas = true, h_down = false;
+   std::uint64_t frame = 0;
+   double stats_time = glfwGetTime(), frame_ms = 0.0;
+   size_t frame_allocations = 0;
+   int frames = 0;
+
+   // Create the render loop
+   while (!glfwWindowShouldClose(window))
+   {
+      // Check if the window should close
+      if (glfwGetKey(window, GLFW_KEY_ESCAPE) == GLFW_PRESS)
+         glfwSetWindowShouldClose(window, true);
+
+      const bool h_pressed = glfwGetKey(window, GLFW_KEY_H) == GLFW_PRESS;
+      if (h_pressed && !h_down)
+         use_arenas = !use_arenas;
+      h_down = h_pressed;
+
+      const size_t allocations_before = allocation_count.load();
+      const double frame_start = glfwGetTime();
+
+      // Render
+      glClearColor(.5f, .5f, .5f, 1.f);
+      glClear(GL_COLOR_BUFFER_BIT);
+
+      glUseProgram(shader_program);
+      glBindVertexArray(VAO);
+      glBindBuffer(GL_ARRAY_BUFFER, VBO);
+
+      if (use_arenas)
+      {
+         // Draw list, sort and staging all come from this frame's arena
+         LinearArena& arena = frame_arena.begin_frame(frame);
+         ArenaVector<DrawItem> items(sprite_count, DrawItem {}, ArenaAllocator<DrawItem>(arena));
+
+         BuildContext context { items.data(), items.size(), float(frame_start), true };
+         workers.run(build_items, &context);
+
+         std::sort(items.begin(), items.end(), [](const DrawItem& a, const DrawItem& b) { return a.sort_key < b.sort_key; });
+
+         ArenaVector<Vertex> vertices { ArenaAllocator<Vertex>(arena) };
+         vertices.reserve(items.size() * 6);
+         build_vertices(items, vertices);
+         glBufferSubData(GL_ARRAY_BUFFER, 0, vertices.size() * sizeof(Vertex), vertices.data());
+      }
+      else
+      {
+         // Same work on the heap
+         std::vector<DrawItem> items(sprite_count);
+
+         BuildContext context { items.data(), items.size(), float(frame_start), false };
+         workers.run(build_items, &context);
+
+         std::sort(items.begin(), items.end(), [](const DrawItem& a, const DrawItem& b) { return a.sort_key < b.sort_key; });
+
+         std::vector<Vertex> vertices;
+         vertices.reserve(items.size() * 6);
+         build_vertices(items, vertices);
+         glBufferSubData(GL_ARRAY_BUFFER, 0, vertices.size() * sizeof(Vertex), vertices.data());
+      }
+
+      // Draw every sprite
+      glDrawArrays(GL_TRIANGLES, 0, GLsizei(sprite_count * 6));
+      glBindBuffer(GL_ARRAY_BUFFER, 0);
+      glBindVertexArray(0);
+
+      frame_allocations += allocation_count.load() - allocations_before;
+      frame_ms += (glfwGetTime() - frame_start) * 1000.0;
+      ++frame;
+      ++frames;
+
+      // Print heap allocations per frame once a second
+      const double now = glfwGetTime();
+      if (now - stats_time >= 1.0)
+      {
+         std::cout << (use_arenas ? "Arenas: " : "Heap:   ") << double(frame_allocations) / frames << " allocations/frame, "
+                   << frame_ms / frames << " ms/frame, frame arena high water " << frame_arena.high_water() / 1024 << " KiB\n";
+         stats_time = now;
+         frame_allocations = 0;
+         frame_ms = 0.0;
+         frames = 0;
+      }
+
+      // Swap buffers and check and call events
+      glfwSwapBuffers(window);
+      glfwPollEvents();
+   }
+
+   // Clean up
+   glDeleteVertexArrays(1, &VAO);
+   glDeleteBuffers(1, &VBO);
+   glDeleteProgram(shader_program);
+   glfwTerminate();
+   return 0;
+}
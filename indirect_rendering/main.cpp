@@ -0,0 +1,553 @@
+#include <glad/glad.h>
+#include <GLFW/glfw3.h>
+#include <cassert>
+#include <cmath>
+#include <iostream>
+#include <random>
+#include <vector>
+
+// Throw an exception and terminate GLFW
+void throw_ex(const char* msg)
+{
+   std::cout << msg << '\n';
+   glfwTerminate();
+   std::exit(-1);
+}
+
+// Resize callback function
+void framebuffer_size_callback(GLFWwindow*, int width, int height)
+{
+   assert(width > 0 && height > 0);
+   glViewport(0, 0, width, height);
+}
+
+// Compile a shader and print the info log if it fails
+unsigned compile_shader(GLenum type, const char* source)
+{
+   unsigned shader = glCreateShader(type);
+   glShaderSource(shader, 1, &source, nullptr);
+   glCompileShader(shader);
+
+   int success = 0;
+   char info_log[512] = "\0";
+   glGetShaderiv(shader, GL_COMPILE_STATUS, &success);
+
+   if (!success)
+   {
+      glGetShaderInfoLog(shader, sizeof(info_log), nullptr, info_log);
+      std::cout << "Failed to compile the shader: " << info_log;
+   }
+   return shader;
+}
+
+// Check if a program linked successfully
+void check_link(unsigned program)
+{
+   int success = 0;
+   char info_log[512] = "\0";
+   glGetProgramiv(program, GL_LINK_STATUS, &success);
+
+   if (!success)
+   {
+      glGetProgramInfoLog(program, sizeof(info_log), nullptr, info_log);
+      std::cout << "Failed to link the shader program: " << info_log;
+   }
+}
+
+// Link a vertex and a fragment shader into a program and clean up the shaders
+unsigned link_program(const char* vertex_source, const char* fragment_source)
+{
+   unsigned vertex_shader = compile_shader(GL_VERTEX_SHADER, vertex_source);
+   unsigned fragment_shader = compile_shader(GL_FRAGMENT_SHADER, fragment_source);
+
+   unsigned program = glCreateProgram();
+   glAttachShader(program, vertex_shader);
+   glAttachShader(program, fragment_shader);
+   glLinkProgram(program);
+   check_link(program);
+
+   glDeleteShader(vertex_shader);
+   glDeleteShader(fragment_shader);
+   return program;
+}
+
+// Link a compute shader into a program
+unsigned link_compute_program(const char* compute_source)
+{
+   unsigned compute_shader = compile_shader(GL_COMPUTE_SHADER, compute_source);
+
+   unsigned program = glCreateProgram();
+   glAttachShader(program, compute_shader);
+   glLinkProgram(program);
+   check_link(program);
+
+   glDeleteShader(compute_shader);
+   return program;
+}
+
+// Column-major 4x4 matrix
+struct Mat4
+{
+   float m[16];
+};
+
+Mat4 identity()
+{
+   Mat4 r {};
+   r.m[0] = r.m[5] = r.m[10] = r.m[15] = 1.f;
+   return r;
+}
+
+Mat4 multiply(const Mat4& a, const Mat4& b)
+{
+   Mat4 r {};
+   for (int col = 0; col < 4; ++col)
+      for (int row = 0; row < 4; ++row)
+         r.m[col * 4 + row] =
+            a.m[0 * 4 + row] * b.m[col * 4 + 0] +
+            a.m[1 * 4 + row] * b.m[col * 4 + 1] +
+            a.m[2 * 4 + row] * b.m[col * 4 + 2] +
+            a.m[3 * 4 + row] * b.m[col * 4 + 3];
+   return r;
+}
+
+Mat4 rotate_y(float angle)
+{
+   Mat4 r = identity();
+   r.m[0] = std::cos(angle);
+   r.m[2] = -std::sin(angle);
+   r.m[8] = -r.m[2];
+   r.m[10] = r.m[0];
+   return r;
+}
+
+Mat4 perspective(float fov_y, float aspect, float near_plane, float far_plane)
+{
+   const float f = 1.f / std::tan(fov_y * .5f);
+   Mat4 r {};
+   r.m[0] = f / aspect;
+   r.m[5] = f;
+   r.m[10] = (far_plane + near_plane) / (near_plane - far_plane);
+   r.m[11] = -1.f;
+   r.m[14] = 2.f * far_plane * near_plane / (near_plane - far_plane);
+   return r;
+}
+
+// Frustum planes (xyz = normal pointing inside, w = distance) from a view-projection matrix
+void extract_frustum(const Mat4& view_projection, float planes[6][4])
+{
+   for (int i = 0; i < 6; ++i)
+   {
+      const int axis = i / 2;
+      const float sign = i % 2 ? -1.f : 1.f;
+      float length = 0.f;
+
+      for (int k = 0; k < 4; ++k)
+      {
+         planes[i][k] = view_projection.m[k * 4 + 3] + sign * view_projection.m[k * 4 + axis];
+         length += k < 3 ? planes[i][k] * planes[i][k] : 0.f;
+      }
+
+      length = std::sqrt(length);
+      for (float& component : planes[i])
+         component /= length;
+   }
+}
+
+// Per-object data, matches the std430 layout of the Object struct in the shaders
+struct ObjectData
+{
+   float position[3];
+   float radius;
+   float color[3];
+   unsigned mesh;
+};
+
+// Layout glMultiDrawElementsIndirect expects
+struct DrawElementsIndirectCommand
+{
+   unsigned count;
+   unsigned instance_count;
+   unsigned first_index;
+   int base_vertex;
+   unsigned base_instance;
+};
+
+// Main function
+int main()
+{
+   // GL 4.3 vertex shader, objects come from the storage buffer
+   // aObject is the visible index list bound as an instanced attribute, base_instance offsets it per mesh
+   const char* vertex_shader_source_430 =
+      "#version 430 core\n"
+      "layout (location = 0) in vec3 aPos;\n"
+      "layout (location = 1) in uint aObject;\n"
+      "struct Object { vec4 position_radius; vec3 color; uint mesh; };\n"
+      "layout (std430, binding = 0) readonly buffer Objects { Object objects[]; };\n"
+      "uniform mat4 view;\n"
+      "uniform mat4 projection;\n"
+      "out vec3 Color;\n"
+      "void main()\n"
+      "{\n"
+      "   Object object = objects[aObject];\n"
+      "   Color = object.color;\n"
+      "   gl_Position = projection * view * vec4(object.position_radius.xyz + aPos * object.position_radius.w, 1.0);\n"
+      "}\0";
+
+   // GL 3.3 vertex shader, the same object buffer is read through a buffer texture
+   const char* vertex_shader_source_330 =
+      "#version 330 core\n"
+      "layout (location = 0) in vec3 aPos;\n"
+      "layout (location = 1) in uint aObject;\n"
+      "uniform samplerBuffer objects;\n"
+      "uniform mat4 view;\n"
+      "uniform mat4 projection;\n"
+      "out vec3 Color;\n"
+      "void main()\n"
+      "{\n"
+      "   vec4 position_radius = texelFetch(objects, int(aObject) * 2);\n"
+      "   Color = texelFetch(objects, int(aObject) * 2 + 1).rgb;\n"
+      "   gl_Position = projection * view * vec4(position_radius.xyz + aPos * position_radius.w, 1.0);\n"
+      "}\0";
+
+   // Fragment shader
+   const char* fragment_shader_source =
+      "#version 330 core\n"
+      "in vec3 Color;\n"
+      "out vec4 FragColor;\n"
+      "void main()\n"
+      "{\n"
+      "   FragColor = vec4(Color, 1.0f);\n"
+      "}\0";
+
+   // Culling compute shader, one invocation per object
+   // Visible objects are appended to the list of their mesh and counted in that mesh's draw command
+   const char* cull_shader_source =
+      "#version 430 core\n"
+      "layout (local_size_x = 64) in;\n"
+      "struct Object { vec4 position_radius; vec3 color; uint mesh; };\n"
+      "struct Command { uint count; uint instanceCount; uint firstIndex; int baseVertex; uint baseInstance; };\n"
+      "layout (std430, binding = 0) readonly buffer Objects { Object objects[]; };\n"
+      "layout (std430, binding = 1) buffer Commands { Command commands[]; };\n"
+      "layout (std430, binding = 2) writeonly buffer Visible { uint visible[]; };\n"
+      "uniform vec4 planes[6];\n"
+      "uniform uint object_count;\n"
+      "void main()\n"
+      "{\n"
+      "   uint id = gl_GlobalInvocationID.x;\n"
+      "   if (id >= object_count)\n"
+      "      return;\n"
+      "   vec4 sphere = objects[id].position_radius;\n"
+      "   for (int i = 0; i < 6; ++i)\n"
+      "      if (dot(planes[i].xyz, sphere.xyz) + planes[i].w < -sphere.w)\n"
+      "         return;\n"
+      "   uint mesh = objects[id].mesh;\n"
+      "   uint slot = atomicAdd(commands[mesh].instanceCount, 1u);\n"
+      "   visible[commands[mesh].baseInstance + slot] = id;\n"
+      "}\0";
+
+   // Initialize GLFW, ask for 4.3 and fall back to 3.3
+   glfwInit();
+   glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 4);
+   glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
+   glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+
+   // Initialize the window
+   GLFWwindow* window = glfwCreateWindow(800, 600, "Indirect rendering.", nullptr, nullptr);
+   if (!window)
+   {
+      glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
+      glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
+      window = glfwCreateWindow(800, 600, "Indirect rendering.", nullptr, nullptr);
+   }
+   if (!window)
+      throw_ex("Failed to create the window!");
+
+   // Set the current window
+   glfwMakeContextCurrent(window);
+
+   // Initialize GLAD
+   if (!gladLoadGLLoader(GLADloadproc(glfwGetProcAddress)))
+      throw_ex("Failed to initialize GLAD!");
+
+   // Set the viewport
+   glViewport(0, 0, 800, 600);
+
+   // Set window resize callback
+   glfwSetFramebufferSizeCallback(window, framebuffer_size_callback);
+
+   // G toggles between the two paths when compute is there
+   const bool has_compute = GLAD_GL_VERSION_4_3;
+   bool gpu_driven = has_compute;
+   std::cout << (has_compute ? "GL 4.3: GPU culling with one multi-draw, G switches to the CPU path\n"
+                             : "GL 3.3: CPU culling fallback\n");
+
+   // Create the shader programs
+   unsigned program_330 = link_program(vertex_shader_source_330, fragment_shader_source);
+   unsigned program_430 = has_compute ? link_program(vertex_shader_source_430, fragment_shader_source) : 0;
+   unsigned cull_program = has_compute ? link_compute_program(cull_shader_source) : 0;
+
+   // Meshes: regular polygons with 3 to 7 sides in one vertex and one index buffer
+   const int mesh_count = 5;
+   std::vector<float> vertices;
+   std::vector<unsigned> indices;
+   std::vector<DrawElementsIndirectCommand> command_template;
+
+   for (int mesh = 0; mesh < mesh_count; ++mesh)
+   {
+      const int sides = mesh + 3;
+      DrawElementsIndirectCommand command {};
+      command.count = unsigned(sides - 2) * 3;
+      command.first_index = unsigned(indices.size());
+      command.base_vertex = int(vertices.size() / 3);
+
+      for (int i = 0; i < sides; ++i)
+      {
+         const float angle = 1.5708f - 6.28319f * i / sides;
+         vertices.insert(vertices.end(), { std::cos(angle), std::sin(angle), 0.f });
+      }
+      for (int i = 1; i < sides - 1; ++i)
+         indices.insert(indices.end(), { 0u, unsigned(i), unsigned(i + 1) });
+
+      command_template.push_back(command);
+   }
+
+   // Scatter objects around the camera
+   const unsigned object_count = 200000;
+   std::vector<ObjectData> objects(object_count);
+   std::mt19937 random(42);
+   std::uniform_real_distribution<float> position(-150.f, 150.f), color(.2f, 1.f);
+
+   for (ObjectData& object : objects)
+   {
+      object = { { position(random), position(random) * .3f, position(random) }, .5f,
+         { color(random), color(random), color(random) }, unsigned(random() % mesh_count) };
+
+      // Every mesh gets room for all its objects in the visible list
+      ++command_template[object.mesh].base_instance;
+   }
+
+   // Turn the per-mesh counts into offsets
+   unsigned offset = 0;
+   for (DrawElementsIndirectCommand& command : command_template)
+   {
+      const unsigned capacity = command.base_instance;
+      command.base_instance = offset;
+      offset += capacity;
+   }
+
+   // Create the buffer objects
+   unsigned VBO = 0, EBO = 0, object_buffer = 0, visible_buffer = 0, command_buffer = 0, object_texture = 0;
+   glGenBuffers(1, &VBO);
+   glGenBuffers(1, &EBO);
+   glGenBuffers(1, &object_buffer);
+   glGenBuffers(1, &visible_buffer);
+   glGenBuffers(1, &command_buffer);
+   glGenTextures(1, &object_texture);
+
+   unsigned VAO = 0;
+   glGenVertexArrays(1, &VAO);
+
+   // Initialize the VAO
+   glBindVertexArray(VAO);
+
+   // Copy vertices and indices in buffers
+   glBindBuffer(GL_ARRAY_BUFFER, VBO);
+   glBufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(float), vertices.data(), GL_STATIC_DRAW);
+
+   glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, EBO);
+   glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(unsigned), indices.data(), GL_STATIC_DRAW);
+
+   glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 3 * sizeof(float), (void*)0);
+   glEnableVertexAttribArray(0);
+
+   // Visible object indices, one per instance
+   glBindBuffer(GL_ARRAY_BUFFER, visible_buffer);
+   glBufferData(GL_ARRAY_BUFFER, object_count * sizeof(unsigned), nullptr, GL_DYNAMIC_DRAW);
+   glVertexAttribIPointer(1, 1, GL_UNSIGNED_INT, sizeof(unsigned), (void*)0);
+   glVertexAttribDivisor(1, 1);
+   glEnableVertexAttribArray(1);
+
+   // Unbind VAO
+   glBindBuffer(GL_ARRAY_BUFFER, 0);
+   glBindVertexArray(0);
+
+   // Objects go in one buffer, used as a storage buffer on 4.3 and as a buffer texture on 3.3
+   glBindBuffer(GL_TEXTURE_BUFFER, object_buffer);
+   glBufferData(GL_TEXTURE_BUFFER, object_count * sizeof(ObjectData), objects.data(), GL_STATIC_DRAW);
+   glBindTexture(GL_TEXTURE_BUFFER, object_texture);
+   glTexBuffer(GL_TEXTURE_BUFFER, GL_RGBA32F, object_buffer);
+   glBindBuffer(GL_TEXTURE_BUFFER, 0);
+
+   glUseProgram(program_330);
+   glUniform1i(glGetUniformLocation(program_330, "objects"), 0);
+   const int view_location_330 = glGetUniformLocation(program_330, "view");
+   const int projection_location_330 = glGetUniformLocation(program_330, "projection");
+   const int view_location_430 = has_compute ? glGetUniformLocation(program_430, "view") : -1;
+   const int projection_location_430 = has_compute ? glGetUniformLocation(program_430, "projection") : -1;
+   const int planes_location = has_compute ? glGetUniformLocation(cull_program, "planes") : -1;
+   const int object_count_location = has_compute ? glGetUniformLocation(cull_program, "object_count") : -1;
+
+   // Draw commands
+   if (has_compute)
+   {
+      glBindBuffer(GL_DRAW_INDIRECT_BUFFER, command_buffer);
+      glBufferData(GL_DRAW_INDIRECT_BUFFER, sizeof(DrawElementsIndirectCommand) * mesh_count, nullptr, GL_DYNAMIC_DRAW);
+      glBindBuffer(GL_DRAW_INDIRECT_BUFFER, 0);
+   }
+
+   std::vector<DrawElementsIndirectCommand> commands = command_template;
+   std::vector<unsigned> visible(object_count);
+
+   double stats_time = glfwGetTime();
+   int frames = 0;
+   bool g_down = false;
+
+   // Create the render loop
+   while (!glfwWindowShouldClose(window))
+   {
+      // Check if the window should close
+      if (glfwGetKey(window, GLFW_KEY_ESCAPE) == GLFW_PRESS)
+         glfwSetWindowShouldClose(window, true);
+
+      const bool g_pressed = glfwGetKey(window, GLFW_KEY_G) == GLFW_PRESS;
+      if (g_pressed && !g_down && has_compute)
+         gpu_driven = !gpu_driven;
+      g_down = g_pressed;
+
+      // Camera turns around in the middle of the objects
+      int width = 0, height = 0;
+      glfwGetFramebufferSize(window, &width, &height);
+      const Mat4 view = rotate_y(float(glfwGetTime()) * .2f);
+      const Mat4 projection = perspective(.785f, height > 0 ? float(width) / height : 1.f, .1f, 200.f);
+
+      float planes[6][4];
+      extract_frustum(multiply(projection, view), planes);
+
+      // Render
+      glClearColor(.5f, .5f, .5f, 1.f);
+      glClear(GL_COLOR_BUFFER_BIT);
+      glBindVertexArray(VAO);
+
+      if (gpu_driven)
+      {
+         // Reset the instance counts, the compute shader fills them back in
+         glBindBuffer(GL_DRAW_INDIRECT_BUFFER, command_buffer);
+         glBufferSubData(GL_DRAW_INDIRECT_BUFFER, 0, sizeof(DrawElementsIndirectCommand) * mesh_count, command_template.data());
+
+         // Cull every object on the GPU
+         glUseProgram(cull_program);
+         glUniform4fv(planes_location, 6, &planes[0][0]);
+         glUniform1ui(object_count_location, object_count);
+         glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, object_buffer);
+         glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 1, command_buffer);
+         glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 2, visible_buffer);
+         glDispatchCompute((object_count + 63) / 64, 1, 1);
+
+         // Make the commands and the visible list visible to the draw
+         glMemoryBarrier(GL_COMMAND_BARRIER_BIT | GL_VERTEX_ATTRIB_ARRAY_BARRIER_BIT | GL_SHADER_STORAGE_BARRIER_BIT);
+
+         // The instanced attribute starts at the front of the list, base_instance picks each mesh's part
+         glBindBuffer(GL_ARRAY_BUFFER, visible_buffer);
+         glVertexAttribIPointer(1, 1, GL_UNSIGNED_INT, sizeof(unsigned), (void*)0);
+         glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+         // Draw everything with one call
+         glUseProgram(program_430);
+         glUniformMatrix4fv(view_location_430, 1, GL_FALSE, view.m);
+         glUniformMatrix4fv(projection_location_430, 1, GL_FALSE, projection.m);
+         glMultiDrawElementsIndirect(GL_TRIANGLES, GL_UNSIGNED_INT, (void*)0, mesh_count, 0);
+         glBindBuffer(GL_DRAW_INDIRECT_BUFFER, 0);
+      }
+      else
+      {
+         // Cull on the CPU and fill the same commands
+         commands = command_template;
+         for (unsigned id = 0; id < object_count; ++id)
+         {
+            const ObjectData& object = objects[id];
+            bool inside = true;
+            for (const float* plane : planes)
+               if (plane[0] * object.position[0] + plane[1] * object.position[1] + plane[2] * object.position[2] + plane[3] < -object.radius)
+               {
+                  inside = false;
+                  break;
+               }
+
+            if (inside)
+            {
+               DrawElementsIndirectCommand& command = commands[object.mesh];
+               visible[command.base_instance + command.instance_count++] = id;
+            }
+         }
+
+         glBindBuffer(GL_ARRAY_BUFFER, visible_buffer);
+         for (const DrawElementsIndirectCommand& command : commands)
+            glBufferSubData(GL_ARRAY_BUFFER, command.base_instance * sizeof(unsigned),
+               command.instance_count * sizeof(unsigned), visible.data() + command.base_instance);
+
+         // No indirect draws on 3.3, submit the commands one mesh at a time
+         // Without base_instance the instanced attribute is moved to the mesh's part of the list instead
+         glUseProgram(program_330);
+         glUniformMatrix4fv(view_location_330, 1, GL_FALSE, view.m);
+         glUniformMatrix4fv(projection_location_330, 1, GL_FALSE, projection.m);
+         glActiveTexture(GL_TEXTURE0);
+         glBindTexture(GL_TEXTURE_BUFFER, object_texture);
+
+         for (const DrawElementsIndirectCommand& command : commands)
+         {
+            if (command.instance_count == 0)
+               continue;
+
+            glVertexAttribIPointer(1, 1, GL_UNSIGNED_INT, sizeof(unsigned), (void*)(command.base_instance * sizeof(unsigned)));
+            glDrawElementsInstancedBaseVertex(GL_TRIANGLES, GLsizei(command.count), GL_UNSIGNED_INT,
+               (void*)(command.first_index * sizeof(unsigned)), GLsizei(command.instance_count), command.base_vertex);
+         }
+         glBindBuffer(GL_ARRAY_BUFFER, 0);
+      }
+      glBindVertexArray(0);
+
+      // Print the frame rate and how many objects survived culling once a second
+      ++frames;
+      const double now = glfwGetTime();
+      if (now - stats_time >= 1.0)
+      {
+         if (gpu_driven)
+         {
+            glBindBuffer(GL_DRAW_INDIRECT_BUFFER, command_buffer);
+            glGetBufferSubData(GL_DRAW_INDIRECT_BUFFER, 0, sizeof(DrawElementsIndirectCommand) * mesh_count, commands.data());
+            glBindBuffer(GL_DRAW_INDIRECT_BUFFER, 0);
+         }
+
+         unsigned visible_count = 0;
+         for (const DrawElementsIndirectCommand& command : commands)
+            visible_count += command.instance_count;
+
+         std::cout << (gpu_driven ? "GPU" : "CPU") << " culling: " << frames / (now - stats_time) << " fps, "
+                   << visible_count << " of " << object_count << " objects visible\n";
+         stats_time = now;
+         frames = 0;
+      }
+
+      // Swap buffers and check and call events
+      glfwSwapBuffers(window);
+      glfwPollEvents();
+   }
+
+   // Clean up
+   glDeleteVertexArrays(1, &VAO);
+   glDeleteTextures(1, &object_texture);
+   glDeleteBuffers(1, &VBO);
+   glDeleteBuffers(1, &EBO);
+   glDeleteBuffers(1, &object_buffer);
+   glDeleteBuffers(1, &visible_buffer);
+   glDeleteBuffers(1, &command_buffer);
+   glDeleteProgram(program_330);
+   if (has_compute)
+   {
+      glDeleteProgram(program_430);
+      glDeleteProgram(cull_program);
+   }
+   glfwTerminate();
+   return 0;
+}
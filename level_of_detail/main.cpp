@@ -0,0 +1,613 @@
+#include <glad/glad.h>
+#include <GLFW/glfw3.h>
+#include <algorithm>
+#include <array>
+#include <cassert>
+#include <cmath>
+#include <iostream>
+#include <queue>
+#include <vector>
+
+// Throw an exception and terminate GLFW
+void throw_ex(const char* msg)
+{
+   std::cout << msg << '\n';
+   glfwTerminate();
+   std::exit(-1);
+}
+
+// Resize callback function
+void framebuffer_size_callback(GLFWwindow*, int width, int height)
+{
+   assert(width > 0 && height > 0);
+   glViewport(0, 0, width, height);
+}
+
+// Compile a shader and print the info log if it fails
+unsigned compile_shader(GLenum type, const char* source)
+{
+   unsigned shader = glCreateShader(type);
+   glShaderSource(shader, 1, &source, nullptr);
+   glCompileShader(shader);
+
+   int success = 0;
+   char info_log[512] = "\0";
+   glGetShaderiv(shader, GL_COMPILE_STATUS, &success);
+
+   if (!success)
+   {
+      glGetShaderInfoLog(shader, sizeof(info_log), nullptr, info_log);
+      std::cout << "Failed to compile the shader: " << info_log;
+   }
+   return shader;
+}
+
+// Link a vertex and a fragment shader into a program and clean up the shaders
+unsigned link_program(const char* vertex_source, const char* fragment_source)
+{
+   unsigned vertex_shader = compile_shader(GL_VERTEX_SHADER, vertex_source);
+   unsigned fragment_shader = compile_shader(GL_FRAGMENT_SHADER, fragment_source);
+
+   unsigned program = glCreateProgram();
+   glAttachShader(program, vertex_shader);
+   glAttachShader(program, fragment_shader);
+   glLinkProgram(program);
+
+   int success = 0;
+   char info_log[512] = "\0";
+   glGetProgramiv(program, GL_LINK_STATUS, &success);
+
+   if (!success)
+   {
+      glGetProgramInfoLog(program, sizeof(info_log), nullptr, info_log);
+      std::cout << "Failed to link the shader program: " << info_log;
+   }
+
+   glDeleteShader(vertex_shader);
+   glDeleteShader(fragment_shader);
+   return program;
+}
+
+// Column-major 4x4 matrix
+struct Mat4
+{
+   float m[16];
+};
+
+Mat4 identity()
+{
+   Mat4 r {};
+   r.m[0] = r.m[5] = r.m[10] = r.m[15] = 1.f;
+   return r;
+}
+
+Mat4 multiply(const Mat4& a, const Mat4& b)
+{
+   Mat4 r {};
+   for (int col = 0; col < 4; ++col)
+      for (int row = 0; row < 4; ++row)
+         r.m[col * 4 + row] =
+            a.m[0 * 4 + row] * b.m[col * 4 + 0] +
+            a.m[1 * 4 + row] * b.m[col * 4 + 1] +
+            a.m[2 * 4 + row] * b.m[col * 4 + 2] +
+            a.m[3 * 4 + row] * b.m[col * 4 + 3];
+   return r;
+}
+
+Mat4 translate(float x, float y, float z)
+{
+   Mat4 r = identity();
+   r.m[12] = x;
+   r.m[13] = y;
+   r.m[14] = z;
+   return r;
+}
+
+Mat4 rotate_x(float angle)
+{
+   Mat4 r = identity();
+   r.m[5] = std::cos(angle);
+   r.m[6] = std::sin(angle);
+   r.m[9] = -r.m[6];
+   r.m[10] = r.m[5];
+   return r;
+}
+
+Mat4 perspective(float fov_y, float aspect, float near_plane, float far_plane)
+{
+   const float f = 1.f / std::tan(fov_y * .5f);
+   Mat4 r {};
+   r.m[0] = f / aspect;
+   r.m[5] = f;
+   r.m[10] = (far_plane + near_plane) / (near_plane - far_plane);
+   r.m[11] = -1.f;
+   r.m[14] = 2.f * far_plane * near_plane / (near_plane - far_plane);
+   return r;
+}
+
+// Vertex layout
+struct Vertex
+{
+   float position[3];
+   float normal[3];
+};
+
+// Lumpy closed sphere, a pole vertex at each end and rings that share their seam vertex
+void build_lumpy_sphere(int segments, int rings, std::vector<Vertex>& vertices, std::vector<unsigned>& indices)
+{
+   const float pi = 3.14159265f;
+   auto radius = [](float theta, float phi) { return 1.f + .15f * std::sin(5.f * theta) * std::sin(4.f * phi); };
+
+   vertices.push_back({ { 0.f, 1.f, 0.f }, {} });
+   for (int ring = 1; ring < rings; ++ring)
+      for (int segment = 0; segment < segments; ++segment)
+      {
+         const float phi = pi * ring / rings, theta = 2.f * pi * segment / segments, r = radius(theta, phi);
+         vertices.push_back({ { r * std::sin(phi) * std::cos(theta), r * std::cos(phi), r * std::sin(phi) * std::sin(theta) }, {} });
+      }
+   vertices.push_back({ { 0.f, -1.f, 0.f }, {} });
+
+   const unsigned bottom = unsigned(vertices.size() - 1);
+   auto ring_vertex = [segments](int ring, int segment) { return unsigned(1 + (ring - 1) * segments + segment % segments); };
+
+   for (int segment = 0; segment < segments; ++segment)
+   {
+      // Caps
+      indices.insert(indices.end(), { 0u, ring_vertex(1, segment + 1), ring_vertex(1, segment) });
+      indices.insert(indices.end(), { bottom, ring_vertex(rings - 1, segment), ring_vertex(rings - 1, segment + 1) });
+
+      // Quads between the rings
+      for (int ring = 1; ring < rings - 1; ++ring)
+      {
+         const unsigned a = ring_vertex(ring, segment), b = ring_vertex(ring, segment + 1);
+         const unsigned c = ring_vertex(ring + 1, segment), d = ring_vertex(ring + 1, segment + 1);
+         indices.insert(indices.end(), { a, b, c, b, d, c });
+      }
+   }
+
+   // Area weighted vertex normals
+   for (size_t i = 0; i < indices.size(); i += 3)
+   {
+      const float* p0 = vertices[indices[i]].position;
+      const float* p1 = vertices[indices[i + 1]].position;
+      const float* p2 = vertices[indices[i + 2]].position;
+      const float e1[3] { p1[0] - p0[0], p1[1] - p0[1], p1[2] - p0[2] };
+      const float e2[3] { p2[0] - p0[0], p2[1] - p0[1], p2[2] - p0[2] };
+      const float n[3] { e1[1] * e2[2] - e1[2] * e2[1], e1[2] * e2[0] - e1[0] * e2[2], e1[0] * e2[1] - e1[1] * e2[0] };
+
+      for (int corner = 0; corner < 3; ++corner)
+         for (int k = 0; k < 3; ++k)
+            vertices[indices[i + corner]].normal[k] += n[k];
+   }
+
+   for (Vertex& vertex : vertices)
+   {
+      const float length = std::sqrt(vertex.normal[0] * vertex.normal[0] + vertex.normal[1] * vertex.normal[1] + vertex.normal[2] * vertex.normal[2]);
+      for (float& n : vertex.normal)
+         n /= length;
+   }
+}
+
+// Symmetric 4x4 error quadric, stored as its upper triangle
+struct Quadric
+{
+   double a[10];
+};
+
+Quadric plane_quadric(double a, double b, double c, double d, double weight)
+{
+   return { { a * a * weight, a * b * weight, a * c * weight, a * d * weight,
+      b * b * weight, b * c * weight, b * d * weight, c * c * weight, c * d * weight, d * d * weight } };
+}
+
+void add(Quadric& q, const Quadric& other)
+{
+   for (int i = 0; i < 10; ++i)
+      q.a[i] += other.a[i];
+}
+
+// Squared distance of a point to all the planes accumulated in the quadric
+double quadric_error(const Quadric& q, const float* p)
+{
+   const double x = p[0], y = p[1], z = p[2];
+   return q.a[0] * x * x + 2 * q.a[1] * x * y + 2 * q.a[2] * x * z + 2 * q.a[3] * x
+      + q.a[4] * y * y + 2 * q.a[5] * y * z + 2 * q.a[6] * y
+      + q.a[7] * z * z + 2 * q.a[8] * z + q.a[9];
+}
+
+// Range of one LOD in the shared index buffer
+struct Lod
+{
+   unsigned first_index;
+   unsigned index_count;
+};
+
+// Simplify a mesh with quadric error metrics and append every LOD to lod_indices
+// Vertices are collapsed onto their neighbours (half-edge collapses), so all LODs share the original
+// vertex buffer and differ only in their index range. Every LOD aims at half the triangles of the last one.
+std::vector<Lod> build_lod_chain(const std::vector<Vertex>& vertices, const std::vector<unsigned>& indices,
+   int lod_count, std::vector<unsigned>& lod_indices)
+{
+   const size_t triangle_count = indices.size() / 3;
+   std::vector<std::array<unsigned, 3>> triangles(triangle_count);
+   std::vector<unsigned char> triangle_alive(triangle_count, 1);
+   std::vector<std::vector<unsigned>> vertex_triangles(vertices.size());
+   std::vector<Quadric> quadrics(vertices.size(), Quadric {});
+   std::vector<unsigned char> vertex_alive(vertices.size(), 1);
+   std::vector<unsigned> version(vertices.size(), 0);
+
+   auto normal_of = [&](unsigned a, unsigned b, unsigned c, double* n)
+   {
+      const float* p0 = vertices[a].position;
+      const float* p1 = vertices[b].position;
+      const float* p2 = vertices[c].position;
+      const double e1[3] { p1[0] - p0[0], p1[1] - p0[1], p1[2] - p0[2] };
+      const double e2[3] { p2[0] - p0[0], p2[1] - p0[1], p2[2] - p0[2] };
+      n[0] = e1[1] * e2[2] - e1[2] * e2[1];
+      n[1] = e1[2] * e2[0] - e1[0] * e2[2];
+      n[2] = e1[0] * e2[1] - e1[1] * e2[0];
+   };
+
+   // Every vertex starts with the planes of the triangles around it, weighted by area
+   for (size_t t = 0; t < triangle_count; ++t)
+   {
+      triangles[t] = { indices[t * 3], indices[t * 3 + 1], indices[t * 3 + 2] };
+
+      double n[3];
+      normal_of(triangles[t][0], triangles[t][1], triangles[t][2], n);
+      const double length = std::sqrt(n[0] * n[0] + n[1] * n[1] + n[2] * n[2]);
+      if (length == 0.0)
+         continue;
+
+      const float* p = vertices[triangles[t][0]].position;
+      const double a = n[0] / length, b = n[1] / length, c = n[2] / length;
+      const Quadric q = plane_quadric(a, b, c, -(a * p[0] + b * p[1] + c * p[2]), length * .5);
+
+      for (unsigned v : triangles[t])
+      {
+         add(quadrics[v], q);
+         vertex_triangles[v].push_back(unsigned(t));
+      }
+   }
+
+   // Candidate collapses, cheapest first, stale entries are skipped by comparing versions
+   struct Collapse
+   {
+      double cost;
+      unsigned from, to;
+      unsigned from_version, to_version;
+
+      bool operator>(const Collapse& other) const { return cost > other.cost; }
+   };
+   std::priority_queue<Collapse, std::vector<Collapse>, std::greater<Collapse>> heap;
+
+   auto push_collapse = [&](unsigned from, unsigned to)
+   {
+      Quadric q = quadrics[from];
+      add(q, quadrics[to]);
+      heap.push({ quadric_error(q, vertices[to].position), from, to, version[from], version[to] });
+   };
+
+   for (const std::array<unsigned, 3>& triangle : triangles)
+      for (int edge = 0; edge < 3; ++edge)
+      {
+         push_collapse(triangle[edge], triangle[(edge + 1) % 3]);
+         push_collapse(triangle[(edge + 1) % 3], triangle[edge]);
+      }
+
+   // Write the live triangles as the next LOD
+   std::vector<Lod> lods;
+   size_t live_triangles = triangle_count;
+   auto emit_lod = [&]
+   {
+      Lod lod { unsigned(lod_indices.size()), 0 };
+      for (size_t t = 0; t < triangle_count; ++t)
+         if (triangle_alive[t])
+            lod_indices.insert(lod_indices.end(), triangles[t].begin(), triangles[t].end());
+      lod.index_count = unsigned(lod_indices.size() - lod.first_index);
+      lods.push_back(lod);
+   };
+
+   emit_lod();
+
+   for (int level = 1; level < lod_count; ++level)
+   {
+      const size_t target = live_triangles / 2;
+
+      while (live_triangles > target && !heap.empty())
+      {
+         const Collapse collapse = heap.top();
+         heap.pop();
+
+         const unsigned from = collapse.from, to = collapse.to;
+         if (!vertex_alive[from] || !vertex_alive[to] ||
+            collapse.from_version != version[from] || collapse.to_version != version[to])
+            continue;
+
+         // Reject collapses that would flip a triangle over
+         bool flips = false;
+         for (unsigned t : vertex_triangles[from])
+         {
+            const std::array<unsigned, 3>& tri = triangles[t];
+            if (!triangle_alive[t] || tri[0] == to || tri[1] == to || tri[2] == to)
+               continue;
+
+            double before[3], after[3];
+            normal_of(tri[0], tri[1], tri[2], before);
+            normal_of(tri[0] == from ? to : tri[0], tri[1] == from ? to : tri[1], tri[2] == from ? to : tri[2], after);
+            if (before[0] * after[0] + before[1] * after[1] + before[2] * after[2] <= 0.0)
+            {
+               flips = true;
+               break;
+            }
+         }
+         if (flips)
+            continue;
+
+         // Collapse from onto to, triangles sharing the edge disappear
+         for (unsigned t : vertex_triangles[from])
+         {
+            if (!triangle_alive[t])
+               continue;
+
+            std::array<unsigned, 3>& tri = triangles[t];
+            if (tri[0] == to || tri[1] == to || tri[2] == to)
+            {
+               triangle_alive[t] = 0;
+               --live_triangles;
+               continue;
+            }
+
+            for (unsigned& v : tri)
+               if (v == from)
+                  v = to;
+            vertex_triangles[to].push_back(t);
+         }
+
+         add(quadrics[to], quadrics[from]);
+         vertex_alive[from] = 0;
+         vertex_triangles[from].clear();
+         ++version[to];
+
+         // The neighbourhood of to changed, requeue its edges with the new costs
+         for (unsigned t : vertex_triangles[to])
+            if (triangle_alive[t])
+               for (unsigned v : triangles[t])
+                  if (v != to)
+                  {
+                     push_collapse(to, v);
+                     push_collapse(v, to);
+                  }
+      }
+
+      emit_lod();
+   }
+   return lods;
+}
+
+// Object in the scene, lod is the level chosen last frame
+struct Object
+{
+   float position[3];
+   int lod;
+};
+
+// Pick a LOD from the projected size in pixels
+// LOD 0 covers objects bigger than full_detail_pixels, every following LOD covers half the size of the last.
+// An object only moves to another LOD once it is hysteresis levels past the border, so it doesn't flicker.
+int select_lod(float projected_pixels, int current, int lod_count)
+{
+   const float full_detail_pixels = 400.f;
+   const float hysteresis = .2f;
+
+   const float level = std::log2(full_detail_pixels / std::max(projected_pixels, 1e-3f));
+   if (level >= current - hysteresis && level < current + 1 + hysteresis)
+      return current;
+   return std::min(std::max(int(std::floor(level)), 0), lod_count - 1);
+}
+
+// Main function
+int main()
+{
+   // Vertex shader
+   const char* vertex_shader_source =
+      "#version 330 core\n"
+      "layout (location = 0) in vec3 aPos;\n"
+      "layout (location = 1) in vec3 aNormal;\n"
+      "uniform mat4 model;\n"
+      "uniform mat4 view;\n"
+      "uniform mat4 projection;\n"
+      "out vec3 Normal;\n"
+      "void main()\n"
+      "{\n"
+      "   Normal = mat3(model) * aNormal;\n"
+      "   gl_Position = projection * view * model * vec4(aPos, 1.0);\n"
+      "}\0";
+
+   // Fragment shader with a single directional light
+   const char* fragment_shader_source =
+      "#version 330 core\n"
+      "in vec3 Normal;\n"
+      "out vec4 FragColor;\n"
+      "void main()\n"
+      "{\n"
+      "   float diffuse = max(dot(normalize(Normal), normalize(vec3(0.4, 1.0, 0.6))), 0.0);\n"
+      "   FragColor = vec4(vec3(1.0f, 0.5f, 0.f) * (0.2 + 0.8 * diffuse), 1.0f);\n"
+      "}\0";
+
+   // Initialize GLFW and tell it the version and profile
+   glfwInit();
+   glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
+   glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
+   glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+
+   // Initialize the window
+   GLFWwindow* window = glfwCreateWindow(800, 600, "Level of detail.", nullptr, nullptr);
+   if (!window)
+      throw_ex("Failed to create the window!");
+
+   // Set the current window
+   glfwMakeContextCurrent(window);
+
+   // Initialize GLAD
+   if (!gladLoadGLLoader(GLADloadproc(glfwGetProcAddress)))
+      throw_ex("Failed to initialize GLAD!");
+
+   // Set the viewport
+   glViewport(0, 0, 800, 600);
+
+   // Set window resize callback
+   glfwSetFramebufferSizeCallback(window, framebuffer_size_callback);
+
+   // Don't wait for vsync, the frame times are the point
+   glfwSwapInterval(0);
+
+   // Create the shader program
+   unsigned shader_program = link_program(vertex_shader_source, fragment_shader_source);
+   const int model_location = glGetUniformLocation(shader_program, "model");
+   const int view_location = glGetUniformLocation(shader_program, "view");
+   const int projection_location = glGetUniformLocation(shader_program, "projection");
+
+   // Build the mesh and simplify it at load time
+   std::vector<Vertex> vertices;
+   std::vector<unsigned> indices;
+   build_lumpy_sphere(64, 32, vertices, indices);
+
+   const int lod_count = 6;
+   std::vector<unsigned> lod_indices;
+   const std::vector<Lod> lods = build_lod_chain(vertices, indices, lod_count, lod_indices);
+
+   for (size_t i = 0; i < lods.size(); ++i)
+      std::cout << "LOD " << i << ": " << lods[i].index_count / 3 << " triangles\n";
+
+   // Create the buffer objects, every LOD lives in the same index buffer
+   unsigned EBO = 0;
+   glGenBuffers(1, &EBO);
+
+   unsigned VBO = 0;
+   glGenBuffers(1, &VBO);
+
+   unsigned VAO = 0;
+   glGenVertexArrays(1, &VAO);
+
+   // Initialize the VAO
+   glBindVertexArray(VAO);
+
+   // Copy vertices and LOD indices in buffers
+   glBindBuffer(GL_ARRAY_BUFFER, VBO);
+   glBufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(Vertex), vertices.data(), GL_STATIC_DRAW);
+
+   glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, EBO);
+   glBufferData(GL_ELEMENT_ARRAY_BUFFER, lod_indices.size() * sizeof(unsigned), lod_indices.data(), GL_STATIC_DRAW);
+
+   // Link vertex attributes
+   glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)0);
+   glEnableVertexAttribArray(0);
+   glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)(3 * sizeof(float)));
+   glEnableVertexAttribArray(1);
+
+   // Unbind VAO
+   glBindBuffer(GL_ARRAY_BUFFER, 0);
+   glBindVertexArray(0);
+
+   // A field of spheres stretching away from the camera
+   std::vector<Object> objects;
+   for (int row = 0; row < 50; ++row)
+      for (int column = 0; column < 20; ++column)
+         objects.push_back({ { (column - 9.5f) * 3.f, 0.f, -row * 4.f }, 0 });
+
+   glEnable(GL_DEPTH_TEST);
+
+   // Benchmark: some warm up frames, then the same number of frames with LOD off and on
+   // Afterwards L toggles LOD by hand
+   const int warmup_frames = 30, benchmark_frames = 300;
+   int frame = 0, phase_first_frame = 0;
+   bool use_lod = false, l_down = false;
+   double phase_start = 0.0, phase_triangles = 0.0;
+   double result_ms[2] {}, result_triangles[2] {};
+
+   // Create the render loop
+   while (!glfwWindowShouldClose(window))
+   {
+      // Check if the window should close
+      if (glfwGetKey(window, GLFW_KEY_ESCAPE) == GLFW_PRESS)
+         glfwSetWindowShouldClose(window, true);
+
+      // Drive the benchmark phases
+      const double now = glfwGetTime();
+      if (frame == warmup_frames || frame == warmup_frames + benchmark_frames || frame == warmup_frames + 2 * benchmark_frames)
+      {
+         if (frame > warmup_frames)
+         {
+            result_ms[use_lod] = (now - phase_start) * 1000.0 / benchmark_frames;
+            result_triangles[use_lod] = phase_triangles / benchmark_frames;
+            use_lod = !use_lod;
+         }
+         phase_start = now;
+         phase_first_frame = frame;
+         phase_triangles = 0.0;
+
+         if (frame == warmup_frames + 2 * benchmark_frames)
+         {
+            std::cout << "LOD off: " << result_triangles[0] << " triangles/frame, " << result_ms[0] << " ms/frame\n"
+                      << "LOD on:  " << result_triangles[1] << " triangles/frame, " << result_ms[1] << " ms/frame\n";
+            use_lod = true;
+         }
+      }
+      ++frame;
+
+      const bool l_pressed = glfwGetKey(window, GLFW_KEY_L) == GLFW_PRESS;
+      if (l_pressed && !l_down && frame > warmup_frames + 2 * benchmark_frames)
+      {
+         use_lod = !use_lod;
+         std::cout << "LOD " << (use_lod ? "on\n" : "off\n");
+      }
+      l_down = l_pressed;
+
+      // Render
+      glClearColor(.5f, .5f, .5f, 1.f);
+      glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+
+      int width = 0, height = 0;
+      glfwGetFramebufferSize(window, &width, &height);
+      const float fov_y = .785f;
+      // The camera path restarts with every phase so LOD off and on are measured over the same views
+      const float camera_z = 10.f - 20.f * float(std::sin((frame - phase_first_frame) * .005));
+      const Mat4 view = multiply(rotate_x(.2f), translate(0.f, -3.f, -camera_z));
+      const Mat4 projection = perspective(fov_y, height > 0 ? float(width) / height : 1.f, .1f, 500.f);
+
+      // Use the shader program and bind VAO
+      glUseProgram(shader_program);
+      glUniformMatrix4fv(view_location, 1, GL_FALSE, view.m);
+      glUniformMatrix4fv(projection_location, 1, GL_FALSE, projection.m);
+      glBindVertexArray(VAO);
+
+      // Pick a LOD per object from its projected size and draw its range of the index buffer
+      const float pixels_per_unit = height * .5f / std::tan(fov_y * .5f);
+      for (Object& object : objects)
+      {
+         const float dx = object.position[0], dy = object.position[1] - 3.f, dz = object.position[2] - camera_z;
+         const float distance = std::max(std::sqrt(dx * dx + dy * dy + dz * dz), .1f);
+         object.lod = use_lod ? select_lod(2.f * pixels_per_unit / distance, object.lod, int(lods.size())) : 0;
+
+         const Mat4 model = translate(object.position[0], object.position[1], object.position[2]);
+         glUniformMatrix4fv(model_location, 1, GL_FALSE, model.m);
+
+         const Lod& lod = lods[object.lod];
+         glDrawElements(GL_TRIANGLES, GLsizei(lod.index_count), GL_UNSIGNED_INT, (void*)(lod.first_index * sizeof(unsigned)));
+         phase_triangles += lod.index_count / 3;
+      }
+
+      // Swap buffers and check and call events
+      glfwSwapBuffers(window);
+      glfwPollEvents();
+   }
+
+   // Clean up
+   glDeleteVertexArrays(1, &VAO);
+   glDeleteBuffers(1, &VBO);
+   glDeleteBuffers(1, &EBO);
+   glDeleteProgram(shader_program);
+   glfwTerminate();
+   return 0;
+}
@@ -0,0 +1,318 @@
+#pragma once
+#include <glad/glad.h>
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <map>
+#include <utility>
+#include <vector>
+
+// Not in every GLAD build, the values are fixed by the extension specs
+#ifndef GL_GPU_MEMORY_INFO_TOTAL_AVAILABLE_MEMORY_NVX
+#  define GL_GPU_MEMORY_INFO_TOTAL_AVAILABLE_MEMORY_NVX 0x9048
+#  define GL_GPU_MEMORY_INFO_CURRENT_AVAILABLE_VIDMEM_NVX 0x9049
+#endif
+#ifndef GL_TEXTURE_FREE_MEMORY_ATI
+#  define GL_TEXTURE_FREE_MEMORY_ATI 0x87FC
+#endif
+
+// Accounting of the GPU memory of buffers and textures, and a budget that streamable resources are evicted to
+// GL has no portable way to ask how big an object is or how much memory is left, so every allocation goes
+// through the tracker, which keeps the size it was created with. Resources are either fixed, created and
+// released by the caller and only counted, or streamable: the tracker owns those, creates them through a
+// loader on first use and deletes the least recently used ones whenever the total is over the budget.
+// Anything used in the current frame is never evicted, so a frame that needs more than the budget goes over
+// it for that frame, which is counted, instead of thrashing.
+//
+// When the driver reports free memory (NVX_gpu_memory_info or ATI_meminfo) the budget also shrinks to what
+// is actually free minus a reserve, so other applications and the driver's own allocations are respected.
+
+enum class MemoryCategory
+{
+   Geometry,
+   Texture,
+   RenderTarget,
+   Streaming
+};
+
+constexpr int memory_category_count = 4;
+
+// Whether the context exposes an extension, asked at runtime since the GLAD build may not know it at all
+inline bool has_gl_extension(const char* name)
+{
+   int count = 0;
+   glGetIntegerv(GL_NUM_EXTENSIONS, &count);
+   for (int i = 0; i < count; ++i)
+   {
+      const char* extension = reinterpret_cast<const char*>(glGetStringi(GL_EXTENSIONS, unsigned(i)));
+      if (extension && std::strcmp(extension, name) == 0)
+         return true;
+   }
+   return false;
+}
+
+inline const char* memory_category_name(MemoryCategory category)
+{
+   switch (category)
+   {
+   case MemoryCategory::Geometry: return "geometry";
+   case MemoryCategory::Texture: return "textures";
+   case MemoryCategory::RenderTarget: return "render targets";
+   case MemoryCategory::Streaming: return "streaming";
+   }
+   return "?";
+}
+
+// Bytes of a 2D texture, drivers pad three component formats to four and a full mip chain adds a third
+inline size_t texture_bytes(GLenum internal_format, int width, int height, bool mipmaps)
+{
+   size_t texel = 4;
+   switch (internal_format)
+   {
+   case GL_R8: texel = 1; break;
+   case GL_RG8: case GL_R16F: texel = 2; break;
+   case GL_RGBA16F: case GL_RG32F: texel = 8; break;
+   case GL_RGBA32F: texel = 16; break;
+   default: break;
+   }
+   const size_t base = texel * size_t(width) * size_t(height);
+   return mipmaps ? base + base / 3 : base;
+}
+
+using StreamableId = int;
+
+class GpuMemoryTracker
+{
+public:
+   // Creates the GL object of a streamable resource and returns its name
+   using Loader = std::function<unsigned()>;
+
+   explicit GpuMemoryTracker(size_t budget_bytes, size_t driver_reserve_bytes = size_t(64) << 20)
+      : budget_bytes(budget_bytes), driver_reserve_bytes(driver_reserve_bytes),
+        nvx_memory_info(has_gl_extension("GL_NVX_gpu_memory_info")), ati_meminfo(has_gl_extension("GL_ATI_meminfo"))
+   {
+      query_driver();
+   }
+
+   GpuMemoryTracker(const GpuMemoryTracker&) = delete;
+   GpuMemoryTracker& operator=(const GpuMemoryTracker&) = delete;
+
+   ~GpuMemoryTracker()
+   {
+      for (Streamable& resource : streamables)
+         if (resource.name)
+            delete_object(resource);
+   }
+
+   // Fixed buffer, bound to target and left bound
+   unsigned create_buffer(MemoryCategory category, GLenum target, size_t bytes, const void* data, GLenum usage)
+   {
+      unsigned buffer = 0;
+      glGenBuffers(1, &buffer);
+      glBindBuffer(target, buffer);
+      glBufferData(target, GLsizeiptr(bytes), data, usage);
+      record(false, buffer, category, bytes);
+      return buffer;
+   }
+
+   // Fixed 2D texture, left bound
+   unsigned create_texture(MemoryCategory category, GLenum internal_format, int width, int height, GLenum format, GLenum type,
+      const void* data, bool mipmaps)
+   {
+      unsigned texture = 0;
+      glGenTextures(1, &texture);
+      glBindTexture(GL_TEXTURE_2D, texture);
+      glTexImage2D(GL_TEXTURE_2D, 0, GLint(internal_format), width, height, 0, format, type, data);
+      if (mipmaps)
+         glGenerateMipmap(GL_TEXTURE_2D);
+      record(true, texture, category, texture_bytes(internal_format, width, height, mipmaps));
+      return texture;
+   }
+
+   // The data store of a fixed buffer was replaced, for glBufferData on an existing buffer
+   void resize_buffer(unsigned buffer, size_t bytes)
+   {
+      auto it = fixed.find({ false, buffer });
+      if (it == fixed.end())
+         return;
+      change(it->second.category, -std::ptrdiff_t(it->second.bytes));
+      it->second.bytes = bytes;
+      change(it->second.category, std::ptrdiff_t(bytes));
+   }
+
+   void delete_buffer(unsigned buffer)
+   {
+      forget(false, buffer);
+      glDeleteBuffers(1, &buffer);
+   }
+
+   void delete_texture(unsigned texture)
+   {
+      forget(true, texture);
+      glDeleteTextures(1, &texture);
+   }
+
+   // A streamable resource of a known size, nothing is created until it is first used
+   StreamableId add_streamable(MemoryCategory category, bool texture, size_t bytes, Loader loader)
+   {
+      streamables.push_back({ category, texture, std::move(loader), 0, bytes, 0 });
+      return StreamableId(streamables.size() - 1);
+   }
+
+   // Name of the resource for this frame, loading it first if it is not resident
+   unsigned use(StreamableId id)
+   {
+      Streamable& resource = streamables[size_t(id)];
+      resource.last_used = frame;
+      if (resource.name)
+         return resource.name;
+
+      // Make room before loading, so the peak stays within the budget too where possible
+      const size_t budget = get_effective_budget();
+      evict_to(budget > resource.bytes ? budget - resource.bytes : 0);
+      resource.name = resource.loader();
+      change(resource.category, std::ptrdiff_t(resource.bytes));
+      ++loads;
+      return resource.name;
+   }
+
+   bool is_resident(StreamableId id) const { return streamables[size_t(id)].name != 0; }
+
+   // Enforce the budget at the end of the frame, the resources of the next frame are the ones that get loaded
+   void end_frame()
+   {
+      if (frame % 60 == 0)
+         query_driver();
+      evict_to(get_effective_budget());
+      if (total_bytes > get_effective_budget())
+         ++frames_over_budget;
+      ++frame;
+   }
+
+   // The configured budget, lowered to what the driver says is free when it says anything
+   size_t get_effective_budget() const
+   {
+      if (driver_free_bytes < 0)
+         return budget_bytes;
+      const size_t free = size_t(driver_free_bytes) > driver_reserve_bytes ? size_t(driver_free_bytes) - driver_reserve_bytes : 0;
+      return std::min(budget_bytes, total_at_query + free);
+   }
+
+   void set_budget(size_t bytes) { budget_bytes = bytes; }
+
+   size_t get_total() const { return total_bytes; }
+   size_t get_peak() const { return peak_bytes; }
+   size_t get_category_total(MemoryCategory category) const { return category_bytes[int(category)]; }
+   size_t get_budget() const { return budget_bytes; }
+   size_t get_loads() const { return loads; }
+   size_t get_evictions() const { return evictions; }
+   size_t get_frames_over_budget() const { return frames_over_budget; }
+
+   // Free and total memory in bytes as the driver last reported them, negative when it does not report them
+   long long get_driver_free() const { return driver_free_bytes; }
+   long long get_driver_total() const { return driver_total_bytes; }
+
+private:
+   struct Fixed
+   {
+      MemoryCategory category;
+      size_t bytes;
+   };
+
+   struct Streamable
+   {
+      MemoryCategory category;
+      bool texture;
+      Loader loader;
+      unsigned name;
+      size_t bytes;
+      uint64_t last_used;
+   };
+
+   void record(bool texture, unsigned name, MemoryCategory category, size_t bytes)
+   {
+      fixed[{ texture, name }] = { category, bytes };
+      change(category, std::ptrdiff_t(bytes));
+   }
+
+   void forget(bool texture, unsigned name)
+   {
+      auto it = fixed.find({ texture, name });
+      if (it == fixed.end())
+         return;
+      change(it->second.category, -std::ptrdiff_t(it->second.bytes));
+      fixed.erase(it);
+   }
+
+   void change(MemoryCategory category, std::ptrdiff_t bytes)
+   {
+      category_bytes[int(category)] = size_t(std::ptrdiff_t(category_bytes[int(category)]) + bytes);
+      total_bytes = size_t(std::ptrdiff_t(total_bytes) + bytes);
+      peak_bytes = std::max(peak_bytes, total_bytes);
+   }
+
+   void delete_object(Streamable& resource)
+   {
+      if (resource.texture)
+         glDeleteTextures(1, &resource.name);
+      else
+         glDeleteBuffers(1, &resource.name);
+      resource.name = 0;
+   }
+
+   // Evict least recently used first, never anything used this frame
+   void evict_to(size_t limit)
+   {
+      if (total_bytes <= limit)
+         return;
+
+      std::vector<Streamable*> candidates;
+      for (Streamable& resource : streamables)
+         if (resource.name && resource.last_used != frame)
+            candidates.push_back(&resource);
+      std::sort(candidates.begin(), candidates.end(), [](const Streamable* a, const Streamable* b) { return a->last_used < b->last_used; });
+
+      for (Streamable* resource : candidates)
+      {
+         if (total_bytes <= limit)
+            break;
+         change(resource->category, -std::ptrdiff_t(resource->bytes));
+         delete_object(*resource);
+         ++evictions;
+      }
+   }
+
+   // Free memory is remembered with the total it was measured at, our own allocations since then come out of it
+   void query_driver()
+   {
+      if (nvx_memory_info)
+      {
+         int free_kb = 0, total_kb = 0;
+         glGetIntegerv(GL_GPU_MEMORY_INFO_CURRENT_AVAILABLE_VIDMEM_NVX, &free_kb);
+         glGetIntegerv(GL_GPU_MEMORY_INFO_TOTAL_AVAILABLE_MEMORY_NVX, &total_kb);
+         driver_free_bytes = (long long)free_kb * 1024;
+         driver_total_bytes = (long long)total_kb * 1024;
+      }
+      else if (ati_meminfo)
+      {
+         // Free pool, largest free block, free auxiliary pool, largest auxiliary block, in KB, there is no total
+         int texture_free[4] {};
+         glGetIntegerv(GL_TEXTURE_FREE_MEMORY_ATI, texture_free);
+         driver_free_bytes = (long long)texture_free[0] * 1024;
+      }
+      total_at_query = total_bytes;
+   }
+
+   size_t budget_bytes, driver_reserve_bytes;
+   bool nvx_memory_info, ati_meminfo;
+   size_t total_bytes = 0, peak_bytes = 0;
+   size_t category_bytes[memory_category_count] {};
+   std::map<std::pair<bool, unsigned>, Fixed> fixed;
+   std::vector<Streamable> streamables;
+   uint64_t frame = 0;
+   size_t loads = 0, evictions = 0, frames_over_budget = 0;
+   long long driver_free_bytes = -1, driver_total_bytes = -1;
+   size_t total_at_query = 0;
+};
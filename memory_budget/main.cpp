@@ -0,0 +1,272 @@
+#include <glad/glad.h>
+#include <GLFW/glfw3.h>
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <iostream>
+#include <vector>
+#include "gpu_memory.h"
+
+// Throw an exception and terminate GLFW
+void throw_ex(const char* msg)
+{
+   std::cout << msg << '\n';
+   glfwTerminate();
+   std::exit(-1);
+}
+
+// Resize callback function
+void framebuffer_size_callback(GLFWwindow*, int width, int height)
+{
+   // A minimized window has a 0x0 framebuffer, the render loop waits until it is restored
+   if (width == 0 || height == 0)
+      return;
+   glViewport(0, 0, width, height);
+}
+
+// Compile a shader and print the info log if it fails
+unsigned compile_shader(GLenum type, const char* source)
+{
+   unsigned shader = glCreateShader(type);
+   glShaderSource(shader, 1, &source, nullptr);
+   glCompileShader(shader);
+
+   int success = 0;
+   char info_log[512] = "\0";
+   glGetShaderiv(shader, GL_COMPILE_STATUS, &success);
+
+   if (!success)
+   {
+      glGetShaderInfoLog(shader, sizeof(info_log), nullptr, info_log);
+      std::cout << "Failed to compile the shader: " << info_log;
+   }
+   return shader;
+}
+
+// Link a vertex and a fragment shader into a program and clean up the shaders
+unsigned link_program(const char* vertex_source, const char* fragment_source)
+{
+   unsigned vertex_shader = compile_shader(GL_VERTEX_SHADER, vertex_source);
+   unsigned fragment_shader = compile_shader(GL_FRAGMENT_SHADER, fragment_source);
+
+   unsigned program = glCreateProgram();
+   glAttachShader(program, vertex_shader);
+   glAttachShader(program, fragment_shader);
+   glLinkProgram(program);
+
+   int success = 0;
+   char info_log[512] = "\0";
+   glGetProgramiv(program, GL_LINK_STATUS, &success);
+
+   if (!success)
+   {
+      glGetProgramInfoLog(program, sizeof(info_log), nullptr, info_log);
+      std::cout << "Failed to link the shader program: " << info_log;
+   }
+
+   glDeleteShader(vertex_shader);
+   glDeleteShader(fragment_shader);
+   return program;
+}
+
+// The world is a wrapping grid of texture tiles, far more of them than the budget holds
+constexpr int world_tiles = 16, tile_size = 256;
+
+// Pixels of one tile, a checker pattern in a color of its own
+std::vector<uint32_t> generate_tile(int tile)
+{
+   const uint32_t hash = uint32_t(tile) * 2654435761u;
+   const uint32_t r = 64 + (hash >> 8 & 127), g = 64 + (hash >> 16 & 127), b = 64 + (hash >> 24 & 127);
+
+   std::vector<uint32_t> pixels(size_t(tile_size) * tile_size);
+   for (int y = 0; y < tile_size; ++y)
+      for (int x = 0; x < tile_size; ++x)
+      {
+         const uint32_t shade = ((x / 32 + y / 32) & 1) ? 2 : 1;
+         const bool border = x < 4 || y < 4;
+         pixels[size_t(y) * tile_size + size_t(x)] = border ? 0xff202020u : 0xff000000u | (b * shade / 2) << 16 | (g * shade / 2) << 8 | (r * shade / 2);
+      }
+   return pixels;
+}
+
+// Main function
+int main()
+{
+   // Vertex shader, the unit quad is placed per tile
+   const char* vertex_shader_source =
+      "#version 330 core\n"
+      "layout (location = 0) in vec2 aPos;\n"
+      "uniform vec4 placement;\n"
+      "out vec2 TexCoord;\n"
+      "void main()\n"
+      "{\n"
+      "   TexCoord = aPos;\n"
+      "   gl_Position = vec4(placement.xy + aPos * placement.zw, 0.0, 1.0);\n"
+      "}\0";
+
+   // Fragment shader
+   const char* fragment_shader_source =
+      "#version 330 core\n"
+      "in vec2 TexCoord;\n"
+      "uniform sampler2D tile;\n"
+      "out vec4 FragColor;\n"
+      "void main()\n"
+      "{\n"
+      "   FragColor = texture(tile, TexCoord);\n"
+      "}\0";
+
+   // Initialize GLFW and tell it the version and profile
+   glfwInit();
+   glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
+   glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
+   glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+
+   // Initialize the window
+   GLFWwindow* window = glfwCreateWindow(800, 600, "Memory budget.", nullptr, nullptr);
+   if (!window)
+      throw_ex("Failed to create the window!");
+
+   // Set the current window
+   glfwMakeContextCurrent(window);
+
+   // Initialize GLAD
+   if (!gladLoadGLLoader(GLADloadproc(glfwGetProcAddress)))
+      throw_ex("Failed to initialize GLAD!");
+
+   // Set the viewport
+   glViewport(0, 0, 800, 600);
+
+   // Set window resize callback
+   glfwSetFramebufferSizeCallback(window, framebuffer_size_callback);
+
+   // Create the shader program
+   unsigned shader_program = link_program(vertex_shader_source, fragment_shader_source);
+   const int placement_location = glGetUniformLocation(shader_program, "placement");
+
+   // The scope makes sure the tracker deletes its resources before glfwTerminate
+   {
+      GpuMemoryTracker memory(size_t(32) << 20);
+      if (memory.get_driver_free() >= 0)
+         std::cout << "Driver reports " << memory.get_driver_free() / (1 << 20) << " MB free\n";
+      else
+         std::cout << "Driver reports no memory figures, the budget relies on our own accounting\n";
+
+      // Quad
+      const float vertices[] {
+         0.f, 0.f,  1.f, 0.f,  1.f, 1.f,
+         0.f, 0.f,  1.f, 1.f,  0.f, 1.f
+      };
+
+      unsigned VAO = 0;
+      glGenVertexArrays(1, &VAO);
+      glBindVertexArray(VAO);
+      unsigned VBO = memory.create_buffer(MemoryCategory::Geometry, GL_ARRAY_BUFFER, sizeof(vertices), vertices, GL_STATIC_DRAW);
+      glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, 2 * sizeof(float), (void*)0);
+      glEnableVertexAttribArray(0);
+      glBindVertexArray(0);
+
+      // Every tile is streamable, its texture is generated when it comes into view and it goes when it is evicted
+      std::vector<StreamableId> tiles;
+      for (int tile = 0; tile < world_tiles * world_tiles; ++tile)
+         tiles.push_back(memory.add_streamable(MemoryCategory::Streaming, true, texture_bytes(GL_RGBA8, tile_size, tile_size, true), [tile]
+         {
+            const std::vector<uint32_t> pixels = generate_tile(tile);
+            unsigned texture = 0;
+            glGenTextures(1, &texture);
+            glBindTexture(GL_TEXTURE_2D, texture);
+            glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, tile_size, tile_size, 0, GL_RGBA, GL_UNSIGNED_BYTE, pixels.data());
+            glGenerateMipmap(GL_TEXTURE_2D);
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+            return texture;
+         }));
+
+      std::cout << "World of " << tiles.size() << " tiles, "
+                << tiles.size() * texture_bytes(GL_RGBA8, tile_size, tile_size, true) / (1 << 20) << " MB if all were resident\n";
+
+      bool up_down = false, down_down = false;
+      double stats_time = glfwGetTime();
+      size_t last_loads = 0, last_evictions = 0;
+
+      // Create the render loop
+      while (!glfwWindowShouldClose(window))
+      {
+         // Check if the window should close
+         if (glfwGetKey(window, GLFW_KEY_ESCAPE) == GLFW_PRESS)
+            glfwSetWindowShouldClose(window, true);
+
+         // Up and down change the budget in steps of 8 MB
+         const bool up_pressed = glfwGetKey(window, GLFW_KEY_UP) == GLFW_PRESS;
+         const bool down_pressed = glfwGetKey(window, GLFW_KEY_DOWN) == GLFW_PRESS;
+         if (up_pressed && !up_down)
+            memory.set_budget(memory.get_budget() + (size_t(8) << 20));
+         if (down_pressed && !down_down)
+            memory.set_budget(std::max(memory.get_budget(), size_t(16) << 20) - (size_t(8) << 20));
+         up_down = up_pressed;
+         down_down = down_pressed;
+
+         // Nothing to render while minimized, the framebuffer is 0x0
+         int width = 0, height = 0;
+         glfwGetFramebufferSize(window, &width, &height);
+         if (width == 0 || height == 0)
+         {
+            glfwWaitEvents();
+            continue;
+         }
+
+         // The camera keeps panning across the wrapping world and swings back and forth, so tiles come back into view
+         const double time = glfwGetTime();
+         const double camera_x = time * 1.5, camera_y = std::sin(time * .4) * 12.0;
+         const double view_height = 4.0, view_width = view_height * width / height;
+
+         // Render
+         glClearColor(.5f, .5f, .5f, 1.f);
+         glClear(GL_COLOR_BUFFER_BIT);
+
+         glUseProgram(shader_program);
+         glBindVertexArray(VAO);
+         glActiveTexture(GL_TEXTURE0);
+         const int first_x = int(std::floor(camera_x - view_width / 2)), last_x = int(std::floor(camera_x + view_width / 2));
+         const int first_y = int(std::floor(camera_y - view_height / 2)), last_y = int(std::floor(camera_y + view_height / 2));
+         for (int y = first_y; y <= last_y; ++y)
+            for (int x = first_x; x <= last_x; ++x)
+            {
+               const int tile = (y % world_tiles + world_tiles) % world_tiles * world_tiles + (x % world_tiles + world_tiles) % world_tiles;
+               glBindTexture(GL_TEXTURE_2D, memory.use(tiles[size_t(tile)]));
+               glUniform4f(placement_location, float((x - camera_x) / view_width * 2.0), float((y - camera_y) / view_height * 2.0),
+                  float(2.0 / view_width), float(2.0 / view_height));
+               glDrawArrays(GL_TRIANGLES, 0, 6);
+            }
+         glBindVertexArray(0);
+
+         memory.end_frame();
+
+         // Swap buffers and check and call events
+         glfwSwapBuffers(window);
+         glfwPollEvents();
+
+         // Print the accounting once a second
+         if (time - stats_time >= 1.0)
+         {
+            std::cout << "Resident " << memory.get_total() / double(1 << 20) << " MB of " << memory.get_effective_budget() / double(1 << 20)
+                      << " MB budget, peak " << memory.get_peak() / double(1 << 20) << " MB (";
+            for (int category = 0; category < memory_category_count; ++category)
+               std::cout << (category ? ", " : "") << memory_category_name(MemoryCategory(category)) << ' '
+                         << memory.get_category_total(MemoryCategory(category)) / 1024.0 << " KB";
+            std::cout << "), " << memory.get_loads() - last_loads << " loads, " << memory.get_evictions() - last_evictions
+                      << " evictions, " << memory.get_frames_over_budget() << " frames over budget\n";
+            stats_time = time;
+            last_loads = memory.get_loads();
+            last_evictions = memory.get_evictions();
+         }
+      }
+
+      glDeleteVertexArrays(1, &VAO);
+      memory.delete_buffer(VBO);
+   }
+
+   // Clean up
+   glDeleteProgram(shader_program);
+   glfwTerminate();
+   return 0;
+}
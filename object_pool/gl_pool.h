@@ -0,0 +1,241 @@
+#pragma once
+#include <glad/glad.h>
+#include <cstddef>
+#include <deque>
+#include <vector>
+
+// Pooled GL object names with move-only RAII handles
+// Names are generated in batches, and objects dropped by their handle are only released once the GPU has
+// passed the fence of the frame they were dropped in, so nothing is destroyed while still in use.
+// Buffers are handed out again as they are, their data store is replaced by the next glBufferData.
+// VAOs and textures keep state tied to their first bind (attribute setup, texture target), so those are
+// deleted in one batched call instead and new names are generated in bulk.
+
+// Kinds of GL objects the pool manages
+enum class GLObjectKind
+{
+   Buffer,
+   VertexArray,
+   Texture,
+   Program
+};
+
+constexpr int gl_object_kind_count = 4;
+
+class GLObjectPool;
+
+// Owns one GL object name and gives it back to the pool when destroyed
+template <GLObjectKind Kind>
+class GLHandle
+{
+public:
+   GLHandle() = default;
+   GLHandle(GLObjectPool* pool, unsigned name) : pool(pool), name(name) {}
+
+   GLHandle(const GLHandle&) = delete;
+   GLHandle& operator=(const GLHandle&) = delete;
+
+   GLHandle(GLHandle&& other) noexcept : pool(other.pool), name(other.name)
+   {
+      other.name = 0;
+   }
+
+   GLHandle& operator=(GLHandle&& other) noexcept
+   {
+      if (this != &other)
+      {
+         reset();
+         pool = other.pool;
+         name = other.name;
+         other.name = 0;
+      }
+      return *this;
+   }
+
+   ~GLHandle() { reset(); }
+
+   unsigned get() const { return name; }
+   explicit operator bool() const { return name != 0; }
+
+   // Give the object back to the pool
+   void reset();
+
+private:
+   GLObjectPool* pool = nullptr;
+   unsigned name = 0;
+};
+
+using Buffer = GLHandle<GLObjectKind::Buffer>;
+using VertexArray = GLHandle<GLObjectKind::VertexArray>;
+using Texture = GLHandle<GLObjectKind::Texture>;
+using Program = GLHandle<GLObjectKind::Program>;
+
+class GLObjectPool
+{
+public:
+   // Driver calls made and objects handed out, to compare against plain glGen/glDelete
+   struct Stats
+   {
+      size_t driver_calls;
+      size_t created;
+      size_t released;
+   };
+
+   explicit GLObjectPool(unsigned batch_size = 256) : batch_size(batch_size) {}
+
+   GLObjectPool(const GLObjectPool&) = delete;
+   GLObjectPool& operator=(const GLObjectPool&) = delete;
+
+   // Release everything, the context has to still be current
+   ~GLObjectPool()
+   {
+      glFinish();
+      while (!in_flight.empty())
+         release_frame();
+
+      for (int kind = 0; kind < gl_object_kind_count; ++kind)
+      {
+         destroy(GLObjectKind(kind), retired[kind]);
+         destroy(GLObjectKind(kind), free_names[kind]);
+      }
+   }
+
+   Buffer create_buffer() { return Buffer(this, acquire(GLObjectKind::Buffer)); }
+   VertexArray create_vertex_array() { return VertexArray(this, acquire(GLObjectKind::VertexArray)); }
+   Texture create_texture() { return Texture(this, acquire(GLObjectKind::Texture)); }
+
+   // Programs can't be generated in bulk, but their deletion is still deferred
+   Program create_program()
+   {
+      ++stats.driver_calls;
+      ++stats.created;
+      return Program(this, glCreateProgram());
+   }
+
+   // Called by the handles, the object is released once the current frame's fence has passed
+   void retire(GLObjectKind kind, unsigned name)
+   {
+      retired[int(kind)].push_back(name);
+   }
+
+   // Fence everything retired this frame and release the frames the GPU is done with
+   // Call after the frame's draws have been submitted
+   void end_frame()
+   {
+      bool any_retired = false;
+      for (const std::vector<unsigned>& names : retired)
+         any_retired = any_retired || !names.empty();
+
+      if (any_retired)
+      {
+         RetiredFrame frame;
+         frame.fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+         for (int kind = 0; kind < gl_object_kind_count; ++kind)
+            frame.names[kind].swap(retired[kind]);
+         in_flight.push_back(std::move(frame));
+      }
+
+      // Poll without waiting, frames finish in order
+      while (!in_flight.empty())
+      {
+         const GLenum status = glClientWaitSync(in_flight.front().fence, 0, 0);
+         if (status != GL_ALREADY_SIGNALED && status != GL_CONDITION_SATISFIED)
+            break;
+         release_frame();
+      }
+   }
+
+   const Stats& get_stats() const { return stats; }
+
+private:
+   struct RetiredFrame
+   {
+      GLsync fence;
+      std::vector<unsigned> names[gl_object_kind_count];
+   };
+
+   unsigned acquire(GLObjectKind kind)
+   {
+      std::vector<unsigned>& names = free_names[int(kind)];
+      if (names.empty())
+      {
+         names.resize(batch_size);
+         generate(kind, names);
+      }
+
+      const unsigned name = names.back();
+      names.pop_back();
+      ++stats.created;
+      return name;
+   }
+
+   void release_frame()
+   {
+      RetiredFrame& frame = in_flight.front();
+      glDeleteSync(frame.fence);
+
+      for (int kind = 0; kind < gl_object_kind_count; ++kind)
+      {
+         std::vector<unsigned>& names = frame.names[kind];
+         stats.released += names.size();
+
+         // Recycle buffers while the free list is short, everything else is deleted in one call
+         if (GLObjectKind(kind) == GLObjectKind::Buffer)
+         {
+            std::vector<unsigned>& free_buffers = free_names[kind];
+            while (!names.empty() && free_buffers.size() < 4 * size_t(batch_size))
+            {
+               free_buffers.push_back(names.back());
+               names.pop_back();
+            }
+         }
+         destroy(GLObjectKind(kind), names);
+      }
+      in_flight.pop_front();
+   }
+
+   void generate(GLObjectKind kind, std::vector<unsigned>& names)
+   {
+      ++stats.driver_calls;
+      switch (kind)
+      {
+      case GLObjectKind::Buffer: glGenBuffers(GLsizei(names.size()), names.data()); break;
+      case GLObjectKind::VertexArray: glGenVertexArrays(GLsizei(names.size()), names.data()); break;
+      case GLObjectKind::Texture: glGenTextures(GLsizei(names.size()), names.data()); break;
+      case GLObjectKind::Program: break;
+      }
+   }
+
+   void destroy(GLObjectKind kind, std::vector<unsigned>& names)
+   {
+      if (names.empty())
+         return;
+
+      switch (kind)
+      {
+      case GLObjectKind::Buffer: glDeleteBuffers(GLsizei(names.size()), names.data()); ++stats.driver_calls; break;
+      case GLObjectKind::VertexArray: glDeleteVertexArrays(GLsizei(names.size()), names.data()); ++stats.driver_calls; break;
+      case GLObjectKind::Texture: glDeleteTextures(GLsizei(names.size()), names.data()); ++stats.driver_calls; break;
+      case GLObjectKind::Program:
+         for (unsigned name : names)
+            glDeleteProgram(name);
+         stats.driver_calls += names.size();
+         break;
+      }
+      names.clear();
+   }
+
+   unsigned batch_size;
+   std::vector<unsigned> free_names[gl_object_kind_count];
+   std::vector<unsigned> retired[gl_object_kind_count];
+   std::deque<RetiredFrame> in_flight;
+   Stats stats {};
+};
+
+template <GLObjectKind Kind>
+void GLHandle<Kind>::reset()
+{
+   if (name && pool)
+      pool->retire(Kind, name);
+   name = 0;
+}
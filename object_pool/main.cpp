@@ -0,0 +1,230 @@
+#include <glad/glad.h>
+#include <GLFW/glfw3.h>
+#include <cassert>
+#include <iostream>
+#include <random>
+#include <vector>
+#include "gl_pool.h"
+
+// Throw an exception and terminate GLFW
+void throw_ex(const char* msg)
+{
+   std::cout << msg << '\n';
+   glfwTerminate();
+   std::exit(-1);
+}
+
+// Resize callback function
+void framebuffer_size_callback(GLFWwindow*, int width, int height)
+{
+   assert(width > 0 && height > 0);
+   glViewport(0, 0, width, height);
+}
+
+// Compile a shader and print the info log if it fails
+unsigned compile_shader(GLenum type, const char* source)
+{
+   unsigned shader = glCreateShader(type);
+   glShaderSource(shader, 1, &source, nullptr);
+   glCompileShader(shader);
+
+   int success = 0;
+   char info_log[512] = "\0";
+   glGetShaderiv(shader, GL_COMPILE_STATUS, &success);
+
+   if (!success)
+   {
+      glGetShaderInfoLog(shader, sizeof(info_log), nullptr, info_log);
+      std::cout << "Failed to compile the shader: " << info_log;
+   }
+   return shader;
+}
+
+// Link a vertex and a fragment shader into a pooled program and clean up the shaders
+Program link_program(GLObjectPool& pool, const char* vertex_source, const char* fragment_source)
+{
+   unsigned vertex_shader = compile_shader(GL_VERTEX_SHADER, vertex_source);
+   unsigned fragment_shader = compile_shader(GL_FRAGMENT_SHADER, fragment_source);
+
+   Program program = pool.create_program();
+   glAttachShader(program.get(), vertex_shader);
+   glAttachShader(program.get(), fragment_shader);
+   glLinkProgram(program.get());
+
+   int success = 0;
+   char info_log[512] = "\0";
+   glGetProgramiv(program.get(), GL_LINK_STATUS, &success);
+
+   if (!success)
+   {
+      glGetProgramInfoLog(program.get(), sizeof(info_log), nullptr, info_log);
+      std::cout << "Failed to link the shader program: " << info_log;
+   }
+
+   glDeleteShader(vertex_shader);
+   glDeleteShader(fragment_shader);
+   return program;
+}
+
+// Triangle that only lives for one frame
+struct TransientTriangle
+{
+   Buffer VBO;
+   VertexArray VAO;
+};
+
+// Main function
+int main()
+{
+   // Vertex shader
+   const char* vertex_shader_source =
+      "#version 330 core\n"
+      "layout (location = 0) in vec3 aPos;\n"
+      "void main()\n"
+      "{\n"
+      "   gl_Position = vec4(aPos.x, aPos.y, aPos.z, 1.0);\n"
+      "}\0";
+
+   // Fragment shader
+   const char* fragment_shader_source =
+      "#version 330 core\n"
+      "out vec4 FragColor;\n"
+      "void main()\n"
+      "{\n"
+      "   FragColor = vec4(1.0f, 0.5f, 0.f, 1.0f);\n"
+      "}\0";
+
+   // Initialize GLFW and tell it the version and profile
+   glfwInit();
+   glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
+   glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
+   glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+
+   // Initialize the window
+   GLFWwindow* window = glfwCreateWindow(800, 600, "Object pool.", nullptr, nullptr);
+   if (!window)
+      throw_ex("Failed to create the window!");
+
+   // Set the current window
+   glfwMakeContextCurrent(window);
+
+   // Initialize GLAD
+   if (!gladLoadGLLoader(GLADloadproc(glfwGetProcAddress)))
+      throw_ex("Failed to initialize GLAD!");
+
+   // Set the viewport
+   glViewport(0, 0, 800, 600);
+
+   // Set window resize callback
+   glfwSetFramebufferSizeCallback(window, framebuffer_size_callback);
+
+   // The pool lives in its own scope so it is destroyed before glfwTerminate
+   {
+      GLObjectPool pool;
+      Program shader_program = link_program(pool, vertex_shader_source, fragment_shader_source);
+
+      // Churn: every frame creates, fills, draws and drops this many triangles
+      // P switches between the pool and one glGen/glDelete call per object
+      const int triangles_per_frame = 2000;
+      bool use_pool = true, p_down = false;
+      std::mt19937 random(7);
+      std::uniform_real_distribution<float> coordinate(-1.f, 1.f);
+      std::vector<TransientTriangle> triangles;
+      triangles.reserve(triangles_per_frame);
+
+      double stats_time = glfwGetTime();
+      int frames = 0;
+      size_t raw_driver_calls = 0;
+      GLObjectPool::Stats last_stats = pool.get_stats();
+
+      // Create the render loop
+      while (!glfwWindowShouldClose(window))
+      {
+         // Check if the window should close
+         if (glfwGetKey(window, GLFW_KEY_ESCAPE) == GLFW_PRESS)
+            glfwSetWindowShouldClose(window, true);
+
+         const bool p_pressed = glfwGetKey(window, GLFW_KEY_P) == GLFW_PRESS;
+         if (p_pressed && !p_down)
+            use_pool = !use_pool;
+         p_down = p_pressed;
+
+         // Render
+         glClearColor(.5f, .5f, .5f, 1.f);
+         glClear(GL_COLOR_BUFFER_BIT);
+         glUseProgram(shader_program.get());
+
+         for (int i = 0; i < triangles_per_frame; ++i)
+         {
+            const float x = coordinate(random), y = coordinate(random);
+            float vertices[]
+            {
+               x - .02f, y - .02f, 0.f,
+               x + .02f, y - .02f, 0.f,
+               x,        y + .02f, 0.f
+            };
+
+            unsigned VBO = 0, VAO = 0;
+            if (use_pool)
+            {
+               triangles.push_back({ pool.create_buffer(), pool.create_vertex_array() });
+               VBO = triangles.back().VBO.get();
+               VAO = triangles.back().VAO.get();
+            }
+            else
+            {
+               glGenBuffers(1, &VBO);
+               glGenVertexArrays(1, &VAO);
+               raw_driver_calls += 2;
+            }
+
+            // Fill the buffer and link vertex attributes
+            glBindVertexArray(VAO);
+            glBindBuffer(GL_ARRAY_BUFFER, VBO);
+            glBufferData(GL_ARRAY_BUFFER, sizeof(vertices), vertices, GL_STREAM_DRAW);
+            glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 3 * sizeof(float), (void*)0);
+            glEnableVertexAttribArray(0);
+
+            // Draw the triangle
+            glDrawArrays(GL_TRIANGLES, 0, 3);
+
+            if (!use_pool)
+            {
+               glDeleteVertexArrays(1, &VAO);
+               glDeleteBuffers(1, &VBO);
+               raw_driver_calls += 2;
+            }
+         }
+         glBindVertexArray(0);
+
+         // Drop this frame's objects and fence them
+         triangles.clear();
+         pool.end_frame();
+
+         // Print object churn and driver calls once a second
+         ++frames;
+         const double now = glfwGetTime();
+         if (now - stats_time >= 1.0)
+         {
+            const GLObjectPool::Stats& stats = pool.get_stats();
+            const size_t calls = use_pool ? stats.driver_calls - last_stats.driver_calls : raw_driver_calls;
+            std::cout << (use_pool ? "Pool: " : "Raw:  ") << frames * 2.0 * triangles_per_frame / (now - stats_time)
+                      << " objects/s, " << calls / (now - stats_time) << " gen/delete calls/s, "
+                      << (now - stats_time) * 1000.0 / frames << " ms/frame\n";
+
+            last_stats = stats;
+            raw_driver_calls = 0;
+            stats_time = now;
+            frames = 0;
+         }
+
+         // Swap buffers and check and call events
+         glfwSwapBuffers(window);
+         glfwPollEvents();
+      }
+   }
+
+   // Clean up
+   glfwTerminate();
+   return 0;
+}
@@ -0,0 +1,700 @@
+#include <glad/glad.h>
+#include <GLFW/glfw3.h>
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <cstring>
+#include <iostream>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "particle_system.h"
+
+// Throw an exception and terminate GLFW
+void throw_ex(const char* msg)
+{
+   std::cout << msg << '\n';
+   glfwTerminate();
+   std::exit(-1);
+}
+
+// Resize callback function
+void framebuffer_size_callback(GLFWwindow*, int width, int height)
+{
+   // A minimized window has a 0x0 framebuffer, the render loop waits until it is restored
+   if (width == 0 || height == 0)
+      return;
+   glViewport(0, 0, width, height);
+}
+
+// Compile a shader and print the info log if it fails
+unsigned compile_shader(GLenum type, const char* source)
+{
+   unsigned shader = glCreateShader(type);
+   glShaderSource(shader, 1, &source, nullptr);
+   glCompileShader(shader);
+
+   int success = 0;
+   char info_log[512] = "\0";
+   glGetShaderiv(shader, GL_COMPILE_STATUS, &success);
+
+   if (!success)
+   {
+      glGetShaderInfoLog(shader, sizeof(info_log), nullptr, info_log);
+      std::cout << "Failed to compile the shader: " << info_log;
+   }
+   return shader;
+}
+
+// Check the link status and print the info log if it failed
+void check_link(unsigned program)
+{
+   int success = 0;
+   char info_log[512] = "\0";
+   glGetProgramiv(program, GL_LINK_STATUS, &success);
+
+   if (!success)
+   {
+      glGetProgramInfoLog(program, sizeof(info_log), nullptr, info_log);
+      std::cout << "Failed to link the shader program: " << info_log;
+   }
+}
+
+// Link a vertex and a fragment shader into a program and clean up the shaders
+unsigned link_program(const char* vertex_source, const char* fragment_source)
+{
+   unsigned vertex_shader = compile_shader(GL_VERTEX_SHADER, vertex_source);
+   unsigned fragment_shader = compile_shader(GL_FRAGMENT_SHADER, fragment_source);
+
+   unsigned program = glCreateProgram();
+   glAttachShader(program, vertex_shader);
+   glAttachShader(program, fragment_shader);
+   glLinkProgram(program);
+   check_link(program);
+
+   glDeleteShader(vertex_shader);
+   glDeleteShader(fragment_shader);
+   return program;
+}
+
+// Whether the context exposes an extension, asked at runtime since the GLAD build may not know it at all
+bool has_gl_extension(const char* name)
+{
+   int count = 0;
+   glGetIntegerv(GL_NUM_EXTENSIONS, &count);
+   for (int i = 0; i < count; ++i)
+   {
+      const char* extension = reinterpret_cast<const char*>(glGetStringi(GL_EXTENSIONS, unsigned(i)));
+      if (extension && std::strcmp(extension, name) == 0)
+         return true;
+   }
+   return false;
+}
+
+// Vertex shader only program whose outputs are captured by transform feedback, interleaved in one buffer
+unsigned link_feedback_program(const char* vertex_source, const std::vector<const char*>& varyings)
+{
+   unsigned vertex_shader = compile_shader(GL_VERTEX_SHADER, vertex_source);
+
+   unsigned program = glCreateProgram();
+   glAttachShader(program, vertex_shader);
+   glTransformFeedbackVaryings(program, GLsizei(varyings.size()), varyings.data(), GL_INTERLEAVED_ATTRIBS);
+   glLinkProgram(program);
+   check_link(program);
+
+   glDeleteShader(vertex_shader);
+   return program;
+}
+
+// Persistent worker threads, jobs are a plain function pointer so dispatching never allocates
+class WorkerPool
+{
+public:
+   using Job = void (*)(void* context, unsigned worker, unsigned worker_count);
+
+   explicit WorkerPool(unsigned count)
+   {
+      for (unsigned i = 0; i < count; ++i)
+         threads.emplace_back([this, i] { loop(i); });
+   }
+
+   ~WorkerPool()
+   {
+      {
+         std::lock_guard<std::mutex> lock(mutex);
+         running = false;
+      }
+      start.notify_all();
+
+      for (std::thread& thread : threads)
+         thread.join();
+   }
+
+   // Run job on every worker and wait for all of them
+   void run(Job new_job, void* context)
+   {
+      std::unique_lock<std::mutex> lock(mutex);
+      job = new_job;
+      job_context = context;
+      remaining = unsigned(threads.size());
+      ++generation;
+      start.notify_all();
+      done.wait(lock, [this] { return remaining == 0; });
+   }
+
+   unsigned size() const { return unsigned(threads.size()); }
+
+private:
+   void loop(unsigned index)
+   {
+      unsigned seen = 0;
+      while (true)
+      {
+         Job current = nullptr;
+         void* context = nullptr;
+         {
+            std::unique_lock<std::mutex> lock(mutex);
+            start.wait(lock, [&] { return !running || generation != seen; });
+            if (!running)
+               return;
+            seen = generation;
+            current = job;
+            context = job_context;
+         }
+
+         current(context, index, unsigned(threads.size()));
+
+         std::lock_guard<std::mutex> lock(mutex);
+         if (--remaining == 0)
+            done.notify_one();
+      }
+   }
+
+   std::vector<std::thread> threads;
+   std::mutex mutex;
+   std::condition_variable start, done;
+   Job job = nullptr;
+   void* job_context = nullptr;
+   unsigned generation = 0;
+   unsigned remaining = 0;
+   bool running = true;
+};
+
+// Ring of three regions in one buffer, the CPU fills one while the GPU may still be drawing from the others
+// With GL 4.4 or ARB_buffer_storage the buffer is mapped once, persistently and coherently. On plain 3.3 the
+// region is mapped unsynchronized every frame instead, which is just as safe because either way the fence of
+// the region's last draw is waited on before it is written again.
+class StreamBuffer
+{
+public:
+   static constexpr int region_count = 3;
+
+   StreamBuffer(size_t region_bytes, bool persistent) : region_bytes(region_bytes), persistent(persistent)
+   {
+      glGenBuffers(1, &buffer);
+      glBindBuffer(GL_ARRAY_BUFFER, buffer);
+      if (persistent)
+      {
+         const GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+         glBufferStorage(GL_ARRAY_BUFFER, GLsizeiptr(region_bytes * region_count), nullptr, flags);
+         mapped = static_cast<unsigned char*>(glMapBufferRange(GL_ARRAY_BUFFER, 0, GLsizeiptr(region_bytes * region_count), flags));
+
+         // Immutable storage can't be respecified, a buffer that won't map persistently is replaced by a plain one
+         if (!mapped)
+         {
+            glDeleteBuffers(1, &buffer);
+            glGenBuffers(1, &buffer);
+            glBindBuffer(GL_ARRAY_BUFFER, buffer);
+            this->persistent = false;
+         }
+      }
+      if (!this->persistent)
+         glBufferData(GL_ARRAY_BUFFER, GLsizeiptr(region_bytes * region_count), nullptr, GL_STREAM_DRAW);
+      glBindBuffer(GL_ARRAY_BUFFER, 0);
+   }
+
+   StreamBuffer(const StreamBuffer&) = delete;
+   StreamBuffer& operator=(const StreamBuffer&) = delete;
+
+   ~StreamBuffer()
+   {
+      for (GLsync& fence : fences)
+         if (fence)
+            glDeleteSync(fence);
+      if (persistent)
+      {
+         glBindBuffer(GL_ARRAY_BUFFER, buffer);
+         glUnmapBuffer(GL_ARRAY_BUFFER);
+         glBindBuffer(GL_ARRAY_BUFFER, 0);
+      }
+      glDeleteBuffers(1, &buffer);
+   }
+
+   // Memory of the current region, once the GPU is done with it
+   // Null if the driver could not map it, then the frame has nothing to write to and unmap must not be called
+   float* map()
+   {
+      if (GLsync& fence = fences[current])
+      {
+         while (glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, 1000000000) == GL_TIMEOUT_EXPIRED)
+            ;
+         glDeleteSync(fence);
+         fence = nullptr;
+      }
+
+      if (persistent)
+         return reinterpret_cast<float*>(mapped + offset());
+
+      glBindBuffer(GL_ARRAY_BUFFER, buffer);
+      void* region = glMapBufferRange(GL_ARRAY_BUFFER, GLintptr(offset()), GLsizeiptr(region_bytes),
+         GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_RANGE_BIT | GL_MAP_UNSYNCHRONIZED_BIT);
+      glBindBuffer(GL_ARRAY_BUFFER, 0);
+      return static_cast<float*>(region);
+   }
+
+   // Done writing, returns the byte offset of the region for the draw
+   size_t unmap()
+   {
+      if (!persistent)
+      {
+         glBindBuffer(GL_ARRAY_BUFFER, buffer);
+         glUnmapBuffer(GL_ARRAY_BUFFER);
+         glBindBuffer(GL_ARRAY_BUFFER, 0);
+      }
+      return offset();
+   }
+
+   // After the last draw that reads the region, moves on to the next one
+   void fence()
+   {
+      fences[current] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+      current = (current + 1) % region_count;
+   }
+
+   unsigned get_buffer() const { return buffer; }
+   bool is_persistent() const { return persistent; }
+
+private:
+   size_t offset() const { return region_bytes * size_t(current); }
+
+   unsigned buffer = 0;
+   size_t region_bytes;
+   bool persistent;
+   unsigned char* mapped = nullptr;
+   int current = 0;
+   GLsync fences[region_count] {};
+};
+
+// One frame of the CPU simulation, every worker takes a contiguous share of the particles
+struct SimulationJob
+{
+   ParticleSystem* system;
+   float dt;
+   uint32_t seed;
+   float* out;
+   std::vector<size_t> emitted;
+};
+
+void simulate(void* context, unsigned worker, unsigned worker_count)
+{
+   SimulationJob& job = *static_cast<SimulationJob*>(context);
+   const size_t count = job.system->size(), blocks = count / 16;
+   const size_t begin = blocks * worker / worker_count * 16, end = blocks * (worker + 1) / worker_count * 16;
+
+   // Emit and integrate a chunk at a time, so the chunk is still in cache for the second pass
+   size_t emitted = 0;
+   for (size_t chunk = begin; chunk < end; chunk += 4096)
+   {
+      const size_t chunk_end = std::min(chunk + 4096, end);
+      emitted += job.system->emit(chunk, chunk_end, job.seed);
+      job.system->integrate(chunk, chunk_end, job.dt, job.out, job.out + count, job.out + 2 * count, job.out + 3 * count);
+   }
+   job.emitted[worker] = emitted;
+}
+
+// Same fountain on the GPU, the state ping-pongs between two buffers through transform feedback
+const char* feedback_shader_source =
+   "#version 330 core\n"
+   "layout (location = 0) in vec4 aPosLife;\n"
+   "layout (location = 1) in vec4 aVelocity;\n"
+   "uniform float dt;\n"
+   "uniform uint seed;\n"
+   "out vec4 PosLife;\n"
+   "out vec4 Velocity;\n"
+   "// The hash and constants of particle_system.h\n"
+   "uint hash(uint x)\n"
+   "{\n"
+   "   x ^= x >> 16u;\n"
+   "   x *= 0x7feb352du;\n"
+   "   x ^= x >> 15u;\n"
+   "   x *= 0x846ca68bu;\n"
+   "   x ^= x >> 16u;\n"
+   "   return x;\n"
+   "}\n"
+   "float unit(uint h)\n"
+   "{\n"
+   "   return float(h >> 8u) / 16777216.0;\n"
+   "}\n"
+   "void main()\n"
+   "{\n"
+   "   vec3 position = aPosLife.xyz;\n"
+   "   vec3 velocity = aVelocity.xyz;\n"
+   "   float life = aPosLife.w;\n"
+   "   if (life <= 0.0)\n"
+   "   {\n"
+   "      uint h = hash(uint(gl_VertexID) ^ seed);\n"
+   "      float angle = unit(h) * 6.2831853;\n"
+   "      float radial = unit(hash(h + 1u)) * 1.5;\n"
+   "      position = vec3(0.0);\n"
+   "      velocity = vec3(cos(angle) * radial, 4.0 + 2.0 * unit(hash(h + 2u)), sin(angle) * radial);\n"
+   "      life = 2.0 + 2.0 * unit(hash(h + 3u));\n"
+   "   }\n"
+   "   velocity.y -= 9.81 * dt;\n"
+   "   position += velocity * dt;\n"
+   "   life -= dt;\n"
+   "   if (position.y < 0.0)\n"
+   "   {\n"
+   "      position.y = -position.y;\n"
+   "      velocity.y *= -0.5;\n"
+   "   }\n"
+   "   PosLife = vec4(position, life);\n"
+   "   Velocity = vec4(velocity, 0.0);\n"
+   "}\0";
+
+class FeedbackParticles
+{
+public:
+   // Starts from the state of a CPU system
+   explicit FeedbackParticles(const ParticleSystem& initial) : count(initial.size())
+   {
+      std::vector<float> state(count * 8);
+      initial.write_interleaved(state.data());
+
+      glGenBuffers(2, buffers);
+      glGenVertexArrays(2, VAOs);
+      for (int i = 0; i < 2; ++i)
+      {
+         glBindVertexArray(VAOs[i]);
+         glBindBuffer(GL_ARRAY_BUFFER, buffers[i]);
+         glBufferData(GL_ARRAY_BUFFER, GLsizeiptr(state.size() * sizeof(float)), state.data(), GL_DYNAMIC_COPY);
+         glVertexAttribPointer(0, 4, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void*)0);
+         glEnableVertexAttribArray(0);
+         glVertexAttribPointer(1, 4, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void*)(4 * sizeof(float)));
+         glEnableVertexAttribArray(1);
+      }
+      glBindVertexArray(0);
+      glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+      program = link_feedback_program(feedback_shader_source, { "PosLife", "Velocity" });
+      dt_location = glGetUniformLocation(program, "dt");
+      seed_location = glGetUniformLocation(program, "seed");
+   }
+
+   FeedbackParticles(const FeedbackParticles&) = delete;
+   FeedbackParticles& operator=(const FeedbackParticles&) = delete;
+
+   ~FeedbackParticles()
+   {
+      glDeleteProgram(program);
+      glDeleteVertexArrays(2, VAOs);
+      glDeleteBuffers(2, buffers);
+   }
+
+   // One step, nothing is rasterized, the vertex shader's outputs go straight into the other buffer
+   void update(float dt, uint32_t seed)
+   {
+      glUseProgram(program);
+      glUniform1f(dt_location, dt);
+      glUniform1ui(seed_location, seed);
+
+      glEnable(GL_RASTERIZER_DISCARD);
+      glBindVertexArray(VAOs[current]);
+      glBindBufferBase(GL_TRANSFORM_FEEDBACK_BUFFER, 0, buffers[1 - current]);
+      glBeginTransformFeedback(GL_POINTS);
+      glDrawArrays(GL_POINTS, 0, GLsizei(count));
+      glEndTransformFeedback();
+      glBindBufferBase(GL_TRANSFORM_FEEDBACK_BUFFER, 0, 0);
+      glBindVertexArray(0);
+      glDisable(GL_RASTERIZER_DISCARD);
+      current = 1 - current;
+   }
+
+   // VAO of the latest state, position and life at location 0
+   unsigned get_vao() const { return VAOs[current]; }
+   size_t size() const { return count; }
+
+private:
+   size_t count;
+   unsigned buffers[2] {};
+   unsigned VAOs[2] {};
+   unsigned program = 0;
+   int dt_location = -1, seed_location = -1;
+   int current = 0;
+};
+
+// Main function
+int main()
+{
+   // Draw shaders, the CPU mode streams one array per field, the GPU mode reads its interleaved state
+   const char* cpu_vertex_shader_source =
+      "#version 330 core\n"
+      "layout (location = 0) in float aX;\n"
+      "layout (location = 1) in float aY;\n"
+      "layout (location = 2) in float aZ;\n"
+      "layout (location = 3) in float aLife;\n"
+      "uniform float angle;\n"
+      "uniform float aspect;\n"
+      "out float Life;\n"
+      "void main()\n"
+      "{\n"
+      "   vec3 p = vec3(aX, aY, aZ);\n"
+      "   p.xz = mat2(cos(angle), sin(angle), -sin(angle), cos(angle)) * p.xz;\n"
+      "   Life = aLife;\n"
+      "   gl_Position = vec4(p.x * 2.0 / aspect, (p.y - 1.0) * 2.0, 0.0, p.z + 6.0);\n"
+      "}\0";
+
+   const char* gpu_vertex_shader_source =
+      "#version 330 core\n"
+      "layout (location = 0) in vec4 aPosLife;\n"
+      "uniform float angle;\n"
+      "uniform float aspect;\n"
+      "out float Life;\n"
+      "void main()\n"
+      "{\n"
+      "   vec3 p = aPosLife.xyz;\n"
+      "   p.xz = mat2(cos(angle), sin(angle), -sin(angle), cos(angle)) * p.xz;\n"
+      "   Life = aPosLife.w;\n"
+      "   gl_Position = vec4(p.x * 2.0 / aspect, (p.y - 1.0) * 2.0, 0.0, p.z + 6.0);\n"
+      "}\0";
+
+   // Fragment shader, additive so dense regions glow
+   const char* fragment_shader_source =
+      "#version 330 core\n"
+      "in float Life;\n"
+      "out vec4 FragColor;\n"
+      "void main()\n"
+      "{\n"
+      "   vec3 color = mix(vec3(1.0, 0.25, 0.05), vec3(1.0, 0.85, 0.4), clamp(Life / 3.0, 0.0, 1.0));\n"
+      "   FragColor = vec4(color * 0.12, 1.0);\n"
+      "}\0";
+
+   // Initialize GLFW and tell it the version and profile
+   glfwInit();
+   glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
+   glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
+   glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+
+   // Initialize the window
+   GLFWwindow* window = glfwCreateWindow(800, 600, "Particles.", nullptr, nullptr);
+   if (!window)
+      throw_ex("Failed to create the window!");
+
+   // Set the current window
+   glfwMakeContextCurrent(window);
+
+   // Initialize GLAD
+   if (!gladLoadGLLoader(GLADloadproc(glfwGetProcAddress)))
+      throw_ex("Failed to initialize GLAD!");
+
+   // Set the viewport
+   glViewport(0, 0, 800, 600);
+
+   // Set window resize callback
+   glfwSetFramebufferSizeCallback(window, framebuffer_size_callback);
+
+   const bool persistent = GLAD_GL_VERSION_4_4 || has_gl_extension("GL_ARB_buffer_storage");
+   const unsigned worker_count = std::max(1u, std::thread::hardware_concurrency());
+#if PARTICLES_AVX
+   const char* simd = "AVX";
+#elif PARTICLES_SSE
+   const char* simd = "SSE";
+#else
+   const char* simd = "scalar";
+#endif
+   std::cout << simd << " integration on " << worker_count << " workers, "
+             << (persistent ? "persistently mapped stream buffer\n" : "unsynchronized mapping of the stream buffer\n");
+
+   // Create the shader programs
+   unsigned cpu_program = link_program(cpu_vertex_shader_source, fragment_shader_source);
+   unsigned gpu_program = link_program(gpu_vertex_shader_source, fragment_shader_source);
+
+   // The scope makes sure the particle buffers are deleted before glfwTerminate
+   {
+      WorkerPool pool(worker_count);
+      // One emit count per worker, sized from the pool so any number of hardware threads fits
+      SimulationJob job {};
+      job.emitted.resize(pool.size());
+      const float dt = 1.f / 60.f;
+
+      // Benchmark one simulation step of each mode at a few sizes, without drawing, from that the count that fits a 60 Hz frame
+      for (size_t count : { size_t(1) << 18, size_t(1) << 20, size_t(1) << 21 })
+      {
+         ParticleSystem system(count);
+         double cpu_ms = 0.0, gpu_ms = 0.0;
+         int measured = 0;
+         {
+            StreamBuffer stream(system.size() * 4 * sizeof(float), persistent);
+            for (int frame = 0; frame < 13; ++frame)
+            {
+               const auto start = std::chrono::steady_clock::now();
+               job.system = &system;
+               job.dt = dt;
+               job.seed = uint32_t(frame) * 2654435761u;
+               job.out = stream.map();
+               if (!job.out)
+                  continue;
+               pool.run(simulate, &job);
+               stream.unmap();
+               stream.fence();
+               if (frame >= 3)
+               {
+                  cpu_ms += std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+                  ++measured;
+               }
+            }
+            cpu_ms /= std::max(measured, 1);
+         }
+         {
+            FeedbackParticles feedback(system);
+            feedback.update(dt, 1);
+            glFinish();
+            const auto start = std::chrono::steady_clock::now();
+            for (int frame = 0; frame < 10; ++frame)
+               feedback.update(dt, uint32_t(frame) * 2654435761u);
+            glFinish();
+            gpu_ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count() / 10.0;
+         }
+
+         std::cout << system.size() << " particles: CPU ";
+         if (measured)
+            std::cout << cpu_ms << " ms/step (" << size_t(system.size() * 16.667 / cpu_ms) << " per 60 Hz frame)";
+         else
+            std::cout << "not measured, the stream buffer could not be mapped";
+         std::cout << ", transform feedback " << gpu_ms << " ms/step (" << size_t(system.size() * 16.667 / gpu_ms) << " per 60 Hz frame)\n";
+      }
+
+      // A million particles in both modes, G switches between them
+      ParticleSystem system(size_t(1) << 20);
+      StreamBuffer stream(system.size() * 4 * sizeof(float), persistent);
+      FeedbackParticles feedback(system);
+
+      unsigned cpu_VAO = 0;
+      glGenVertexArrays(1, &cpu_VAO);
+
+      const int cpu_angle_location = glGetUniformLocation(cpu_program, "angle");
+      const int cpu_aspect_location = glGetUniformLocation(cpu_program, "aspect");
+      const int gpu_angle_location = glGetUniformLocation(gpu_program, "angle");
+      const int gpu_aspect_location = glGetUniformLocation(gpu_program, "aspect");
+
+      bool gpu = false, g_down = false;
+      double stats_time = glfwGetTime(), simulate_ms = 0.0;
+      size_t emitted = 0;
+      int frames = 0;
+      uint32_t frame = 0;
+
+      // Create the render loop
+      while (!glfwWindowShouldClose(window))
+      {
+         // Check if the window should close
+         if (glfwGetKey(window, GLFW_KEY_ESCAPE) == GLFW_PRESS)
+            glfwSetWindowShouldClose(window, true);
+
+         const bool g_pressed = glfwGetKey(window, GLFW_KEY_G) == GLFW_PRESS;
+         if (g_pressed && !g_down)
+            gpu = !gpu;
+         g_down = g_pressed;
+
+         // Nothing to render while minimized, the framebuffer is 0x0
+         int width = 0, height = 0;
+         glfwGetFramebufferSize(window, &width, &height);
+         if (width == 0 || height == 0)
+         {
+            glfwWaitEvents();
+            continue;
+         }
+
+         const float angle = float(glfwGetTime()) * .2f, aspect = float(width) / float(height);
+         const uint32_t seed = ++frame * 2654435761u;
+
+         // Render
+         glClearColor(.5f, .5f, .5f, 1.f);
+         glClear(GL_COLOR_BUFFER_BIT);
+         glEnable(GL_BLEND);
+         glBlendFunc(GL_ONE, GL_ONE);
+
+         const auto start = std::chrono::steady_clock::now();
+         if (gpu)
+         {
+            feedback.update(dt, seed);
+            glUseProgram(gpu_program);
+            glUniform1f(gpu_angle_location, angle);
+            glUniform1f(gpu_aspect_location, aspect);
+            glBindVertexArray(feedback.get_vao());
+            glDrawArrays(GL_POINTS, 0, GLsizei(feedback.size()));
+         }
+         else
+         {
+            // Simulate straight into this frame's region of the stream buffer, a frame the driver can't map is skipped
+            job.system = &system;
+            job.dt = dt;
+            job.seed = seed;
+            job.out = stream.map();
+            if (job.out)
+            {
+               pool.run(simulate, &job);
+               const size_t offset = stream.unmap();
+               for (unsigned worker = 0; worker < pool.size(); ++worker)
+                  emitted += job.emitted[worker];
+
+               // The four fields are four tightly packed attribute streams
+               glBindVertexArray(cpu_VAO);
+               glBindBuffer(GL_ARRAY_BUFFER, stream.get_buffer());
+               for (unsigned field = 0; field < 4; ++field)
+               {
+                  glVertexAttribPointer(field, 1, GL_FLOAT, GL_FALSE, sizeof(float), (void*)(offset + field * system.size() * sizeof(float)));
+                  glEnableVertexAttribArray(field);
+               }
+               glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+               glUseProgram(cpu_program);
+               glUniform1f(cpu_angle_location, angle);
+               glUniform1f(cpu_aspect_location, aspect);
+               glDrawArrays(GL_POINTS, 0, GLsizei(system.size()));
+               stream.fence();
+            }
+         }
+         simulate_ms += std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+         glBindVertexArray(0);
+         glDisable(GL_BLEND);
+
+         // Swap buffers and check and call events
+         glfwSwapBuffers(window);
+         glfwPollEvents();
+
+         // Print the simulation and frame time once a second
+         ++frames;
+         const double now = glfwGetTime();
+         if (now - stats_time >= 1.0)
+         {
+            std::cout << (gpu ? "Transform feedback: " : "CPU: ") << system.size() << " particles, " << simulate_ms / frames
+                      << " ms to simulate and submit, " << (now - stats_time) * 1000.0 / frames << " ms/frame";
+            if (!gpu)
+               std::cout << ", " << emitted / (now - stats_time) << " emitted/s";
+            std::cout << '\n';
+            stats_time = now;
+            simulate_ms = 0.0;
+            emitted = 0;
+            frames = 0;
+         }
+      }
+
+      glDeleteVertexArrays(1, &cpu_VAO);
+   }
+
+   // Clean up
+   glDeleteProgram(cpu_program);
+   glDeleteProgram(gpu_program);
+   glfwTerminate();
+   return 0;
+}
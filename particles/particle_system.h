@@ -0,0 +1,261 @@
+#pragma once
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <initializer_list>
+#include <new>
+
+#if !defined(PARTICLES_FORCE_SCALAR)
+#  if defined(__AVX__)
+#    define PARTICLES_AVX 1
+#    include <immintrin.h>
+#  elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#    define PARTICLES_SSE 1
+#    include <immintrin.h>
+#  endif
+#endif
+
+// CPU particle simulation in structure-of-arrays form
+// Every field is its own 64-byte aligned array, so the integration loads and stores whole registers of one
+// field and the loop has no shuffles: 8 particles per step with AVX, 4 with SSE, one without either.
+// Define PARTICLES_FORCE_SCALAR to disable intrinsics. Particles never die and get born, a dead particle is
+// re-emitted in place, so the arrays stay dense and any range of them can go to any thread.
+
+// Fountain parameters, shared with the transform feedback shader so both modes look the same
+constexpr float particle_gravity = -9.81f;
+constexpr float particle_bounce = -.5f;
+constexpr float particle_min_life = 2.f, particle_max_life = 4.f;
+
+class ParticleSystem
+{
+public:
+   // The count is rounded up to a whole number of cache lines of every field
+   explicit ParticleSystem(size_t requested) : count((requested + 15) / 16 * 16)
+   {
+      // The aligned allocators return null instead of throwing, so give back what did succeed and fail like new
+      bool allocated = true;
+      for (float** field : { &px, &py, &pz, &vx, &vy, &vz, &life })
+         allocated = (*field = allocate(count)) != nullptr && allocated;
+      if (!allocated)
+      {
+         for (float* field : { px, py, pz, vx, vy, vz, life })
+            release(field);
+         throw std::bad_alloc();
+      }
+
+      // Start with a spread of ages, otherwise every particle would be born and die on the same frame
+      for (size_t i = 0; i < count; ++i)
+      {
+         spawn(i, hash(uint32_t(i) ^ 0x9e3779b9u));
+         const float age = unit(hash(uint32_t(i) * 3u + 1u)) * life[i];
+         px[i] += vx[i] * age;
+         py[i] = std::fabs(py[i] + (vy[i] + .5f * particle_gravity * age) * age);
+         vy[i] += particle_gravity * age;
+         life[i] -= age;
+      }
+   }
+
+   ParticleSystem(const ParticleSystem&) = delete;
+   ParticleSystem& operator=(const ParticleSystem&) = delete;
+
+   ~ParticleSystem()
+   {
+      for (float* field : { px, py, pz, vx, vy, vz, life })
+         release(field);
+   }
+
+   size_t size() const { return count; }
+
+   // Re-emit the dead particles of [begin, end), returns how many there were
+   size_t emit(size_t begin, size_t end, uint32_t seed)
+   {
+      size_t emitted = 0;
+      for (size_t i = begin; i < end; ++i)
+         if (life[i] <= 0.f)
+         {
+            spawn(i, hash(uint32_t(i) ^ seed));
+            ++emitted;
+         }
+      return emitted;
+   }
+
+   // Advance [begin, end) by dt and write position and life to four output streams, begin and end multiples of 16
+   // The outputs are usually mapped GPU memory that is never read, so they get non-temporal stores when aligned
+   void integrate(size_t begin, size_t end, float dt, float* out_x, float* out_y, float* out_z, float* out_life)
+   {
+      size_t i = begin;
+#if PARTICLES_AVX
+      const bool aligned = ((reinterpret_cast<uintptr_t>(out_x) | reinterpret_cast<uintptr_t>(out_y)
+         | reinterpret_cast<uintptr_t>(out_z) | reinterpret_cast<uintptr_t>(out_life)) & 31) == 0;
+      const __m256 step = _mm256_set1_ps(dt), fall = _mm256_set1_ps(particle_gravity * dt);
+      const __m256 bounce = _mm256_set1_ps(particle_bounce), zero = _mm256_setzero_ps(), sign = _mm256_set1_ps(-0.f);
+      for (; i + 8 <= end; i += 8)
+      {
+         __m256 y_velocity = _mm256_add_ps(_mm256_load_ps(vy + i), fall);
+         const __m256 x = madd(_mm256_load_ps(vx + i), step, _mm256_load_ps(px + i));
+         __m256 y = madd(y_velocity, step, _mm256_load_ps(py + i));
+         const __m256 z = madd(_mm256_load_ps(vz + i), step, _mm256_load_ps(pz + i));
+         const __m256 remaining = _mm256_sub_ps(_mm256_load_ps(life + i), step);
+
+         // Below the floor: mirror the position and bounce with damping
+         const __m256 below = _mm256_cmp_ps(y, zero, _CMP_LT_OQ);
+         y = _mm256_blendv_ps(y, _mm256_xor_ps(y, sign), below);
+         y_velocity = _mm256_blendv_ps(y_velocity, _mm256_mul_ps(y_velocity, bounce), below);
+
+         _mm256_store_ps(px + i, x);
+         _mm256_store_ps(py + i, y);
+         _mm256_store_ps(pz + i, z);
+         _mm256_store_ps(vy + i, y_velocity);
+         _mm256_store_ps(life + i, remaining);
+
+         if (aligned)
+         {
+            _mm256_stream_ps(out_x + i, x);
+            _mm256_stream_ps(out_y + i, y);
+            _mm256_stream_ps(out_z + i, z);
+            _mm256_stream_ps(out_life + i, remaining);
+         }
+         else
+         {
+            _mm256_storeu_ps(out_x + i, x);
+            _mm256_storeu_ps(out_y + i, y);
+            _mm256_storeu_ps(out_z + i, z);
+            _mm256_storeu_ps(out_life + i, remaining);
+         }
+      }
+      _mm_sfence();
+#elif PARTICLES_SSE
+      const bool aligned = ((reinterpret_cast<uintptr_t>(out_x) | reinterpret_cast<uintptr_t>(out_y)
+         | reinterpret_cast<uintptr_t>(out_z) | reinterpret_cast<uintptr_t>(out_life)) & 15) == 0;
+      const __m128 step = _mm_set1_ps(dt), fall = _mm_set1_ps(particle_gravity * dt);
+      const __m128 bounce = _mm_set1_ps(particle_bounce), zero = _mm_setzero_ps(), sign = _mm_set1_ps(-0.f);
+      for (; i + 4 <= end; i += 4)
+      {
+         __m128 y_velocity = _mm_add_ps(_mm_load_ps(vy + i), fall);
+         const __m128 x = _mm_add_ps(_mm_mul_ps(_mm_load_ps(vx + i), step), _mm_load_ps(px + i));
+         __m128 y = _mm_add_ps(_mm_mul_ps(y_velocity, step), _mm_load_ps(py + i));
+         const __m128 z = _mm_add_ps(_mm_mul_ps(_mm_load_ps(vz + i), step), _mm_load_ps(pz + i));
+         const __m128 remaining = _mm_sub_ps(_mm_load_ps(life + i), step);
+
+         // Below the floor: mirror the position and bounce with damping, SSE2 has no blend so select with masks
+         const __m128 below = _mm_cmplt_ps(y, zero);
+         y = _mm_xor_ps(y, _mm_and_ps(below, sign));
+         y_velocity = _mm_or_ps(_mm_andnot_ps(below, y_velocity), _mm_and_ps(below, _mm_mul_ps(y_velocity, bounce)));
+
+         _mm_store_ps(px + i, x);
+         _mm_store_ps(py + i, y);
+         _mm_store_ps(pz + i, z);
+         _mm_store_ps(vy + i, y_velocity);
+         _mm_store_ps(life + i, remaining);
+
+         if (aligned)
+         {
+            _mm_stream_ps(out_x + i, x);
+            _mm_stream_ps(out_y + i, y);
+            _mm_stream_ps(out_z + i, z);
+            _mm_stream_ps(out_life + i, remaining);
+         }
+         else
+         {
+            _mm_storeu_ps(out_x + i, x);
+            _mm_storeu_ps(out_y + i, y);
+            _mm_storeu_ps(out_z + i, z);
+            _mm_storeu_ps(out_life + i, remaining);
+         }
+      }
+      _mm_sfence();
+#endif
+      for (; i < end; ++i)
+      {
+         vy[i] += particle_gravity * dt;
+         px[i] += vx[i] * dt;
+         py[i] += vy[i] * dt;
+         pz[i] += vz[i] * dt;
+         life[i] -= dt;
+         if (py[i] < 0.f)
+         {
+            py[i] = -py[i];
+            vy[i] *= particle_bounce;
+         }
+         out_x[i] = px[i];
+         out_y[i] = py[i];
+         out_z[i] = pz[i];
+         out_life[i] = life[i];
+      }
+   }
+
+   // Interleaved position and life, then velocity and a spare, the layout the transform feedback mode uses
+   void write_interleaved(float* out) const
+   {
+      for (size_t i = 0; i < count; ++i)
+      {
+         const float particle[8] { px[i], py[i], pz[i], life[i], vx[i], vy[i], vz[i], 0.f };
+         for (int c = 0; c < 8; ++c)
+            out[i * 8 + c] = particle[c];
+      }
+   }
+
+   // Same hash as the shader, so a particle gets the same random numbers in both modes
+   static uint32_t hash(uint32_t x)
+   {
+      x ^= x >> 16;
+      x *= 0x7feb352du;
+      x ^= x >> 15;
+      x *= 0x846ca68bu;
+      x ^= x >> 16;
+      return x;
+   }
+
+   static float unit(uint32_t h) { return float(h >> 8) / 16777216.f; }
+
+private:
+#if PARTICLES_AVX
+#  if defined(__FMA__)
+   static __m256 madd(__m256 a, __m256 b, __m256 c) { return _mm256_fmadd_ps(a, b, c); }
+#  else
+   static __m256 madd(__m256 a, __m256 b, __m256 c) { return _mm256_add_ps(_mm256_mul_ps(a, b), c); }
+#  endif
+#endif
+
+   // A fountain at the origin: up 4 to 6 m/s, out up to 1.5 m/s in a random direction
+   void spawn(size_t i, uint32_t h)
+   {
+      const float angle = unit(h) * 6.2831853f;
+      const float radial = unit(hash(h + 1u)) * 1.5f;
+      px[i] = 0.f;
+      py[i] = 0.f;
+      pz[i] = 0.f;
+      vx[i] = std::cos(angle) * radial;
+      vy[i] = 4.f + 2.f * unit(hash(h + 2u));
+      vz[i] = std::sin(angle) * radial;
+      life[i] = particle_min_life + (particle_max_life - particle_min_life) * unit(hash(h + 3u));
+   }
+
+   static float* allocate(size_t floats)
+   {
+#if defined(_MSC_VER)
+      return static_cast<float*>(_aligned_malloc(floats * sizeof(float), 64));
+#else
+      return static_cast<float*>(std::aligned_alloc(64, floats * sizeof(float)));
+#endif
+   }
+
+   static void release(float* p)
+   {
+#if defined(_MSC_VER)
+      _aligned_free(p);
+#else
+      std::free(p);
+#endif
+   }
+
+   size_t count;
+   float* px = nullptr;
+   float* py = nullptr;
+   float* pz = nullptr;
+   float* vx = nullptr;
+   float* vy = nullptr;
+   float* vz = nullptr;
+   float* life = nullptr;
+};
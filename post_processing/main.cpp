@@ -0,0 +1,594 @@
+#include <glad/glad.h>
+#include <GLFW/glfw3.h>
+#include <algorithm>
+#include <cassert>
+#include <chrono>
+#include <cmath>
+#include <cstddef>
+#include <iostream>
+#include <map>
+#include <string>
+#include <vector>
+
+// Throw an exception and terminate GLFW
+void throw_ex(const char* msg)
+{
+   std::cout << msg << '\n';
+   glfwTerminate();
+   std::exit(-1);
+}
+
+// Resize callback function
+void framebuffer_size_callback(GLFWwindow*, int width, int height)
+{
+   assert(width > 0 && height > 0);
+   glViewport(0, 0, width, height);
+}
+
+// Compile a shader and print the info log if it fails
+unsigned compile_shader(GLenum type, const char* source)
+{
+   unsigned shader = glCreateShader(type);
+   glShaderSource(shader, 1, &source, nullptr);
+   glCompileShader(shader);
+
+   int success = 0;
+   char info_log[512] = "\0";
+   glGetShaderiv(shader, GL_COMPILE_STATUS, &success);
+
+   if (!success)
+   {
+      glGetShaderInfoLog(shader, sizeof(info_log), nullptr, info_log);
+      std::cout << "Failed to compile the shader: " << info_log;
+   }
+   return shader;
+}
+
+// Link a vertex and a fragment shader into a program and clean up the shaders
+unsigned link_program(const char* vertex_source, const char* fragment_source)
+{
+   unsigned vertex_shader = compile_shader(GL_VERTEX_SHADER, vertex_source);
+   unsigned fragment_shader = compile_shader(GL_FRAGMENT_SHADER, fragment_source);
+
+   unsigned program = glCreateProgram();
+   glAttachShader(program, vertex_shader);
+   glAttachShader(program, fragment_shader);
+   glLinkProgram(program);
+
+   int success = 0;
+   char info_log[512] = "\0";
+   glGetProgramiv(program, GL_LINK_STATUS, &success);
+
+   if (!success)
+   {
+      glGetProgramInfoLog(program, sizeof(info_log), nullptr, info_log);
+      std::cout << "Failed to link the shader program: " << info_log;
+   }
+
+   glDeleteShader(vertex_shader);
+   glDeleteShader(fragment_shader);
+   return program;
+}
+
+// Full screen triangle shared by every pass
+const char* fullscreen_vertex_source =
+   "#version 330 core\n"
+   "out vec2 TexCoord;\n"
+   "void main()\n"
+   "{\n"
+   "   TexCoord = vec2((gl_VertexID << 1) & 2, gl_VertexID & 2);\n"
+   "   gl_Position = vec4(TexCoord * 2.0 - 1.0, 0.0, 1.0);\n"
+   "}\0";
+
+// What an effect needs from its input decides whether it can share a pass with its neighbours
+enum class EffectKind
+{
+   // Only the pixel itself, any number of these run back to back in one shader
+   PerPixel,
+   // Neighbouring pixels of its input, so the input has to be in a texture and the effect starts a pass
+   Neighborhood,
+   // A blurred copy of its input, made by separate blur passes, the effect then combines the two
+   Blur
+};
+
+// One effect of the stack, its GLSL sets `color` from `uv`, the `source` sampler and `texel`, and for blurs `blurred`
+// Per pixel effects get `color` already holding the pixel and change it in place
+struct PostEffect
+{
+   const char* name;
+   EffectKind kind;
+   const char* code;
+   bool enabled;
+};
+
+// Images the passes move between, the blur chain has full and quarter resolution scratch targets
+enum Slot
+{
+   Scene,
+   Ping,
+   Pong,
+   BlurA,
+   BlurB,
+   SmallA,
+   SmallB,
+   Backbuffer,
+   slot_count,
+   NoSlot = -1
+};
+
+// One full screen draw of the compiled stack
+struct PostPass
+{
+   std::string name;
+   unsigned program;
+   Slot source, blurred, target;
+   float spread_x, spread_y;
+   int texel_location = -1, direction_location = -1;
+};
+
+// Post-process stack running over the HDR scene and ending in the backbuffer
+// With fusion on, runs of per pixel effects are generated into one shader so the image makes one trip through
+// memory for all of them instead of one per effect, and blurs run separably at quarter resolution
+class PostStack
+{
+public:
+   explicit PostStack(std::vector<PostEffect> effects) : effects(std::move(effects))
+   {
+      glGenVertexArrays(1, &VAO);
+      glGenFramebuffers(slot_count, framebuffers);
+      glGenTextures(slot_count, textures);
+
+      // Four bilinear taps average the 4x4 block under every quarter resolution pixel
+      downsample_program = program(
+         "vec2 offset = texel;\n"
+         "color = 0.25 * (texture(source, uv + vec2(-offset.x, -offset.y)).rgb + texture(source, uv + vec2(offset.x, -offset.y)).rgb\n"
+         "              + texture(source, uv + vec2(-offset.x, offset.y)).rgb + texture(source, uv + vec2(offset.x, offset.y)).rgb);\n");
+
+      // 9 tap gaussian in 5 bilinear fetches along `direction`
+      blur_program = program(
+         "color = texture(source, uv).rgb * 0.2270270270;\n"
+         "color += (texture(source, uv + direction * 1.3846153846).rgb + texture(source, uv - direction * 1.3846153846).rgb) * 0.3162162162;\n"
+         "color += (texture(source, uv + direction * 3.2307692308).rgb + texture(source, uv - direction * 3.2307692308).rgb) * 0.0702702703;\n");
+   }
+
+   PostStack(const PostStack&) = delete;
+   PostStack& operator=(const PostStack&) = delete;
+
+   // The context has to still be current
+   ~PostStack()
+   {
+      for (const auto& entry : programs)
+         glDeleteProgram(entry.second);
+      glDeleteTextures(slot_count, textures);
+      glDeleteFramebuffers(slot_count, framebuffers);
+      glDeleteVertexArrays(1, &VAO);
+   }
+
+   // Reallocate the targets when the window size has changed
+   void resize(int new_width, int new_height)
+   {
+      if (new_width == width && new_height == height)
+         return;
+
+      width = new_width;
+      height = new_height;
+      for (int slot = Scene; slot < Backbuffer; ++slot)
+      {
+         const int divisor = slot == SmallA || slot == SmallB ? 4 : 1;
+         sizes[slot][0] = std::max(1, width / divisor);
+         sizes[slot][1] = std::max(1, height / divisor);
+
+         glBindTexture(GL_TEXTURE_2D, textures[slot]);
+         glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA16F, sizes[slot][0], sizes[slot][1], 0, GL_RGBA, GL_FLOAT, nullptr);
+         glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+         glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+         glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+         glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+
+         glBindFramebuffer(GL_FRAMEBUFFER, framebuffers[slot]);
+         glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, textures[slot], 0);
+         if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
+            std::cout << "Framebuffer is not complete!\n";
+      }
+      glBindTexture(GL_TEXTURE_2D, 0);
+      glBindFramebuffer(GL_FRAMEBUFFER, 0);
+      sizes[Backbuffer][0] = width;
+      sizes[Backbuffer][1] = height;
+   }
+
+   void set_options(bool new_fuse, bool new_downsample)
+   {
+      dirty = dirty || new_fuse != fuse || new_downsample != downsample;
+      fuse = new_fuse;
+      downsample = new_downsample;
+   }
+
+   void toggle(size_t effect)
+   {
+      if (effect >= effects.size())
+         return;
+      effects[effect].enabled = !effects[effect].enabled;
+      dirty = true;
+   }
+
+   // The scene renders into this framebuffer
+   unsigned scene_framebuffer() const { return framebuffers[Scene]; }
+
+   // Run every pass, the last one writes the backbuffer
+   void run()
+   {
+      compile();
+
+      glBindVertexArray(VAO);
+      for (const PostPass& pass : passes)
+      {
+         glBindFramebuffer(GL_FRAMEBUFFER, pass.target == Backbuffer ? 0 : framebuffers[pass.target]);
+         glViewport(0, 0, sizes[pass.target][0], sizes[pass.target][1]);
+
+         const float texel_x = 1.f / sizes[pass.source][0], texel_y = 1.f / sizes[pass.source][1];
+         glUseProgram(pass.program);
+         glUniform2f(pass.texel_location, texel_x, texel_y);
+         glUniform2f(pass.direction_location, pass.spread_x * texel_x, pass.spread_y * texel_y);
+
+         glActiveTexture(GL_TEXTURE1);
+         glBindTexture(GL_TEXTURE_2D, pass.blurred == NoSlot ? 0 : textures[pass.blurred]);
+         glActiveTexture(GL_TEXTURE0);
+         glBindTexture(GL_TEXTURE_2D, textures[pass.source]);
+         glDrawArrays(GL_TRIANGLES, 0, 3);
+      }
+      glBindVertexArray(0);
+      glBindFramebuffer(GL_FRAMEBUFFER, 0);
+   }
+
+   // Passes of the current options, compiled if they have changed
+   const std::vector<PostPass>& get_passes()
+   {
+      compile();
+      return passes;
+   }
+
+   // Bytes every pass reads and writes once per pixel, the neighbours a pass samples again are taken to hit the cache
+   size_t bytes_per_frame()
+   {
+      compile();
+      size_t bytes = 0;
+      for (const PostPass& pass : passes)
+         bytes += slot_bytes(pass.source) + slot_bytes(pass.blurred) + slot_bytes(pass.target);
+      return bytes;
+   }
+
+private:
+   // Generated fragment shader, effects are scoped so their locals don't clash
+   unsigned program(const std::string& body)
+   {
+      const std::string source =
+         "#version 330 core\n"
+         "in vec2 TexCoord;\n"
+         "uniform sampler2D source;\n"
+         "uniform sampler2D blurred;\n"
+         "uniform vec2 texel;\n"
+         "uniform vec2 direction;\n"
+         "out vec4 FragColor;\n"
+         "void main()\n"
+         "{\n"
+         "   vec2 uv = TexCoord;\n"
+         "   vec3 color;\n"
+         + body +
+         "   FragColor = vec4(color, 1.0);\n"
+         "}\n";
+
+      // Toggling effects back and forth reuses the programs it has generated before
+      auto it = programs.find(source);
+      if (it != programs.end())
+         return it->second;
+
+      const unsigned linked = link_program(fullscreen_vertex_source, source.c_str());
+      glUseProgram(linked);
+      glUniform1i(glGetUniformLocation(linked, "source"), 0);
+      glUniform1i(glGetUniformLocation(linked, "blurred"), 1);
+      programs[source] = linked;
+      return linked;
+   }
+
+   size_t slot_bytes(Slot slot) const
+   {
+      if (slot == NoSlot)
+         return 0;
+      return size_t(sizes[slot][0]) * sizes[slot][1] * (slot == Backbuffer ? 4 : 8);
+   }
+
+   // Group the enabled effects into passes
+   void compile()
+   {
+      if (!dirty)
+         return;
+      dirty = false;
+      passes.clear();
+
+      // The pass being gathered, its head reads the input and the per pixel effects follow
+      Slot current = Scene;
+      std::string body, name;
+      Slot blurred = NoSlot;
+      bool open = false;
+
+      auto close = [&](Slot target) {
+         passes.push_back({ name, program(body), current, blurred, target, 0.f, 0.f });
+         current = target;
+         blurred = NoSlot;
+         open = false;
+      };
+      auto next_target = [&]() { return current == Ping ? Pong : Ping; };
+
+      for (const PostEffect& effect : effects)
+      {
+         if (!effect.enabled)
+            continue;
+
+         // Without fusion every effect gets a pass of its own, anything that needs its input in a texture always does
+         if (open && (!fuse || effect.kind != EffectKind::PerPixel))
+            close(next_target());
+
+         if (effect.kind == EffectKind::Blur)
+         {
+            // Quarter resolution with taps one texel apart blurs as wide as full resolution with taps four apart
+            if (downsample)
+            {
+               passes.push_back({ "downsample", downsample_program, current, NoSlot, SmallA, 0.f, 0.f });
+               passes.push_back({ "blur x", blur_program, SmallA, NoSlot, SmallB, 1.f, 0.f });
+               passes.push_back({ "blur y", blur_program, SmallB, NoSlot, SmallA, 0.f, 1.f });
+               blurred = SmallA;
+            }
+            else
+            {
+               passes.push_back({ "blur x", blur_program, current, NoSlot, BlurA, 4.f, 0.f });
+               passes.push_back({ "blur y", blur_program, BlurA, NoSlot, BlurB, 0.f, 4.f });
+               blurred = BlurB;
+            }
+         }
+
+         if (!open)
+         {
+            body = effect.kind == EffectKind::PerPixel ? "color = texture(source, uv).rgb;\n" : "";
+            name.clear();
+            open = true;
+         }
+
+         body += effect.kind == EffectKind::PerPixel ? std::string("{\n") + effect.code + "}\n" : effect.code;
+         name += name.empty() ? effect.name : std::string(" + ") + effect.name;
+      }
+
+      // Nothing enabled still has to get the scene to the screen
+      if (!open)
+      {
+         body = "color = texture(source, uv).rgb;\n";
+         name = "copy";
+      }
+      close(Backbuffer);
+
+      // Look the uniforms up once here instead of every pass of every frame
+      for (PostPass& pass : passes)
+      {
+         pass.texel_location = glGetUniformLocation(pass.program, "texel");
+         pass.direction_location = glGetUniformLocation(pass.program, "direction");
+      }
+   }
+
+   std::vector<PostEffect> effects;
+   std::vector<PostPass> passes;
+   std::map<std::string, unsigned> programs;
+   unsigned downsample_program = 0, blur_program = 0;
+   unsigned VAO = 0;
+   unsigned framebuffers[slot_count] {};
+   unsigned textures[slot_count] {};
+   int sizes[slot_count][2] {};
+   int width = 0, height = 0;
+   bool fuse = true, downsample = true, dirty = true;
+};
+
+// Main function
+int main()
+{
+   // HDR scene with hard edges for the anti-aliasing and lights far above 1 for the tone mapping and bloom
+   const char* scene_fragment_source =
+      "#version 330 core\n"
+      "in vec2 TexCoord;\n"
+      "uniform float time;\n"
+      "uniform float aspect;\n"
+      "out vec4 FragColor;\n"
+      "void main()\n"
+      "{\n"
+      "   vec2 p = (TexCoord * 2.0 - 1.0) * vec2(aspect, 1.0);\n"
+      "   vec3 color = mix(vec3(0.05, 0.07, 0.12), vec3(0.25, 0.3, 0.45), TexCoord.y);\n"
+      "   float angle = time * 0.2;\n"
+      "   vec2 q = mat2(cos(angle), -sin(angle), sin(angle), cos(angle)) * p;\n"
+      "   if (fract(q.x * 3.0) < 0.5 && abs(q.y) < 0.6)\n"
+      "      color = vec3(0.9, 0.6, 0.3);\n"
+      "   for (int i = 0; i < 6; ++i)\n"
+      "   {\n"
+      "      vec2 center = vec2(cos(time * 0.5 + float(i) * 1.05), sin(time * 0.7 + float(i) * 1.3)) * 0.7;\n"
+      "      if (length(p - center) < 0.07)\n"
+      "         color = vec3(6.0, 4.0 + float(i), 12.0 - float(i) * 2.0);\n"
+      "   }\n"
+      "   FragColor = vec4(color, 1.0);\n"
+      "}\0";
+
+   // The stack in order, 1 to 5 toggle the effects
+   const std::vector<PostEffect> effects {
+      { "bloom", EffectKind::Blur,
+         "color = texture(source, uv).rgb + texture(blurred, uv).rgb * 0.6;\n", true },
+      { "tone mapping", EffectKind::PerPixel,
+         "// Narkowicz's fit of the ACES curve\n"
+         "vec3 x = color * 0.8;\n"
+         "color = clamp((x * (2.51 * x + 0.03)) / (x * (2.43 * x + 0.59) + 0.14), 0.0, 1.0);\n", true },
+      { "color grading", EffectKind::PerPixel,
+         "float luma = dot(color, vec3(0.2126, 0.7152, 0.0722));\n"
+         "color = mix(vec3(luma), color, 1.2);\n"
+         "color = clamp((color - 0.5) * 1.1 + 0.5, 0.0, 1.0) * vec3(1.05, 1.0, 0.92);\n", true },
+      { "fxaa", EffectKind::Neighborhood,
+         "// Compact FXAA after Lottes, without the edge search: blur along the edge when the corners disagree\n"
+         "const vec3 weights = vec3(0.299, 0.587, 0.114);\n"
+         "vec3 middle = texture(source, uv).rgb;\n"
+         "float luma_nw = dot(texture(source, uv + vec2(-1.0, -1.0) * texel).rgb, weights);\n"
+         "float luma_ne = dot(texture(source, uv + vec2(1.0, -1.0) * texel).rgb, weights);\n"
+         "float luma_sw = dot(texture(source, uv + vec2(-1.0, 1.0) * texel).rgb, weights);\n"
+         "float luma_se = dot(texture(source, uv + vec2(1.0, 1.0) * texel).rgb, weights);\n"
+         "float luma_m = dot(middle, weights);\n"
+         "float luma_min = min(luma_m, min(min(luma_nw, luma_ne), min(luma_sw, luma_se)));\n"
+         "float luma_max = max(luma_m, max(max(luma_nw, luma_ne), max(luma_sw, luma_se)));\n"
+         "vec2 dir = vec2(-((luma_nw + luma_ne) - (luma_sw + luma_se)), (luma_nw + luma_sw) - (luma_ne + luma_se));\n"
+         "float reduce = max((luma_nw + luma_ne + luma_sw + luma_se) * (0.25 / 8.0), 1.0 / 128.0);\n"
+         "dir = clamp(dir / (min(abs(dir.x), abs(dir.y)) + reduce), -8.0, 8.0) * texel;\n"
+         "vec3 a = 0.5 * (texture(source, uv - dir / 6.0).rgb + texture(source, uv + dir / 6.0).rgb);\n"
+         "vec3 b = a * 0.5 + 0.25 * (texture(source, uv - dir * 0.5).rgb + texture(source, uv + dir * 0.5).rgb);\n"
+         "float luma_b = dot(b, weights);\n"
+         "color = luma_b < luma_min || luma_b > luma_max ? a : b;\n", true },
+      { "vignette", EffectKind::PerPixel,
+         "color *= 1.0 - smoothstep(0.35, 0.85, length(uv - 0.5)) * 0.7;\n", true },
+   };
+
+   // Initialize GLFW and tell it the version and profile
+   glfwInit();
+   glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
+   glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
+   glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+
+   // Initialize the window
+   GLFWwindow* window = glfwCreateWindow(800, 600, "Post processing.", nullptr, nullptr);
+   if (!window)
+      throw_ex("Failed to create the window!");
+
+   // Set the current window
+   glfwMakeContextCurrent(window);
+
+   // Initialize GLAD
+   if (!gladLoadGLLoader(GLADloadproc(glfwGetProcAddress)))
+      throw_ex("Failed to initialize GLAD!");
+
+   // Set the viewport
+   glViewport(0, 0, 800, 600);
+
+   // Set window resize callback
+   glfwSetFramebufferSizeCallback(window, framebuffer_size_callback);
+
+   // Create the scene program
+   unsigned scene_program = link_program(fullscreen_vertex_source, scene_fragment_source);
+   const int time_location = glGetUniformLocation(scene_program, "time");
+   const int aspect_location = glGetUniformLocation(scene_program, "aspect");
+
+   unsigned VAO = 0;
+   glGenVertexArrays(1, &VAO);
+
+   // The scope makes sure the stack's targets and programs are deleted before glfwTerminate
+   {
+      PostStack stack(effects);
+      stack.resize(800, 600);
+
+      auto render_scene = [&](float time, int width, int height) {
+         glBindFramebuffer(GL_FRAMEBUFFER, stack.scene_framebuffer());
+         glViewport(0, 0, width, height);
+         glUseProgram(scene_program);
+         glUniform1f(time_location, time);
+         glUniform1f(aspect_location, float(width) / height);
+         glBindVertexArray(VAO);
+         glDrawArrays(GL_TRIANGLES, 0, 3);
+         glBindVertexArray(0);
+      };
+
+      // Benchmark the stack with every effect as its own pass, fused, and fused with the quarter resolution blur
+      render_scene(0.f, 800, 600);
+      double baseline_ms = 0.0;
+      size_t baseline_bytes = 0;
+      for (int config = 0; config < 3; ++config)
+      {
+         stack.set_options(config > 0, config > 1);
+         stack.run();
+         glFinish();
+
+         const int runs = 10;
+         const auto start = std::chrono::steady_clock::now();
+         for (int run = 0; run < runs; ++run)
+            stack.run();
+         glFinish();
+         const std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+
+         const double ms = elapsed.count() / runs;
+         const size_t bytes = stack.bytes_per_frame();
+         if (config == 0)
+         {
+            baseline_ms = ms;
+            baseline_bytes = bytes;
+         }
+
+         std::cout << (config == 0 ? "Pass per effect: " : config == 1 ? "Fused:           " : "Fused + 1/4 blur:")
+                   << ' ' << stack.get_passes().size() << " passes, " << bytes / 1e6 << " MB, " << ms << " ms";
+         if (config > 0)
+            std::cout << " (saves " << (baseline_bytes - bytes) / 1e6 << " MB and " << baseline_ms - ms << " ms)";
+         std::cout << '\n';
+         for (const PostPass& pass : stack.get_passes())
+            std::cout << "   " << pass.name << '\n';
+      }
+
+      // F toggles fusion, Q the quarter resolution blur, 1 to 5 the effects
+      bool fuse = true, downsample = true;
+      bool f_down = false, q_down = false;
+      bool number_down[5] {};
+      double stats_time = glfwGetTime();
+      int frames = 0;
+
+      // Create the render loop
+      while (!glfwWindowShouldClose(window))
+      {
+         // Check if the window should close
+         if (glfwGetKey(window, GLFW_KEY_ESCAPE) == GLFW_PRESS)
+            glfwSetWindowShouldClose(window, true);
+
+         const bool f_pressed = glfwGetKey(window, GLFW_KEY_F) == GLFW_PRESS;
+         if (f_pressed && !f_down)
+            fuse = !fuse;
+         f_down = f_pressed;
+
+         const bool q_pressed = glfwGetKey(window, GLFW_KEY_Q) == GLFW_PRESS;
+         if (q_pressed && !q_down)
+            downsample = !downsample;
+         q_down = q_pressed;
+
+         for (int i = 0; i < 5; ++i)
+         {
+            const bool pressed = glfwGetKey(window, GLFW_KEY_1 + i) == GLFW_PRESS;
+            if (pressed && !number_down[i])
+               stack.toggle(size_t(i));
+            number_down[i] = pressed;
+         }
+         stack.set_options(fuse, downsample);
+
+         // Render the scene and post-process it into the backbuffer
+         int width = 0, height = 0;
+         glfwGetFramebufferSize(window, &width, &height);
+         stack.resize(width, height);
+         render_scene(float(glfwGetTime()), width, height);
+         stack.run();
+
+         // Swap buffers and check and call events
+         glfwSwapBuffers(window);
+         glfwPollEvents();
+
+         // Print the pass count, traffic and frame time once a second
+         ++frames;
+         const double now = glfwGetTime();
+         if (now - stats_time >= 1.0)
+         {
+            std::cout << (fuse ? "Fused" : "Pass per effect") << (downsample ? ", 1/4 blur: " : ", full blur: ")
+                      << stack.get_passes().size() << " passes, " << stack.bytes_per_frame() / 1e6 << " MB, "
+                      << (now - stats_time) * 1000.0 / frames << " ms/frame\n";
+            stats_time = now;
+            frames = 0;
+         }
+      }
+   }
+
+   // Clean up
+   glDeleteVertexArrays(1, &VAO);
+   glDeleteProgram(scene_program);
+   glfwTerminate();
+   return 0;
+}
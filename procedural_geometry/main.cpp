@@ -0,0 +1,699 @@
+#include <glad/glad.h>
+#include <GLFW/glfw3.h>
+#include <algorithm>
+#include <cassert>
+#include <chrono>
+#include <cstddef>
+#include <cmath>
+#include <cstdint>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <new>
+#include <thread>
+#include <vector>
+
+// Throw an exception and terminate GLFW
+void throw_ex(const char* msg)
+{
+   std::cout << msg << '\n';
+   glfwTerminate();
+   std::exit(-1);
+}
+
+// Resize callback function
+void framebuffer_size_callback(GLFWwindow*, int width, int height)
+{
+   assert(width > 0 && height > 0);
+   glViewport(0, 0, width, height);
+}
+
+// Compile a shader and print the info log if it fails
+unsigned compile_shader(GLenum type, const char* source)
+{
+   unsigned shader = glCreateShader(type);
+   glShaderSource(shader, 1, &source, nullptr);
+   glCompileShader(shader);
+
+   int success = 0;
+   char info_log[512] = "\0";
+   glGetShaderiv(shader, GL_COMPILE_STATUS, &success);
+
+   if (!success)
+   {
+      glGetShaderInfoLog(shader, sizeof(info_log), nullptr, info_log);
+      std::cout << "Failed to compile the shader: " << info_log;
+   }
+   return shader;
+}
+
+// Link a vertex and a fragment shader into a program and clean up the shaders
+unsigned link_program(const char* vertex_source, const char* fragment_source)
+{
+   unsigned vertex_shader = compile_shader(GL_VERTEX_SHADER, vertex_source);
+   unsigned fragment_shader = compile_shader(GL_FRAGMENT_SHADER, fragment_source);
+
+   unsigned program = glCreateProgram();
+   glAttachShader(program, vertex_shader);
+   glAttachShader(program, fragment_shader);
+   glLinkProgram(program);
+
+   int success = 0;
+   char info_log[512] = "\0";
+   glGetProgramiv(program, GL_LINK_STATUS, &success);
+
+   if (!success)
+   {
+      glGetProgramInfoLog(program, sizeof(info_log), nullptr, info_log);
+      std::cout << "Failed to link the shader program: " << info_log;
+   }
+
+   glDeleteShader(vertex_shader);
+   glDeleteShader(fragment_shader);
+   return program;
+}
+
+// Column-major 4x4 matrix
+struct Mat4
+{
+   float m[16];
+};
+
+Mat4 identity()
+{
+   Mat4 r {};
+   r.m[0] = r.m[5] = r.m[10] = r.m[15] = 1.f;
+   return r;
+}
+
+Mat4 multiply(const Mat4& a, const Mat4& b)
+{
+   Mat4 r {};
+   for (int col = 0; col < 4; ++col)
+      for (int row = 0; row < 4; ++row)
+         r.m[col * 4 + row] =
+            a.m[0 * 4 + row] * b.m[col * 4 + 0] +
+            a.m[1 * 4 + row] * b.m[col * 4 + 1] +
+            a.m[2 * 4 + row] * b.m[col * 4 + 2] +
+            a.m[3 * 4 + row] * b.m[col * 4 + 3];
+   return r;
+}
+
+Mat4 translate(float x, float y, float z)
+{
+   Mat4 r = identity();
+   r.m[12] = x;
+   r.m[13] = y;
+   r.m[14] = z;
+   return r;
+}
+
+Mat4 rotate_x(float angle)
+{
+   Mat4 r = identity();
+   r.m[5] = std::cos(angle);
+   r.m[6] = std::sin(angle);
+   r.m[9] = -r.m[6];
+   r.m[10] = r.m[5];
+   return r;
+}
+
+Mat4 rotate_y(float angle)
+{
+   Mat4 r = identity();
+   r.m[0] = std::cos(angle);
+   r.m[2] = -std::sin(angle);
+   r.m[8] = -r.m[2];
+   r.m[10] = r.m[0];
+   return r;
+}
+
+Mat4 perspective(float fov_y, float aspect, float near_plane, float far_plane)
+{
+   const float f = 1.f / std::tan(fov_y * .5f);
+   Mat4 r {};
+   r.m[0] = f / aspect;
+   r.m[5] = f;
+   r.m[10] = (far_plane + near_plane) / (near_plane - far_plane);
+   r.m[11] = -1.f;
+   r.m[14] = 2.f * far_plane * near_plane / (near_plane - far_plane);
+   return r;
+}
+
+// Run fn(begin, end) over [0, count) split between all cores
+// elements_per_job is how many vertices or indices one job writes, the split is by those so a few thousand
+// rows of a big grid still go to every core while a small mesh isn't worth starting threads for
+template <typename Fn>
+void parallel_for(size_t count, size_t elements_per_job, Fn fn)
+{
+   const size_t min_jobs = std::max<size_t>(1, 4096 / std::max<size_t>(1, elements_per_job));
+   const size_t thread_count = std::min<size_t>(std::max(1u, std::thread::hardware_concurrency()), (count + min_jobs - 1) / min_jobs);
+   if (thread_count <= 1)
+   {
+      fn(size_t(0), count);
+      return;
+   }
+
+   std::vector<std::thread> threads;
+   const size_t per_thread = (count + thread_count - 1) / thread_count;
+   for (size_t begin = 0; begin < count; begin += per_thread)
+      threads.emplace_back(fn, begin, std::min(begin + per_thread, count));
+
+   for (std::thread& thread : threads)
+      thread.join();
+}
+
+// Vertex layout shared by every generator
+struct Vertex
+{
+   float position[3];
+   float normal[3];
+};
+
+// Shapes the generators know about
+enum class Shape
+{
+   Ngon,
+   Grid,
+   Sphere,
+   Torus,
+   Terrain
+};
+
+const char* shape_name(Shape shape)
+{
+   switch (shape)
+   {
+   case Shape::Ngon: return "n-gon";
+   case Shape::Grid: return "grid";
+   case Shape::Sphere: return "sphere";
+   case Shape::Torus: return "torus";
+   case Shape::Terrain: return "terrain";
+   }
+   return "";
+}
+
+// Vertex and index counts, known up front so the buffers can be sized before generating
+struct MeshSize
+{
+   size_t columns;
+   size_t rows;
+   size_t vertex_count;
+   size_t index_count;
+};
+
+MeshSize mesh_size(Shape shape, size_t triangles)
+{
+   // N-gon is a fan around a center vertex, one triangle per side
+   if (shape == Shape::Ngon)
+   {
+      const size_t sides = std::max<size_t>(3, triangles);
+      return { sides, 1, sides + 1, sides * 3 };
+   }
+
+   // Everything else is a square-ish grid of quads with two triangles each
+   const size_t side = std::max<size_t>(1, size_t(std::sqrt(double(triangles) * .5) + .5));
+   return { side, side, (side + 1) * (side + 1), side * side * 6 };
+}
+
+// Hash based value noise, every sample is independent so terrain can be generated in any order
+float hash_noise(int x, int y)
+{
+   std::uint32_t h = std::uint32_t(x) * 374761393u + std::uint32_t(y) * 668265263u;
+   h = (h ^ (h >> 13)) * 1274126177u;
+   return float(h ^ (h >> 16)) / 4294967295.f;
+}
+
+float value_noise(float x, float y)
+{
+   const float fx = std::floor(x), fy = std::floor(y);
+   const int ix = int(fx), iy = int(fy);
+   float tx = x - fx, ty = y - fy;
+   tx = tx * tx * (3.f - 2.f * tx);
+   ty = ty * ty * (3.f - 2.f * ty);
+
+   const float a = hash_noise(ix, iy), b = hash_noise(ix + 1, iy);
+   const float c = hash_noise(ix, iy + 1), d = hash_noise(ix + 1, iy + 1);
+   return (a + (b - a) * tx) + ((c + (d - c) * tx) - (a + (b - a) * tx)) * ty;
+}
+
+// Fractal brownian motion, six octaves of value noise
+float terrain_height(float x, float z)
+{
+   float height = 0.f, amplitude = .5f, frequency = 2.f;
+   for (int octave = 0; octave < 6; ++octave)
+   {
+      height += (value_noise(x * frequency, z * frequency) - .5f) * amplitude;
+      amplitude *= .5f;
+      frequency *= 2.f;
+   }
+   return height * .6f;
+}
+
+// Position and normal of grid vertex (u, v) in [0, 1], terrain is generated separately
+Vertex grid_vertex(Shape shape, float u, float v)
+{
+   const float pi = 3.14159265f;
+   Vertex vertex {};
+
+   switch (shape)
+   {
+   case Shape::Sphere:
+   {
+      const float theta = u * 2.f * pi, phi = v * pi;
+      const float nx = std::sin(phi) * std::cos(theta), ny = std::cos(phi), nz = std::sin(phi) * std::sin(theta);
+      vertex = { { nx, ny, nz }, { nx, ny, nz } };
+      break;
+   }
+   case Shape::Torus:
+   {
+      const float theta = u * 2.f * pi, phi = v * 2.f * pi, major = .7f, minor = .3f;
+      const float nx = std::cos(phi) * std::cos(theta), ny = std::sin(phi), nz = std::cos(phi) * std::sin(theta);
+      vertex = { { (major + minor * std::cos(phi)) * std::cos(theta), minor * ny,
+         (major + minor * std::cos(phi)) * std::sin(theta) }, { nx, ny, nz } };
+      break;
+   }
+   default:
+      vertex = { { u * 2.f - 1.f, 0.f, v * 2.f - 1.f }, { 0.f, 1.f, 0.f } };
+      break;
+   }
+   return vertex;
+}
+
+// Generate a mesh straight into the destination buffers
+// Grid indices are emitted in vertical bands a few quads wide, so the vertices shared with the row
+// above are still in the post-transform cache when they are referenced again
+void generate_mesh(Shape shape, const MeshSize& size, Vertex* vertices, unsigned* indices)
+{
+   if (shape == Shape::Ngon)
+   {
+      const float pi = 3.14159265f;
+      vertices[0] = { { 0.f, 0.f, 0.f }, { 0.f, 0.f, 1.f } };
+
+      parallel_for(size.columns, 1, [&](size_t begin, size_t end)
+      {
+         for (size_t i = begin; i < end; ++i)
+         {
+            const float angle = pi * .5f - 2.f * pi * float(i) / float(size.columns);
+            vertices[i + 1] = { { std::cos(angle) * .8f, std::sin(angle) * .8f, 0.f }, { 0.f, 0.f, 1.f } };
+
+            indices[i * 3 + 0] = 0;
+            indices[i * 3 + 1] = unsigned(i + 1);
+            indices[i * 3 + 2] = unsigned((i + 1) % size.columns + 1);
+         }
+      });
+      return;
+   }
+
+   // Terrain heights first, normals come from central differences of the neighbouring heights
+   // They are kept in a separate array, mapped buffers are write-only and slow to read back
+   const size_t stride = size.columns + 1;
+   if (shape == Shape::Terrain)
+   {
+      std::vector<float> heights((size.rows + 1) * stride);
+      parallel_for(heights.size(), 1, [&](size_t begin, size_t end)
+      {
+         for (size_t i = begin; i < end; ++i)
+            heights[i] = terrain_height(float(i % stride) / size.columns * 2.f - 1.f, float(i / stride) / size.rows * 2.f - 1.f);
+      });
+
+      parallel_for(size.rows + 1, stride, [&](size_t begin, size_t end)
+      {
+         for (size_t row = begin; row < end; ++row)
+            for (size_t column = 0; column <= size.columns; ++column)
+            {
+               const size_t left = column > 0 ? column - 1 : column, right = std::min(column + 1, size.columns);
+               const size_t up = row > 0 ? row - 1 : row, down = std::min(row + 1, size.rows);
+               const float slope_x = (heights[row * stride + right] - heights[row * stride + left]) * size.columns / (2.f * (right - left));
+               const float slope_z = (heights[down * stride + column] - heights[up * stride + column]) * size.rows / (2.f * (down - up));
+               const float length = std::sqrt(slope_x * slope_x + 1.f + slope_z * slope_z);
+
+               vertices[row * stride + column] = {
+                  { float(column) / size.columns * 2.f - 1.f, heights[row * stride + column], float(row) / size.rows * 2.f - 1.f },
+                  { -slope_x / length, 1.f / length, -slope_z / length } };
+            }
+      });
+   }
+   else
+   {
+      // Vertices, one row per job
+      parallel_for(size.rows + 1, stride, [&](size_t begin, size_t end)
+      {
+         for (size_t row = begin; row < end; ++row)
+            for (size_t column = 0; column <= size.columns; ++column)
+               vertices[row * stride + column] = grid_vertex(shape, float(column) / size.columns, float(row) / size.rows);
+      });
+   }
+
+   // Indices, one band per job
+   const size_t band_width = 16;
+   const size_t band_count = (size.columns + band_width - 1) / band_width;
+   parallel_for(band_count, size.rows * band_width * 6, [&](size_t begin, size_t end)
+   {
+      for (size_t band = begin; band < end; ++band)
+      {
+         const size_t first_column = band * band_width;
+         const size_t last_column = std::min(first_column + band_width, size.columns);
+         unsigned* out = indices + size.rows * first_column * 6;
+
+         for (size_t row = 0; row < size.rows; ++row)
+            for (size_t column = first_column; column < last_column; ++column)
+            {
+               const unsigned top_left = unsigned(row * stride + column);
+               const unsigned bottom_left = unsigned(top_left + stride);
+
+               *out++ = top_left;
+               *out++ = bottom_left;
+               *out++ = top_left + 1;
+               *out++ = top_left + 1;
+               *out++ = bottom_left;
+               *out++ = bottom_left + 1;
+            }
+      }
+   });
+}
+
+// Reusable CPU staging memory, blocks are kept by power of two size class and handed out again
+class BufferPool
+{
+public:
+   void* acquire(size_t bytes)
+   {
+      const size_t capacity = size_class(bytes);
+      std::vector<std::unique_ptr<char[]>>& free_blocks = pool[capacity];
+      if (free_blocks.empty())
+         free_blocks.emplace_back(new char[capacity]);
+
+      char* block = free_blocks.back().release();
+      free_blocks.pop_back();
+      capacity_of[block] = capacity;
+      return block;
+   }
+
+   void release(void* block)
+   {
+      char* bytes = static_cast<char*>(block);
+      pool[capacity_of[bytes]].emplace_back(bytes);
+      capacity_of.erase(bytes);
+   }
+
+   // Free the kept blocks of every class above the one of bytes, so one huge mesh doesn't stay resident after it
+   void trim(size_t bytes)
+   {
+      const size_t limit = size_class(bytes);
+      for (auto it = pool.begin(); it != pool.end();)
+         it = it->first > limit ? pool.erase(it) : std::next(it);
+   }
+
+private:
+   static size_t size_class(size_t bytes)
+   {
+      size_t capacity = 4096;
+      while (capacity < bytes)
+         capacity *= 2;
+      return capacity;
+   }
+
+   std::map<size_t, std::vector<std::unique_ptr<char[]>>> pool;
+   std::map<char*, size_t> capacity_of;
+};
+
+// Clear every pending error, true if one of them was GL_OUT_OF_MEMORY
+bool drain_out_of_memory()
+{
+   bool out_of_memory = false;
+   for (GLenum error = glGetError(); error != GL_NO_ERROR; error = glGetError())
+      out_of_memory = out_of_memory || error == GL_OUT_OF_MEMORY;
+   return out_of_memory;
+}
+
+// Generate a mesh and upload it, either by mapping the GL buffers or by staging in pooled CPU memory
+// Returns false if the driver could not provide the memory, size is zeroed if the buffers lost the old mesh
+bool build_mesh(Shape shape, size_t triangles, bool use_mapping, BufferPool& pool,
+   unsigned VBO, unsigned EBO, MeshSize& size)
+{
+   const MeshSize new_size = mesh_size(shape, triangles);
+   const size_t vertex_bytes = new_size.vertex_count * sizeof(Vertex);
+   const size_t index_bytes = new_size.index_count * sizeof(unsigned);
+   const auto start = std::chrono::steady_clock::now();
+
+   glBindBuffer(GL_ARRAY_BUFFER, VBO);
+   glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, EBO);
+
+   if (use_mapping)
+   {
+      // Allocate without data and let the generators write into driver memory directly
+      glBufferData(GL_ARRAY_BUFFER, vertex_bytes, nullptr, GL_STATIC_DRAW);
+      glBufferData(GL_ELEMENT_ARRAY_BUFFER, index_bytes, nullptr, GL_STATIC_DRAW);
+
+      void* vertices = glMapBufferRange(GL_ARRAY_BUFFER, 0, vertex_bytes, GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT);
+      void* indices = glMapBufferRange(GL_ELEMENT_ARRAY_BUFFER, 0, index_bytes, GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT);
+
+      if (vertices && indices)
+         generate_mesh(shape, new_size, static_cast<Vertex*>(vertices), static_cast<unsigned*>(indices));
+
+      if (vertices)
+         glUnmapBuffer(GL_ARRAY_BUFFER);
+      if (indices)
+         glUnmapBuffer(GL_ELEMENT_ARRAY_BUFFER);
+      if (!vertices || !indices)
+      {
+         drain_out_of_memory();
+         size = {};
+         return false;
+      }
+
+      // Staging memory isn't needed while mapping
+      pool.trim(0);
+   }
+   else
+   {
+      // Generate into recycled staging memory, then copy once
+      // The staging blocks come from the heap, which can refuse the larger sizes just like the driver
+      void* vertices = nullptr;
+      void* indices = nullptr;
+      try
+      {
+         vertices = pool.acquire(vertex_bytes);
+         indices = pool.acquire(index_bytes);
+      }
+      catch (const std::bad_alloc&)
+      {
+         if (vertices)
+            pool.release(vertices);
+         return false;
+      }
+      generate_mesh(shape, new_size, static_cast<Vertex*>(vertices), static_cast<unsigned*>(indices));
+
+      glBufferData(GL_ARRAY_BUFFER, vertex_bytes, vertices, GL_STATIC_DRAW);
+      glBufferData(GL_ELEMENT_ARRAY_BUFFER, index_bytes, indices, GL_STATIC_DRAW);
+      pool.release(vertices);
+      pool.release(indices);
+      pool.trim(std::max(vertex_bytes, index_bytes));
+   }
+
+   if (drain_out_of_memory())
+   {
+      size = {};
+      return false;
+   }
+
+   glFinish();
+   const std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+   const size_t built = new_size.index_count / 3;
+   std::cout << "Built " << shape_name(shape) << " with " << built << " triangles in "
+             << elapsed.count() * 1000.0 << " ms (" << built / elapsed.count() / 1e6 << " M triangles/s, "
+             << (use_mapping ? "mapped" : "pooled") << ")\n";
+
+   size = new_size;
+   return true;
+}
+
+// True once when the key goes down
+bool key_pressed(GLFWwindow* window, int key, bool& was_down)
+{
+   const bool down = glfwGetKey(window, key) == GLFW_PRESS;
+   const bool pressed = down && !was_down;
+   was_down = down;
+   return pressed;
+}
+
+// Main function
+int main()
+{
+   // Vertex shader
+   const char* vertex_shader_source =
+      "#version 330 core\n"
+      "layout (location = 0) in vec3 aPos;\n"
+      "layout (location = 1) in vec3 aNormal;\n"
+      "uniform mat4 model;\n"
+      "uniform mat4 view;\n"
+      "uniform mat4 projection;\n"
+      "out vec3 Normal;\n"
+      "void main()\n"
+      "{\n"
+      "   Normal = mat3(model) * aNormal;\n"
+      "   gl_Position = projection * view * model * vec4(aPos, 1.0);\n"
+      "}\0";
+
+   // Fragment shader with a single directional light
+   const char* fragment_shader_source =
+      "#version 330 core\n"
+      "in vec3 Normal;\n"
+      "out vec4 FragColor;\n"
+      "void main()\n"
+      "{\n"
+      "   float diffuse = max(dot(normalize(Normal), normalize(vec3(0.4, 1.0, 0.6))), 0.0);\n"
+      "   FragColor = vec4(vec3(1.0f, 0.5f, 0.f) * (0.2 + 0.8 * diffuse), 1.0f);\n"
+      "}\0";
+
+   // Initialize GLFW and tell it the version and profile
+   glfwInit();
+   glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
+   glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
+   glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+
+   // Initialize the window
+   GLFWwindow* window = glfwCreateWindow(800, 600, "Procedural geometry.", nullptr, nullptr);
+   if (!window)
+      throw_ex("Failed to create the window!");
+
+   // Set the current window
+   glfwMakeContextCurrent(window);
+
+   // Initialize GLAD
+   if (!gladLoadGLLoader(GLADloadproc(glfwGetProcAddress)))
+      throw_ex("Failed to initialize GLAD!");
+
+   // Set the viewport
+   glViewport(0, 0, 800, 600);
+
+   // Set window resize callback
+   glfwSetFramebufferSizeCallback(window, framebuffer_size_callback);
+
+   // Create the shader program
+   unsigned shader_program = link_program(vertex_shader_source, fragment_shader_source);
+   const int model_location = glGetUniformLocation(shader_program, "model");
+   const int view_location = glGetUniformLocation(shader_program, "view");
+   const int projection_location = glGetUniformLocation(shader_program, "projection");
+
+   // Create the buffer objects
+   unsigned EBO = 0;
+   glGenBuffers(1, &EBO);
+
+   unsigned VBO = 0;
+   glGenBuffers(1, &VBO);
+
+   unsigned VAO = 0;
+   glGenVertexArrays(1, &VAO);
+
+   // Initialize the VAO, the buffers are filled by build_mesh
+   glBindVertexArray(VAO);
+   glBindBuffer(GL_ARRAY_BUFFER, VBO);
+   glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, EBO);
+
+   // Link vertex attributes
+   glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)0);
+   glEnableVertexAttribArray(0);
+   glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex, normal));
+   glEnableVertexAttribArray(1);
+
+   // Build the first mesh
+   // 1-5 pick the shape, +/- change the triangle count by a factor of 10, M toggles mapped/pooled upload
+   Shape shape = Shape::Sphere;
+   size_t triangles = 10000;
+   bool use_mapping = true;
+   BufferPool pool;
+   MeshSize size {};
+   build_mesh(shape, triangles, use_mapping, pool, VBO, EBO, size);
+
+   // Unbind VAO
+   glBindVertexArray(0);
+
+   glEnable(GL_DEPTH_TEST);
+
+   bool key_down[8] {};
+   const int shape_keys[5] { GLFW_KEY_1, GLFW_KEY_2, GLFW_KEY_3, GLFW_KEY_4, GLFW_KEY_5 };
+
+   // Create the render loop
+   while (!glfwWindowShouldClose(window))
+   {
+      // Check if the window should close
+      if (glfwGetKey(window, GLFW_KEY_ESCAPE) == GLFW_PRESS)
+         glfwSetWindowShouldClose(window, true);
+
+      // Pick the shape and the detail
+      bool rebuild = false;
+      for (int i = 0; i < 5; ++i)
+         if (key_pressed(window, shape_keys[i], key_down[i]))
+         {
+            shape = Shape(i);
+            rebuild = true;
+         }
+
+      if (key_pressed(window, GLFW_KEY_EQUAL, key_down[5]) && triangles < 100000000)
+      {
+         triangles *= 10;
+         rebuild = true;
+      }
+      if (key_pressed(window, GLFW_KEY_MINUS, key_down[6]) && triangles > 10)
+      {
+         triangles /= 10;
+         rebuild = true;
+      }
+      if (key_pressed(window, GLFW_KEY_M, key_down[7]))
+      {
+         use_mapping = !use_mapping;
+         rebuild = true;
+      }
+
+      if (rebuild)
+      {
+         glBindVertexArray(VAO);
+         if (!build_mesh(shape, triangles, use_mapping, pool, VBO, EBO, size))
+         {
+            std::cout << "Out of memory for " << triangles << " triangles, going back\n";
+            triangles /= 10;
+            if (!build_mesh(shape, triangles, use_mapping, pool, VBO, EBO, size))
+            {
+               // Nothing valid in the buffers, draw nothing until a rebuild works
+               std::cout << "Out of memory for " << triangles << " triangles too, nothing to draw\n";
+               size = {};
+            }
+         }
+         glBindVertexArray(0);
+      }
+
+      // Render
+      glClearColor(.5f, .5f, .5f, 1.f);
+      glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+
+      int width = 0, height = 0;
+      glfwGetFramebufferSize(window, &width, &height);
+      const Mat4 model = multiply(rotate_x(.5f), rotate_y(float(glfwGetTime()) * .3f));
+      const Mat4 view = translate(0.f, 0.f, -3.f);
+      const Mat4 projection = perspective(.785f, height > 0 ? float(width) / height : 1.f, .1f, 100.f);
+
+      // Use the shader program and bind VAO
+      glUseProgram(shader_program);
+      glUniformMatrix4fv(model_location, 1, GL_FALSE, model.m);
+      glUniformMatrix4fv(view_location, 1, GL_FALSE, view.m);
+      glUniformMatrix4fv(projection_location, 1, GL_FALSE, projection.m);
+      glBindVertexArray(VAO);
+
+      // Draw the mesh
+      glDrawElements(GL_TRIANGLES, GLsizei(size.index_count), GL_UNSIGNED_INT, 0);
+
+      // Swap buffers and check and call events
+      glfwSwapBuffers(window);
+      glfwPollEvents();
+   }
+
+   // Clean up
+   glDeleteVertexArrays(1, &VAO);
+   glDeleteBuffers(1, &VBO);
+   glDeleteBuffers(1, &EBO);
+   glDeleteProgram(shader_program);
+   glfwTerminate();
+   return 0;
+}
@@ -0,0 +1,407 @@
+#include <glad/glad.h>
+#include <GLFW/glfw3.h>
+#include <cassert>
+#include <iostream>
+#include "render_graph.h"
+
+// Throw an exception and terminate GLFW
+void throw_ex(const char* msg)
+{
+   std::cout << msg << '\n';
+   glfwTerminate();
+   std::exit(-1);
+}
+
+// Resize callback function
+void framebuffer_size_callback(GLFWwindow* window, int width, int height)
+{
+   assert(width > 0 && height > 0);
+   glViewport(0, 0, width, height);
+
+   // The graph only reallocates its targets at the next compile
+   static_cast<RenderGraph*>(glfwGetWindowUserPointer(window))->resize(width, height);
+}
+
+// Compile a shader and print the info log if it fails
+unsigned compile_shader(GLenum type, const char* source)
+{
+   unsigned shader = glCreateShader(type);
+   glShaderSource(shader, 1, &source, nullptr);
+   glCompileShader(shader);
+
+   int success = 0;
+   char info_log[512] = "\0";
+   glGetShaderiv(shader, GL_COMPILE_STATUS, &success);
+
+   if (!success)
+   {
+      glGetShaderInfoLog(shader, sizeof(info_log), nullptr, info_log);
+      std::cout << "Failed to compile the shader: " << info_log;
+   }
+   return shader;
+}
+
+// Link a vertex and a fragment shader into a program and clean up the shaders
+unsigned link_program(const char* vertex_source, const char* fragment_source)
+{
+   unsigned vertex_shader = compile_shader(GL_VERTEX_SHADER, vertex_source);
+   unsigned fragment_shader = compile_shader(GL_FRAGMENT_SHADER, fragment_source);
+
+   unsigned program = glCreateProgram();
+   glAttachShader(program, vertex_shader);
+   glAttachShader(program, fragment_shader);
+   glLinkProgram(program);
+
+   int success = 0;
+   char info_log[512] = "\0";
+   glGetProgramiv(program, GL_LINK_STATUS, &success);
+
+   if (!success)
+   {
+      glGetProgramInfoLog(program, sizeof(info_log), nullptr, info_log);
+      std::cout << "Failed to link the shader program: " << info_log;
+   }
+
+   glDeleteShader(vertex_shader);
+   glDeleteShader(fragment_shader);
+   return program;
+}
+
+// Main function
+int main()
+{
+   // Scene vertex shader, a ring of spinning pentagons
+   const char* scene_vertex_source =
+      "#version 330 core\n"
+      "layout (location = 0) in vec3 aPos;\n"
+      "uniform float time;\n"
+      "uniform float aspect;\n"
+      "out vec3 Color;\n"
+      "void main()\n"
+      "{\n"
+      "   float angle = time * 0.5 + gl_InstanceID * 0.5236;\n"
+      "   float spin = time * 2.0 + gl_InstanceID;\n"
+      "   vec2 local = mat2(cos(spin), sin(spin), -sin(spin), cos(spin)) * aPos.xy * 0.3;\n"
+      "   vec2 center = vec2(cos(angle), sin(angle)) * 0.6;\n"
+      "   Color = 2.0 * (0.5 + 0.5 * cos(vec3(0.0, 2.1, 4.2) + gl_InstanceID));\n"
+      "   gl_Position = vec4((center.x + local.x) / aspect, center.y + local.y, sin(angle + spin) * 0.5, 1.0);\n"
+      "}\0";
+
+   // Scene fragment shader, colors go above 1 so the bright pass has something to pick up
+   const char* scene_fragment_source =
+      "#version 330 core\n"
+      "in vec3 Color;\n"
+      "out vec4 FragColor;\n"
+      "void main()\n"
+      "{\n"
+      "   FragColor = vec4(Color, 1.0f);\n"
+      "}\0";
+
+   // Full screen triangle for the post passes
+   const char* fullscreen_vertex_source =
+      "#version 330 core\n"
+      "out vec2 TexCoord;\n"
+      "void main()\n"
+      "{\n"
+      "   TexCoord = vec2((gl_VertexID << 1) & 2, gl_VertexID & 2);\n"
+      "   gl_Position = vec4(TexCoord * 2.0 - 1.0, 0.0, 1.0);\n"
+      "}\0";
+
+   // Everything above 1
+   const char* bright_fragment_source =
+      "#version 330 core\n"
+      "in vec2 TexCoord;\n"
+      "uniform sampler2D source;\n"
+      "out vec4 FragColor;\n"
+      "void main()\n"
+      "{\n"
+      "   FragColor = vec4(max(texture(source, TexCoord).rgb - 1.0, 0.0), 1.0);\n"
+      "}\0";
+
+   // One direction of a 9 tap gaussian
+   const char* blur_fragment_source =
+      "#version 330 core\n"
+      "in vec2 TexCoord;\n"
+      "uniform sampler2D source;\n"
+      "uniform vec2 direction;\n"
+      "out vec4 FragColor;\n"
+      "void main()\n"
+      "{\n"
+      "   const float weights[5] = float[](0.227, 0.195, 0.122, 0.054, 0.016);\n"
+      "   vec2 step = direction / vec2(textureSize(source, 0));\n"
+      "   vec3 sum = texture(source, TexCoord).rgb * weights[0];\n"
+      "   for (int i = 1; i < 5; ++i)\n"
+      "      sum += (texture(source, TexCoord + step * i).rgb + texture(source, TexCoord - step * i).rgb) * weights[i];\n"
+      "   FragColor = vec4(sum, 1.0);\n"
+      "}\0";
+
+   // Outlines where the depth jumps, only used while D is toggled on
+   const char* edges_fragment_source =
+      "#version 330 core\n"
+      "in vec2 TexCoord;\n"
+      "uniform sampler2D depth;\n"
+      "out vec4 FragColor;\n"
+      "void main()\n"
+      "{\n"
+      "   vec2 texel = 1.0 / vec2(textureSize(depth, 0));\n"
+      "   float center = texture(depth, TexCoord).r;\n"
+      "   float jump = abs(texture(depth, TexCoord + vec2(texel.x, 0.0)).r - center)\n"
+      "              + abs(texture(depth, TexCoord + vec2(0.0, texel.y)).r - center);\n"
+      "   FragColor = vec4(vec3(step(0.01, jump)), 1.0);\n"
+      "}\0";
+
+   // Scene plus bloom, tone mapped, with the optional outlines on top
+   const char* composite_fragment_source =
+      "#version 330 core\n"
+      "in vec2 TexCoord;\n"
+      "uniform sampler2D scene;\n"
+      "uniform sampler2D bloom;\n"
+      "uniform sampler2D edges;\n"
+      "uniform bool show_edges;\n"
+      "out vec4 FragColor;\n"
+      "void main()\n"
+      "{\n"
+      "   vec3 color = texture(scene, TexCoord).rgb + texture(bloom, TexCoord).rgb;\n"
+      "   color = color / (1.0 + color);\n"
+      "   if (show_edges)\n"
+      "      color = max(color, texture(edges, TexCoord).rgb);\n"
+      "   FragColor = vec4(color, 1.0);\n"
+      "}\0";
+
+   // Initialize GLFW and tell it the version and profile
+   glfwInit();
+   glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
+   glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
+   glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+
+   // Initialize the window
+   GLFWwindow* window = glfwCreateWindow(800, 600, "Render graph.", nullptr, nullptr);
+   if (!window)
+      throw_ex("Failed to create the window!");
+
+   // Set the current window
+   glfwMakeContextCurrent(window);
+
+   // Initialize GLAD
+   if (!gladLoadGLLoader(GLADloadproc(glfwGetProcAddress)))
+      throw_ex("Failed to initialize GLAD!");
+
+   // Set the viewport
+   glViewport(0, 0, 800, 600);
+
+   // Create the shader programs
+   unsigned scene_program = link_program(scene_vertex_source, scene_fragment_source);
+   unsigned bright_program = link_program(fullscreen_vertex_source, bright_fragment_source);
+   unsigned blur_program = link_program(fullscreen_vertex_source, blur_fragment_source);
+   unsigned edges_program = link_program(fullscreen_vertex_source, edges_fragment_source);
+   unsigned composite_program = link_program(fullscreen_vertex_source, composite_fragment_source);
+
+   const int time_location = glGetUniformLocation(scene_program, "time");
+   const int aspect_location = glGetUniformLocation(scene_program, "aspect");
+   const int direction_location = glGetUniformLocation(blur_program, "direction");
+   const int show_edges_location = glGetUniformLocation(composite_program, "show_edges");
+
+   // Samplers never change units
+   glUseProgram(composite_program);
+   glUniform1i(glGetUniformLocation(composite_program, "scene"), 0);
+   glUniform1i(glGetUniformLocation(composite_program, "bloom"), 1);
+   glUniform1i(glGetUniformLocation(composite_program, "edges"), 2);
+
+   // Create pentagon vertices
+   float vertices[]
+   {
+       0.0f,   0.5f, 0.0f, // Top vertex
+       0.5f,   0.0f, 0.0f, // Right vertex
+       0.25f, -0.5f, 0.0f, // Bottom right vertex
+      -0.25f, -0.5f, 0.0f, // Bottom left vertex
+      -0.5f,   0.0f, 0.0f  // Left vertex
+   };
+
+   // Create pentagon indices
+   unsigned indices[]
+   {
+      0, 3, 4, // Left triangle
+      0, 2, 3, // Middle triangle
+      0, 1, 2  // Right triangle
+   };
+
+   // Create the buffer objects
+   unsigned EBO = 0;
+   glGenBuffers(1, &EBO);
+
+   unsigned VBO = 0;
+   glGenBuffers(1, &VBO);
+
+   unsigned VAO = 0;
+   glGenVertexArrays(1, &VAO);
+
+   // Initialize the VAO
+   glBindVertexArray(VAO);
+   glBindBuffer(GL_ARRAY_BUFFER, VBO);
+   glBufferData(GL_ARRAY_BUFFER, sizeof(vertices), vertices, GL_STATIC_DRAW);
+   glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, EBO);
+   glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(indices), indices, GL_STATIC_DRAW);
+
+   // Link vertex attributes
+   glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 3 * sizeof(float), (void*)0);
+   glEnableVertexAttribArray(0);
+
+   // The post passes have no vertex input but core profile still wants a VAO
+   unsigned empty_VAO = 0;
+   glGenVertexArrays(1, &empty_VAO);
+
+   // Unbind VAO
+   glBindVertexArray(0);
+
+   // The scope makes sure the graph releases its textures before glfwTerminate
+   {
+      // The framebuffer can be bigger than the window on HiDPI displays, and the callback only reports changes
+      int framebuffer_width = 0, framebuffer_height = 0;
+      glfwGetFramebufferSize(window, &framebuffer_width, &framebuffer_height);
+      RenderGraph graph(framebuffer_width, framebuffer_height);
+
+      // Set window resize callback, the graph gets told about the new size through the user pointer
+      glfwSetWindowUserPointer(window, &graph);
+      glfwSetFramebufferSizeCallback(window, framebuffer_size_callback);
+
+      // D adds the outline pass, without it the pass is culled and its target never allocated
+      bool show_edges = false, d_down = false;
+      double stats_time = glfwGetTime();
+
+      // Create the render loop
+      while (!glfwWindowShouldClose(window))
+      {
+         // Check if the window should close
+         if (glfwGetKey(window, GLFW_KEY_ESCAPE) == GLFW_PRESS)
+            glfwSetWindowShouldClose(window, true);
+
+         const bool d_pressed = glfwGetKey(window, GLFW_KEY_D) == GLFW_PRESS;
+         if (d_pressed && !d_down)
+            show_edges = !show_edges;
+         d_down = d_pressed;
+
+         int width = 0, height = 0;
+         glfwGetFramebufferSize(window, &width, &height);
+         const float time = float(glfwGetTime());
+
+         // Describe the frame
+         graph.reset();
+         const ResourceId backbuffer = graph.import_backbuffer();
+         const ResourceId scene_color = graph.create_target("scene color", { 1.f, GL_RGBA16F });
+         const ResourceId scene_depth = graph.create_target("scene depth", { 1.f, GL_DEPTH_COMPONENT24 });
+         const ResourceId bright = graph.create_target("bright", { .5f, GL_RGBA16F });
+         const ResourceId blur_x = graph.create_target("blur x", { .5f, GL_RGBA16F });
+         const ResourceId blur_y = graph.create_target("blur y", { .5f, GL_RGBA16F });
+         const ResourceId edges = graph.create_target("edges", { 1.f, GL_RGBA8 });
+
+         graph.add_pass("scene", {}, { scene_color, scene_depth }, [&](RenderGraph&)
+         {
+            glEnable(GL_DEPTH_TEST);
+            glClearColor(.05f, .05f, .1f, 1.f);
+            glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+
+            glUseProgram(scene_program);
+            glUniform1f(time_location, time);
+            glUniform1f(aspect_location, float(width) / float(height));
+            glBindVertexArray(VAO);
+            glDrawElementsInstanced(GL_TRIANGLES, 9, GL_UNSIGNED_INT, 0, 12);
+            glDisable(GL_DEPTH_TEST);
+         });
+
+         graph.add_pass("bright", { scene_color }, { bright }, [&](RenderGraph& g)
+         {
+            glUseProgram(bright_program);
+            glBindVertexArray(empty_VAO);
+            glBindTexture(GL_TEXTURE_2D, g.texture(scene_color));
+            glDrawArrays(GL_TRIANGLES, 0, 3);
+         });
+
+         graph.add_pass("blur x", { bright }, { blur_x }, [&](RenderGraph& g)
+         {
+            glUseProgram(blur_program);
+            glUniform2f(direction_location, 1.f, 0.f);
+            glBindVertexArray(empty_VAO);
+            glBindTexture(GL_TEXTURE_2D, g.texture(bright));
+            glDrawArrays(GL_TRIANGLES, 0, 3);
+         });
+
+         graph.add_pass("blur y", { blur_x }, { blur_y }, [&](RenderGraph& g)
+         {
+            glUseProgram(blur_program);
+            glUniform2f(direction_location, 0.f, 1.f);
+            glBindVertexArray(empty_VAO);
+            glBindTexture(GL_TEXTURE_2D, g.texture(blur_x));
+            glDrawArrays(GL_TRIANGLES, 0, 3);
+         });
+
+         graph.add_pass("edges", { scene_depth }, { edges }, [&](RenderGraph& g)
+         {
+            glUseProgram(edges_program);
+            glBindVertexArray(empty_VAO);
+            glBindTexture(GL_TEXTURE_2D, g.texture(scene_depth));
+            glDrawArrays(GL_TRIANGLES, 0, 3);
+         });
+
+         std::vector<ResourceId> composite_reads { scene_color, blur_y };
+         if (show_edges)
+            composite_reads.push_back(edges);
+
+         graph.add_pass("composite", composite_reads, { backbuffer }, [&](RenderGraph& g)
+         {
+            glClearColor(.5f, .5f, .5f, 1.f);
+            glClear(GL_COLOR_BUFFER_BIT);
+
+            glUseProgram(composite_program);
+            glUniform1i(show_edges_location, show_edges);
+            glBindVertexArray(empty_VAO);
+            glActiveTexture(GL_TEXTURE0);
+            glBindTexture(GL_TEXTURE_2D, g.texture(scene_color));
+            glActiveTexture(GL_TEXTURE1);
+            glBindTexture(GL_TEXTURE_2D, g.texture(blur_y));
+            glActiveTexture(GL_TEXTURE2);
+            glBindTexture(GL_TEXTURE_2D, show_edges ? g.texture(edges) : 0);
+            glActiveTexture(GL_TEXTURE0);
+            glDrawArrays(GL_TRIANGLES, 0, 3);
+         });
+
+         // Cull, order, alias and run
+         graph.compile();
+         graph.execute();
+         glBindVertexArray(0);
+
+         // Print what the graph did once a second
+         const double now = glfwGetTime();
+         if (now - stats_time >= 1.0)
+         {
+            const RenderGraph::Stats& stats = graph.get_stats();
+            std::cout << stats.passes - stats.culled_passes << " of " << stats.passes << " passes, " << stats.targets
+                      << " targets in " << stats.textures << " textures, " << stats.bytes_declared / 1048576.0
+                      << " MB declared, " << stats.bytes_without_aliasing / 1048576.0 << " MB after culling, "
+                      << stats.bytes_allocated / 1048576.0 << " MB after aliasing ("
+                      << (stats.bytes_declared - stats.bytes_allocated) / 1048576.0 << " MB saved), "
+                      << stats.reallocations << " reallocations\n";
+            stats_time = now;
+         }
+
+         // Swap buffers and check and call events
+         glfwSwapBuffers(window);
+         glfwPollEvents();
+      }
+
+      glfwSetWindowUserPointer(window, nullptr);
+      glfwSetFramebufferSizeCallback(window, nullptr);
+   }
+
+   // Clean up
+   glDeleteVertexArrays(1, &VAO);
+   glDeleteVertexArrays(1, &empty_VAO);
+   glDeleteBuffers(1, &VBO);
+   glDeleteBuffers(1, &EBO);
+   glDeleteProgram(scene_program);
+   glDeleteProgram(bright_program);
+   glDeleteProgram(blur_program);
+   glDeleteProgram(edges_program);
+   glDeleteProgram(composite_program);
+   glfwTerminate();
+   return 0;
+}
@@ -0,0 +1,409 @@
+#pragma once
+#include <glad/glad.h>
+#include <algorithm>
+#include <cassert>
+#include <cstddef>
+#include <functional>
+#include <iostream>
+#include <map>
+#include <string>
+#include <vector>
+
+// Frame graph of render passes over transient render targets
+// Passes are added every frame with the targets they read and write, then compile() drops passes whose
+// output nobody uses, orders the rest by their dependencies and gives every transient target a texture.
+// Targets with the same size and format whose lifetimes don't overlap share one texture. Textures are
+// pooled across frames and only recreated when the backbuffer size has actually changed by the next
+// compile, so a stream of resize events during a window drag costs one reallocation. A texture that no
+// target of a frame uses is released at the end of that compile.
+
+using ResourceId = int;
+
+// Transient target, its size is relative to the backbuffer
+struct RenderTargetDesc
+{
+   float scale;
+   GLenum format;
+};
+
+class RenderGraph
+{
+public:
+   // Memory of the last compiled frame
+   struct Stats
+   {
+      size_t passes;
+      size_t culled_passes;
+      size_t targets;
+      size_t textures;
+      size_t bytes_declared;
+      size_t bytes_without_aliasing;
+      size_t bytes_allocated;
+      size_t reallocations;
+   };
+
+   RenderGraph(int width, int height) : width(width), height(height), pending_width(width), pending_height(height) {}
+
+   RenderGraph(const RenderGraph&) = delete;
+   RenderGraph& operator=(const RenderGraph&) = delete;
+
+   // The context has to still be current
+   ~RenderGraph() { release_textures(); }
+
+   // Only remembers the size, the targets are reallocated at the next compile
+   void resize(int new_width, int new_height)
+   {
+      pending_width = new_width;
+      pending_height = new_height;
+   }
+
+   // Drop last frame's passes and targets, the textures stay pooled
+   void reset()
+   {
+      resources.clear();
+      passes.clear();
+      order.clear();
+   }
+
+   ResourceId create_target(const char* name, RenderTargetDesc desc)
+   {
+      resources.push_back({ name, desc, false });
+      return ResourceId(resources.size() - 1);
+   }
+
+   // The default framebuffer, passes writing it are never culled
+   ResourceId import_backbuffer()
+   {
+      resources.push_back({ "backbuffer", { 1.f, GL_RGBA8 }, true });
+      return ResourceId(resources.size() - 1);
+   }
+
+   void add_pass(const char* name, std::vector<ResourceId> reads, std::vector<ResourceId> writes, std::function<void(RenderGraph&)> execute)
+   {
+      for (ResourceId id : writes)
+      {
+         assert(resources[id].producer < 0 && "every target is written by one pass");
+         resources[id].producer = int(passes.size());
+      }
+      passes.push_back({ name, std::move(reads), std::move(writes), std::move(execute) });
+   }
+
+   // Cull, order and assign textures
+   void compile()
+   {
+      if (pending_width != width || pending_height != height)
+      {
+         width = pending_width;
+         height = pending_height;
+         release_textures();
+         ++stats.reallocations;
+      }
+
+      // Keep passes that write the backbuffer and everything they depend on
+      std::vector<int> stack;
+      for (size_t p = 0; p < passes.size(); ++p)
+         for (ResourceId id : passes[p].writes)
+            if (resources[id].imported)
+               stack.push_back(int(p));
+
+      while (!stack.empty())
+      {
+         Pass& pass = passes[stack.back()];
+         stack.pop_back();
+         if (pass.alive)
+            continue;
+
+         pass.alive = true;
+         for (ResourceId id : pass.reads)
+            if (resources[id].producer >= 0)
+               stack.push_back(resources[id].producer);
+      }
+
+      // Order the live passes so producers run first, ties go in the order the passes were added
+      // A pass reading a target it writes itself, a read-modify-write, doesn't wait on itself
+      std::vector<int> waiting(passes.size(), 0);
+      for (size_t p = 0; p < passes.size(); ++p)
+         for (ResourceId id : passes[p].reads)
+            if (resources[id].producer >= 0 && resources[id].producer != int(p))
+               ++waiting[p];
+
+      std::vector<bool> done(passes.size(), false);
+      for (bool progress = true; progress;)
+      {
+         progress = false;
+         for (size_t p = 0; p < passes.size(); ++p)
+         {
+            if (!passes[p].alive || done[p] || waiting[p] > 0)
+               continue;
+
+            done[p] = progress = true;
+            order.push_back(int(p));
+            for (ResourceId written : passes[p].writes)
+               for (size_t q = 0; q < passes.size(); ++q)
+                  if (q != p)
+                     waiting[q] -= int(std::count(passes[q].reads.begin(), passes[q].reads.end(), written));
+            break;
+         }
+      }
+
+      // Whatever is live and still waiting is in a dependency cycle or reads from one, it can't run
+      for (size_t p = 0; p < passes.size(); ++p)
+         if (passes[p].alive && !done[p])
+         {
+            std::cout << "Pass " << passes[p].name << " is in or behind a dependency cycle and was skipped!\n";
+            assert(false && "the pass dependencies have a cycle");
+         }
+
+      // Lifetime of every target in execution order
+      for (size_t step = 0; step < order.size(); ++step)
+      {
+         const Pass& pass = passes[order[step]];
+         for (const std::vector<ResourceId>* list : { &pass.writes, &pass.reads })
+            for (ResourceId id : *list)
+            {
+               Resource& resource = resources[id];
+               resource.first = resource.first < 0 ? int(step) : resource.first;
+               resource.last = int(step);
+            }
+      }
+
+      // Give targets textures in order of first use, reusing any texture whose last user has already run
+      std::vector<int> by_first;
+      for (size_t id = 0; id < resources.size(); ++id)
+         if (!resources[id].imported && resources[id].first >= 0)
+            by_first.push_back(int(id));
+      std::sort(by_first.begin(), by_first.end(), [&](int a, int b) { return resources[a].first < resources[b].first; });
+
+      for (PooledTexture& texture : pool)
+         texture.busy_until = -1;
+
+      stats = { passes.size(), passes.size() - order.size(), by_first.size(), 0, 0, 0, 0, stats.reallocations };
+      for (const Resource& resource : resources)
+         if (!resource.imported)
+            stats.bytes_declared += target_bytes(std::max(1, int(width * resource.desc.scale)),
+               std::max(1, int(height * resource.desc.scale)), resource.desc.format);
+
+      for (int id : by_first)
+      {
+         Resource& resource = resources[id];
+         const int target_width = std::max(1, int(width * resource.desc.scale));
+         const int target_height = std::max(1, int(height * resource.desc.scale));
+         stats.bytes_without_aliasing += target_bytes(target_width, target_height, resource.desc.format);
+
+         PooledTexture* match = nullptr;
+         for (PooledTexture& texture : pool)
+            if (texture.format == resource.desc.format && texture.width == target_width && texture.height == target_height
+               && texture.busy_until < resource.first)
+            {
+               match = &texture;
+               break;
+            }
+
+         if (!match)
+         {
+            pool.push_back({ create_texture(target_width, target_height, resource.desc.format), target_width, target_height,
+               resource.desc.format, -1 });
+            match = &pool.back();
+         }
+
+         if (match->busy_until < 0)
+         {
+            ++stats.textures;
+            stats.bytes_allocated += target_bytes(target_width, target_height, resource.desc.format);
+         }
+         match->busy_until = resource.last;
+         resource.texture = match->texture;
+         resource.width = target_width;
+         resource.height = target_height;
+      }
+
+      // Textures no target used this frame, like the one of a pass that is culled now, go back to the driver
+      for (auto it = pool.begin(); it != pool.end();)
+      {
+         if (it->busy_until >= 0)
+         {
+            ++it;
+            continue;
+         }
+         release_framebuffers(it->texture);
+         glDeleteTextures(1, &it->texture);
+         it = pool.erase(it);
+      }
+   }
+
+   // Run the live passes, each one with its targets bound and the viewport set
+   void execute()
+   {
+      for (int index : order)
+      {
+         Pass& pass = passes[index];
+         std::vector<unsigned> attachments;
+         int pass_width = width, pass_height = height;
+         bool backbuffer = false;
+
+         for (ResourceId id : pass.writes)
+         {
+            backbuffer = backbuffer || resources[id].imported;
+            if (!resources[id].imported)
+            {
+               attachments.push_back(resources[id].texture);
+               pass_width = resources[id].width;
+               pass_height = resources[id].height;
+            }
+         }
+
+         glBindFramebuffer(GL_FRAMEBUFFER, backbuffer ? 0 : framebuffer(pass.writes, attachments));
+         glViewport(0, 0, pass_width, pass_height);
+         pass.execute(*this);
+      }
+      glBindFramebuffer(GL_FRAMEBUFFER, 0);
+   }
+
+   // Texture behind a target, for passes to sample what they read
+   unsigned texture(ResourceId id) const { return resources[id].texture; }
+
+   const Stats& get_stats() const { return stats; }
+
+private:
+   struct Resource
+   {
+      std::string name;
+      RenderTargetDesc desc;
+      bool imported;
+      int producer = -1;
+      int first = -1, last = -1;
+      unsigned texture = 0;
+      int width = 0, height = 0;
+   };
+
+   struct Pass
+   {
+      std::string name;
+      std::vector<ResourceId> reads, writes;
+      std::function<void(RenderGraph&)> execute;
+      bool alive = false;
+   };
+
+   struct PooledTexture
+   {
+      unsigned texture;
+      int width, height;
+      GLenum format;
+      int busy_until;
+   };
+
+   static bool is_depth(GLenum format)
+   {
+      return format == GL_DEPTH_COMPONENT24 || format == GL_DEPTH_COMPONENT32F || has_stencil(format);
+   }
+
+   static bool has_stencil(GLenum format)
+   {
+      return format == GL_DEPTH24_STENCIL8 || format == GL_DEPTH32F_STENCIL8;
+   }
+
+   static size_t target_bytes(int width, int height, GLenum format)
+   {
+      size_t texel = 4;
+      if (format == GL_RGBA16F || format == GL_DEPTH32F_STENCIL8)
+         texel = 8;
+      else if (format == GL_RGBA32F)
+         texel = 16;
+      else if (format == GL_R8)
+         texel = 1;
+      return size_t(width) * height * texel;
+   }
+
+   static unsigned create_texture(int width, int height, GLenum format)
+   {
+      unsigned texture = 0;
+      glGenTextures(1, &texture);
+      glBindTexture(GL_TEXTURE_2D, texture);
+
+      if (format == GL_DEPTH24_STENCIL8)
+         glTexImage2D(GL_TEXTURE_2D, 0, format, width, height, 0, GL_DEPTH_STENCIL, GL_UNSIGNED_INT_24_8, nullptr);
+      else if (format == GL_DEPTH32F_STENCIL8)
+         glTexImage2D(GL_TEXTURE_2D, 0, format, width, height, 0, GL_DEPTH_STENCIL, GL_FLOAT_32_UNSIGNED_INT_24_8_REV, nullptr);
+      else if (is_depth(format))
+         glTexImage2D(GL_TEXTURE_2D, 0, format, width, height, 0, GL_DEPTH_COMPONENT, GL_FLOAT, nullptr);
+      else
+         glTexImage2D(GL_TEXTURE_2D, 0, format, width, height, 0, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+
+      glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+      glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+      glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+      glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+      glBindTexture(GL_TEXTURE_2D, 0);
+      return texture;
+   }
+
+   // One FBO per set of attachments, cached until the textures are released
+   unsigned framebuffer(const std::vector<ResourceId>& writes, const std::vector<unsigned>& attachments)
+   {
+      auto it = framebuffers.find(attachments);
+      if (it != framebuffers.end())
+         return it->second;
+
+      unsigned fbo = 0;
+      glGenFramebuffers(1, &fbo);
+      glBindFramebuffer(GL_FRAMEBUFFER, fbo);
+
+      std::vector<GLenum> draw_buffers;
+      for (ResourceId id : writes)
+      {
+         const Resource& resource = resources[id];
+         if (is_depth(resource.desc.format))
+         {
+            const GLenum attachment = has_stencil(resource.desc.format) ? GL_DEPTH_STENCIL_ATTACHMENT : GL_DEPTH_ATTACHMENT;
+            glFramebufferTexture2D(GL_FRAMEBUFFER, attachment, GL_TEXTURE_2D, resource.texture, 0);
+         }
+         else
+         {
+            draw_buffers.push_back(GLenum(GL_COLOR_ATTACHMENT0 + draw_buffers.size()));
+            glFramebufferTexture2D(GL_FRAMEBUFFER, draw_buffers.back(), GL_TEXTURE_2D, resource.texture, 0);
+         }
+      }
+      glDrawBuffers(GLsizei(draw_buffers.size()), draw_buffers.data());
+
+      if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
+         std::cout << "Framebuffer is not complete!\n";
+
+      framebuffers[attachments] = fbo;
+      return fbo;
+   }
+
+   // Framebuffers that have the texture attached
+   void release_framebuffers(unsigned texture)
+   {
+      for (auto it = framebuffers.begin(); it != framebuffers.end();)
+      {
+         if (std::find(it->first.begin(), it->first.end(), texture) == it->first.end())
+         {
+            ++it;
+            continue;
+         }
+         glDeleteFramebuffers(1, &it->second);
+         it = framebuffers.erase(it);
+      }
+   }
+
+   void release_textures()
+   {
+      for (const auto& entry : framebuffers)
+         glDeleteFramebuffers(1, &entry.second);
+      framebuffers.clear();
+
+      for (const PooledTexture& texture : pool)
+         glDeleteTextures(1, &texture.texture);
+      pool.clear();
+   }
+
+   int width, height;
+   int pending_width, pending_height;
+   std::vector<Resource> resources;
+   std::vector<Pass> passes;
+   std::vector<int> order;
+   std::vector<PooledTexture> pool;
+   std::map<std::vector<unsigned>, unsigned> framebuffers;
+   Stats stats {};
+};
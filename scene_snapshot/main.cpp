@@ -0,0 +1,574 @@
+#include <glad/glad.h>
+#include <GLFW/glfw3.h>
+#include <algorithm>
+#include <cassert>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <vector>
+#include "snapshot.h"
+
+// Throw an exception and terminate GLFW
+void throw_ex(const char* msg)
+{
+   std::cout << msg << '\n';
+   glfwTerminate();
+   std::exit(-1);
+}
+
+// Resize callback function
+void framebuffer_size_callback(GLFWwindow*, int width, int height)
+{
+   assert(width > 0 && height > 0);
+   glViewport(0, 0, width, height);
+}
+
+// Compile a shader and print the info log if it fails
+unsigned compile_shader(GLenum type, const char* source)
+{
+   unsigned shader = glCreateShader(type);
+   glShaderSource(shader, 1, &source, nullptr);
+   glCompileShader(shader);
+
+   int success = 0;
+   char info_log[512] = "\0";
+   glGetShaderiv(shader, GL_COMPILE_STATUS, &success);
+
+   if (!success)
+   {
+      glGetShaderInfoLog(shader, sizeof(info_log), nullptr, info_log);
+      std::cout << "Failed to compile the shader: " << info_log;
+   }
+   return shader;
+}
+
+// Link a vertex and a fragment shader into a program and clean up the shaders
+// A retrievable program can be read back with glGetProgramBinary
+unsigned link_program(const char* vertex_source, const char* fragment_source, bool retrievable = false)
+{
+   unsigned vertex_shader = compile_shader(GL_VERTEX_SHADER, vertex_source);
+   unsigned fragment_shader = compile_shader(GL_FRAGMENT_SHADER, fragment_source);
+
+   unsigned program = glCreateProgram();
+   glAttachShader(program, vertex_shader);
+   glAttachShader(program, fragment_shader);
+   if (retrievable)
+      glProgramParameteri(program, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+   glLinkProgram(program);
+
+   int success = 0;
+   char info_log[512] = "\0";
+   glGetProgramiv(program, GL_LINK_STATUS, &success);
+
+   if (!success)
+   {
+      glGetProgramInfoLog(program, sizeof(info_log), nullptr, info_log);
+      std::cout << "Failed to link the shader program: " << info_log;
+   }
+
+   glDeleteShader(vertex_shader);
+   glDeleteShader(fragment_shader);
+   return program;
+}
+
+// Whether the context exposes an extension, asked at runtime since the GLAD build may not know it at all
+bool has_gl_extension(const char* name)
+{
+   int count = 0;
+   glGetIntegerv(GL_NUM_EXTENSIONS, &count);
+   for (int i = 0; i < count; ++i)
+   {
+      const char* extension = reinterpret_cast<const char*>(glGetStringi(GL_EXTENSIONS, unsigned(i)));
+      if (extension && std::strcmp(extension, name) == 0)
+         return true;
+   }
+   return false;
+}
+
+// Milliseconds since a point in time
+double ms_since(std::chrono::steady_clock::time_point start)
+{
+   return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+// Shaders of the two vertex layouts, lit patches with normals and patches with vertex colors
+const char* lit_vertex_source =
+   "#version 330 core\n"
+   "layout (location = 0) in vec3 aPos;\n"
+   "layout (location = 1) in vec3 aNormal;\n"
+   "uniform vec4 placement;\n"
+   "out vec3 Shade;\n"
+   "void main()\n"
+   "{\n"
+   "   Shade = vec3(0.3 + 0.7 * max(dot(normalize(aNormal), normalize(vec3(0.4, 1.0, 0.3))), 0.0));\n"
+   "   gl_Position = vec4((aPos.xz * placement.z + placement.xy) * 2.0 - 1.0, 0.0, 1.0);\n"
+   "}\0";
+
+const char* colored_vertex_source =
+   "#version 330 core\n"
+   "layout (location = 0) in vec3 aPos;\n"
+   "layout (location = 1) in vec4 aColor;\n"
+   "uniform vec4 placement;\n"
+   "out vec3 Shade;\n"
+   "void main()\n"
+   "{\n"
+   "   Shade = aColor.rgb;\n"
+   "   gl_Position = vec4((aPos.xz * placement.z + placement.xy) * 2.0 - 1.0, 0.0, 1.0);\n"
+   "}\0";
+
+const char* fragment_shader_source =
+   "#version 330 core\n"
+   "in vec3 Shade;\n"
+   "uniform vec4 color;\n"
+   "out vec4 FragColor;\n"
+   "void main()\n"
+   "{\n"
+   "   FragColor = vec4(Shade * color.rgb, 1.0);\n"
+   "}\0";
+
+// The scene the way every other sample makes its own, computed in code at launch
+// Height field patches, alternating between the two layouts, until the data reaches the requested size
+struct SceneSource
+{
+   std::vector<unsigned char> data;
+   std::vector<SnapshotLayout> layouts;
+   std::vector<SnapshotMaterial> materials;
+   std::vector<SnapshotMesh> meshes;
+};
+
+float height(float x, float z)
+{
+   return .5f * std::sin(x * .9f) * std::cos(z * .7f) + .25f * std::sin(x * 2.3f + z * 1.7f);
+}
+
+SceneSource build_scene(size_t bytes)
+{
+   const int patch = 128;
+   const uint32_t vertex_count = patch * patch, index_count = (patch - 1) * (patch - 1) * 6;
+
+   SceneSource scene;
+   scene.layouts = {
+      { 24, 2, { { 0, 3, GL_FLOAT, GL_FALSE, 0 }, { 1, 3, GL_FLOAT, GL_FALSE, 12 } } },
+      { 16, 2, { { 0, 3, GL_FLOAT, GL_FALSE, 0 }, { 1, 4, GL_UNSIGNED_BYTE, GL_TRUE, 12 } } },
+   };
+   scene.materials = {
+      { { .6f, .8f, .5f, 1.f }, 0, {} },
+      { { .9f, .8f, .6f, 1.f }, 0, {} },
+      { { 1.f, 1.f, 1.f, 1.f }, 1, {} },
+      { { .7f, .8f, 1.f, 1.f }, 1, {} },
+   };
+
+   // Patches are laid out on a square grid, so count them first
+   const size_t average_bytes = (24 + 16) / 2 * vertex_count + index_count * 4;
+   const size_t mesh_count = std::max<size_t>(1, bytes / average_bytes);
+   const int side = int(std::ceil(std::sqrt(double(mesh_count))));
+   scene.data.reserve(mesh_count * (average_bytes + 2 * snapshot_data_alignment) + 24 * vertex_count);
+
+   std::vector<uint32_t> indices;
+   for (int y = 0; y < patch - 1; ++y)
+      for (int x = 0; x < patch - 1; ++x)
+      {
+         const uint32_t corner = uint32_t(y * patch + x);
+         indices.insert(indices.end(), { corner, corner + 1, corner + patch, corner + 1, corner + patch + 1, corner + patch });
+      }
+
+   auto append = [&](const void* bytes, size_t size) {
+      scene.data.resize((scene.data.size() + snapshot_data_alignment - 1) / snapshot_data_alignment * snapshot_data_alignment);
+      const uint64_t offset = scene.data.size();
+      scene.data.insert(scene.data.end(), static_cast<const unsigned char*>(bytes), static_cast<const unsigned char*>(bytes) + size);
+      return offset;
+   };
+
+   std::vector<unsigned char> vertices;
+   for (size_t i = 0; i < mesh_count; ++i)
+   {
+      const uint32_t layout = uint32_t(i % 2);
+      const float grid_x = float(i % side), grid_y = float(i / side);
+      vertices.resize(size_t(scene.layouts[layout].stride) * vertex_count);
+
+      unsigned char* vertex = vertices.data();
+      for (int y = 0; y < patch; ++y)
+         for (int x = 0; x < patch; ++x)
+         {
+            const float u = float(x) / (patch - 1), v = float(y) / (patch - 1);
+            const float world_x = (grid_x + u) * 2.f, world_z = (grid_y + v) * 2.f;
+            const float position[3] { u, height(world_x, world_z), v };
+            std::memcpy(vertex, position, sizeof(position));
+
+            if (layout == 0)
+            {
+               // Normal from the slope of the height field
+               const float dx = (height(world_x + .01f, world_z) - height(world_x - .01f, world_z)) / .02f;
+               const float dz = (height(world_x, world_z + .01f) - height(world_x, world_z - .01f)) / .02f;
+               const float length = std::sqrt(dx * dx + 1.f + dz * dz);
+               const float normal[3] { -dx / length, 1.f / length, -dz / length };
+               std::memcpy(vertex + 12, normal, sizeof(normal));
+            }
+            else
+            {
+               const float shade = .5f + .5f * position[1];
+               const unsigned char color[4] { (unsigned char)(255 * shade), (unsigned char)(160 * shade), (unsigned char)(255 * (1.f - shade)), 255 };
+               std::memcpy(vertex + 12, color, sizeof(color));
+            }
+            vertex += scene.layouts[layout].stride;
+         }
+
+      SnapshotMesh mesh {};
+      mesh.vertex_offset = append(vertices.data(), vertices.size());
+      mesh.index_offset = append(indices.data(), indices.size() * sizeof(uint32_t));
+      mesh.vertex_count = vertex_count;
+      mesh.index_count = index_count;
+      mesh.layout = layout;
+      mesh.material = layout * 2 + uint32_t(i / 2 % 2);
+      const float placement[4] { grid_x / side, grid_y / side, 1.f / side, 0.f };
+      std::memcpy(mesh.placement, placement, sizeof(placement));
+      scene.meshes.push_back(mesh);
+   }
+   return scene;
+}
+
+// Scene on the GPU: all meshes in one buffer that holds both vertices and indices, a VAO per mesh
+struct GpuScene
+{
+   struct Draw
+   {
+      unsigned VAO;
+      unsigned program;
+      int placement_location, color_location;
+      GLsizei index_count;
+      uint64_t index_offset;
+      float placement[4];
+      float color[4];
+   };
+
+   unsigned buffer = 0;
+   std::vector<unsigned> programs;
+   std::vector<Draw> draws;
+
+   void render() const
+   {
+      for (const Draw& draw : draws)
+      {
+         glUseProgram(draw.program);
+         glUniform4fv(draw.placement_location, 1, draw.placement);
+         glUniform4fv(draw.color_location, 1, draw.color);
+         glBindVertexArray(draw.VAO);
+         glDrawElements(GL_TRIANGLES, draw.index_count, GL_UNSIGNED_INT, (void*)uintptr_t(draw.index_offset));
+      }
+      glBindVertexArray(0);
+   }
+
+   void destroy()
+   {
+      for (const Draw& draw : draws)
+         glDeleteVertexArrays(1, &draw.VAO);
+      for (unsigned program : programs)
+         glDeleteProgram(program);
+      glDeleteBuffers(1, &buffer);
+      draws.clear();
+      programs.clear();
+      buffer = 0;
+   }
+};
+
+// Copy the data into one buffer in 64 MB pieces and wait until the driver has it
+unsigned upload(const unsigned char* data, size_t size)
+{
+   unsigned buffer = 0;
+   glGenBuffers(1, &buffer);
+   glBindBuffer(GL_ARRAY_BUFFER, buffer);
+   glBufferData(GL_ARRAY_BUFFER, GLsizeiptr(size), nullptr, GL_STATIC_DRAW);
+
+   const size_t piece = size_t(64) << 20;
+   for (size_t offset = 0; offset < size; offset += piece)
+      glBufferSubData(GL_ARRAY_BUFFER, GLintptr(offset), GLsizeiptr(std::min(piece, size - offset)), data + offset);
+   glBindBuffer(GL_ARRAY_BUFFER, 0);
+   glFinish();
+   return buffer;
+}
+
+// One VAO per mesh pointing into the shared buffer, the offsets come straight from the records
+void create_draws(GpuScene& scene, const SnapshotLayout* layouts, const SnapshotMaterial* materials, const SnapshotMesh* meshes, size_t mesh_count)
+{
+   for (size_t i = 0; i < mesh_count; ++i)
+   {
+      const SnapshotMesh& mesh = meshes[i];
+      const SnapshotLayout& layout = layouts[mesh.layout];
+      const SnapshotMaterial& material = materials[mesh.material];
+
+      GpuScene::Draw draw {};
+      glGenVertexArrays(1, &draw.VAO);
+      glBindVertexArray(draw.VAO);
+      glBindBuffer(GL_ARRAY_BUFFER, scene.buffer);
+      glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, scene.buffer);
+      for (uint32_t a = 0; a < layout.attribute_count; ++a)
+      {
+         const SnapshotAttribute& attribute = layout.attributes[a];
+         glVertexAttribPointer(attribute.location, GLint(attribute.components), attribute.type, GLboolean(attribute.normalized),
+            GLsizei(layout.stride), (void*)uintptr_t(mesh.vertex_offset + attribute.offset));
+         glEnableVertexAttribArray(attribute.location);
+      }
+      glBindVertexArray(0);
+
+      draw.program = scene.programs[material.program];
+      draw.placement_location = glGetUniformLocation(draw.program, "placement");
+      draw.color_location = glGetUniformLocation(draw.program, "color");
+      draw.index_count = GLsizei(mesh.index_count);
+      draw.index_offset = mesh.index_offset;
+      std::memcpy(draw.placement, mesh.placement, sizeof(draw.placement));
+      std::memcpy(draw.color, material.color, sizeof(draw.color));
+      scene.draws.push_back(draw);
+   }
+   glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
+
+// Write the prepared scene and the binaries of its linked programs
+bool write_snapshot(const char* path, const SceneSource& source, const std::vector<unsigned>& programs, bool binaries)
+{
+   SnapshotWriter writer(path);
+   writer.add_data(source.data.data(), source.data.size());
+   writer.layouts = source.layouts;
+   writer.materials = source.materials;
+   writer.meshes = source.meshes;
+
+   const char* vertex_sources[] { lit_vertex_source, colored_vertex_source };
+   for (size_t i = 0; i < programs.size(); ++i)
+   {
+      SnapshotProgram record {};
+      record.vertex_source = writer.add_meta(vertex_sources[i], std::strlen(vertex_sources[i]) + 1);
+      record.fragment_source = writer.add_meta(fragment_shader_source, std::strlen(fragment_shader_source) + 1);
+
+      int length = 0;
+      if (binaries)
+         glGetProgramiv(programs[i], GL_PROGRAM_BINARY_LENGTH, &length);
+      if (length > 0)
+      {
+         std::vector<char> binary(static_cast<size_t>(length));
+         GLenum format = 0;
+         glGetProgramBinary(programs[i], length, &length, &format, binary.data());
+         record.binary = writer.add_meta(binary.data(), size_t(length));
+         record.binary_format = format;
+      }
+      writer.programs.push_back(record);
+   }
+   return writer.finish();
+}
+
+// Map the snapshot and make the GPU scene from it, the timings of every step go to std::cout
+bool load_snapshot(const char* path, bool binaries, GpuScene& scene)
+{
+   auto start = std::chrono::steady_clock::now();
+   MappedFile file;
+   SnapshotView view;
+   if (!file.open(path))
+   {
+      std::cout << "Failed to open " << path << '\n';
+      return false;
+   }
+
+   double open_ms = ms_since(start);
+
+   // Asking the page cache walks every page, so it stays out of the timing
+   const double resident = file.resident_fraction();
+
+   start = std::chrono::steady_clock::now();
+   if (!view.open(file.data(), file.get_size()))
+   {
+      std::cout << "Failed to read " << path << ": " << view.get_error() << '\n';
+      return false;
+   }
+   open_ms += ms_since(start);
+
+   // The binary only works on the driver that made it, after an update the sources are compiled instead
+   start = std::chrono::steady_clock::now();
+   int from_binary = 0;
+   for (size_t i = 0; i < view.program_count(); ++i)
+   {
+      const SnapshotProgram& record = view.programs()[i];
+      unsigned program = 0;
+      if (binaries && record.binary.size)
+      {
+         program = glCreateProgram();
+         glProgramBinary(program, record.binary_format, view.meta(record.binary), GLsizei(record.binary.size));
+
+         int success = 0;
+         glGetProgramiv(program, GL_LINK_STATUS, &success);
+         if (success)
+            ++from_binary;
+         else
+         {
+            glDeleteProgram(program);
+            program = 0;
+         }
+      }
+      if (!program)
+         program = link_program(view.meta(record.vertex_source), view.meta(record.fragment_source));
+      scene.programs.push_back(program);
+   }
+   const double programs_ms = ms_since(start);
+
+   start = std::chrono::steady_clock::now();
+   scene.buffer = upload(view.data(), view.data_size());
+   const double upload_ms = ms_since(start);
+
+   start = std::chrono::steady_clock::now();
+   create_draws(scene, view.layouts(), view.materials(), view.meshes(), view.mesh_count());
+   const double draws_ms = ms_since(start);
+
+   std::cout << "   " << (resident < 0.0 ? 0.0 : resident * 100.0) << "% in the page cache, " << open_ms << " ms map and check, "
+             << programs_ms << " ms programs (" << from_binary << '/' << view.program_count() << " from binaries), "
+             << upload_ms << " ms upload (" << view.data_size() / 1e3 / upload_ms << " MB/s), " << draws_ms << " ms VAOs, "
+             << open_ms + programs_ms + upload_ms + draws_ms << " ms total\n";
+   return true;
+}
+
+// Main function
+// Usage: scene_snapshot [--rebuild] [megabytes of mesh data, 1024 by default] [snapshot path]
+// The size only matters when the snapshot is built, an existing one is loaded as it is
+int main(int argc, char** argv)
+{
+   bool rebuild = false;
+   std::vector<const char*> args;
+   for (int i = 1; i < argc; ++i)
+   {
+      if (std::strcmp(argv[i], "--rebuild") == 0)
+         rebuild = true;
+      else
+         args.push_back(argv[i]);
+   }
+   const size_t megabytes = args.size() > 0 ? size_t(std::strtoul(args[0], nullptr, 10)) : 1024;
+   const char* path = args.size() > 1 ? args[1] : "scene.snapshot";
+
+   // Initialize GLFW and tell it the version and profile
+   glfwInit();
+   glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
+   glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
+   glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+
+   // Initialize the window
+   GLFWwindow* window = glfwCreateWindow(800, 600, "Scene snapshot.", nullptr, nullptr);
+   if (!window)
+      throw_ex("Failed to create the window!");
+
+   // Set the current window
+   glfwMakeContextCurrent(window);
+
+   // Initialize GLAD
+   if (!gladLoadGLLoader(GLADloadproc(glfwGetProcAddress)))
+      throw_ex("Failed to initialize GLAD!");
+
+   // Set the viewport
+   glViewport(0, 0, 800, 600);
+
+   // Set window resize callback
+   glfwSetFramebufferSizeCallback(window, framebuffer_size_callback);
+
+   // Program binaries need GL 4.1 or the extension, and a driver that offers at least one format
+   int binary_formats = 0;
+   if (GLAD_GL_VERSION_4_1 || has_gl_extension("GL_ARB_get_program_binary"))
+      glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &binary_formats);
+   const bool binaries = binary_formats > 0;
+
+   // A snapshot from an earlier launch is used as long as it still reads, that is the whole point of it
+   // Its indices are checked here once, the timed loads below only do the constant time checks of open
+   if (!rebuild)
+   {
+      MappedFile file;
+      SnapshotView view;
+      if (!file.open(path))
+      {
+         std::cout << "No snapshot at " << path << ", building one\n";
+         rebuild = true;
+      }
+      else if (!view.open(file.data(), file.get_size()) || !view.check_indices())
+      {
+         std::cout << "Can't use " << path << " (" << view.get_error() << "), building a new one\n";
+         rebuild = true;
+      }
+      else
+         std::cout << "Using " << path << ", " << view.mesh_count() << " meshes, " << view.data_size() / 1e6 << " MB, --rebuild writes a new one\n";
+   }
+
+   // Start from code, the way the other samples do, and write the snapshot from the result
+   if (rebuild)
+   {
+      auto start = std::chrono::steady_clock::now();
+      SceneSource source = build_scene(megabytes << 20);
+      const double build_ms = ms_since(start);
+
+      start = std::chrono::steady_clock::now();
+      GpuScene scene;
+      scene.programs.push_back(link_program(lit_vertex_source, fragment_shader_source, binaries));
+      scene.programs.push_back(link_program(colored_vertex_source, fragment_shader_source, binaries));
+      glFinish();
+      const double programs_ms = ms_since(start);
+
+      start = std::chrono::steady_clock::now();
+      scene.buffer = upload(source.data.data(), source.data.size());
+      const double upload_ms = ms_since(start);
+
+      start = std::chrono::steady_clock::now();
+      create_draws(scene, source.layouts.data(), source.materials.data(), source.meshes.data(), source.meshes.size());
+      const double draws_ms = ms_since(start);
+
+      std::cout << "From code: " << source.meshes.size() << " meshes, " << source.data.size() / 1e6 << " MB\n   " << build_ms
+                << " ms building, " << programs_ms << " ms programs, " << upload_ms << " ms upload, " << draws_ms << " ms VAOs, "
+                << build_ms + programs_ms + upload_ms + draws_ms << " ms total\n";
+
+      start = std::chrono::steady_clock::now();
+      if (!write_snapshot(path, source, scene.programs, binaries))
+         throw_ex("Failed to write the snapshot!");
+      std::cout << "Wrote " << path << " in " << ms_since(start) << " ms" << (binaries ? ", with program binaries\n" : "\n");
+      scene.destroy();
+   }
+
+   // Cold start reads the file from disk, the warm one from the page cache like any later launch
+   GpuScene scene;
+   std::cout << "Cold start from the snapshot:\n";
+   if (!MappedFile::drop_from_cache(path))
+      std::cout << "   Can't drop the file from the page cache here, this start is warm too\n";
+   if (!load_snapshot(path, binaries, scene))
+      throw_ex("Failed to load the snapshot!");
+   scene.destroy();
+
+   std::cout << "Warm start from the snapshot:\n";
+   if (!load_snapshot(path, binaries, scene))
+      throw_ex("Failed to load the snapshot!");
+
+   double stats_time = glfwGetTime();
+   int frames = 0;
+
+   // Create the render loop
+   while (!glfwWindowShouldClose(window))
+   {
+      // Check if the window should close
+      if (glfwGetKey(window, GLFW_KEY_ESCAPE) == GLFW_PRESS)
+         glfwSetWindowShouldClose(window, true);
+
+      // Render
+      glClearColor(.5f, .5f, .5f, 1.f);
+      glClear(GL_COLOR_BUFFER_BIT);
+      scene.render();
+
+      // Swap buffers and check and call events
+      glfwSwapBuffers(window);
+      glfwPollEvents();
+
+      // Print the frame time once a second
+      ++frames;
+      const double now = glfwGetTime();
+      if (now - stats_time >= 1.0)
+      {
+         std::cout << scene.draws.size() << " draws, " << (now - stats_time) * 1000.0 / frames << " ms/frame\n";
+         stats_time = now;
+         frames = 0;
+      }
+   }
+
+   // Clean up
+   scene.destroy();
+   glfwTerminate();
+   return 0;
+}
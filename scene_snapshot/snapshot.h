@@ -0,0 +1,483 @@
+#pragma once
+#include <glad/glad.h>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <initializer_list>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+#if defined(_WIN32)
+#  ifndef NOMINMAX
+#    define NOMINMAX
+#  endif
+#  include <windows.h>
+#else
+#  include <fcntl.h>
+#  include <sys/mman.h>
+#  include <sys/stat.h>
+#  include <unistd.h>
+#endif
+
+// Prepared scene in one file that is mapped and used where it lies
+// Nothing in the file is a pointer. Records hold byte ranges relative to the start of their section, so the
+// file can be mapped at any address and read straight from the mapping, and the data section is laid out
+// exactly as the GPU buffer it becomes, so mesh offsets in the file are the offsets for the draws.
+// Opening a snapshot only checks that every range and record index stays inside the file, which costs the
+// same for 1 KB and 1 GB, so loading is the copy of the data section into the buffer and nothing else.
+// Whether the vertex indices stay inside their meshes is a separate pass over the data, done once per file.
+//
+// File layout: SnapshotHeader, the data section, then the meta section with the tables, shader sources
+// and program binaries. Fixed size fields, native byte order, which the header records and checks.
+
+constexpr char snapshot_magic[8] { 'G', 'L', 'S', 'N', 'A', 'P', '0', '1' };
+constexpr uint32_t snapshot_version = 1;
+constexpr uint32_t snapshot_byte_order = 0x01020304;
+
+// Blobs in the data section start on this boundary
+constexpr uint64_t snapshot_data_alignment = 256;
+
+// Bytes from the start of a section
+struct SnapshotRange
+{
+   uint64_t offset;
+   uint64_t size;
+};
+
+struct SnapshotHeader
+{
+   char magic[8];
+   uint32_t version;
+   uint32_t byte_order;
+   uint64_t file_size;
+   // Sections, from the start of the file
+   SnapshotRange data;
+   SnapshotRange meta;
+   // Tables in the meta section
+   SnapshotRange layouts;
+   SnapshotRange materials;
+   SnapshotRange programs;
+   SnapshotRange meshes;
+};
+
+// One vertex attribute, type is the GL enum of the component type
+struct SnapshotAttribute
+{
+   uint32_t location;
+   uint32_t components;
+   uint32_t type;
+   uint32_t normalized;
+   uint32_t offset;
+};
+
+constexpr uint32_t snapshot_max_attributes = 4;
+
+struct SnapshotLayout
+{
+   uint32_t stride;
+   uint32_t attribute_count;
+   SnapshotAttribute attributes[snapshot_max_attributes];
+};
+
+struct SnapshotMaterial
+{
+   float color[4];
+   uint32_t program;
+   uint32_t padding[3];
+};
+
+// Sources always, with their terminators, and the binary if the driver that wrote the file could give one
+struct SnapshotProgram
+{
+   SnapshotRange vertex_source;
+   SnapshotRange fragment_source;
+   SnapshotRange binary;
+   uint32_t binary_format;
+   uint32_t padding;
+};
+
+// Vertices and 32-bit indices in the data section, placed at placement.xy scaled by placement.z
+struct SnapshotMesh
+{
+   uint64_t vertex_offset;
+   uint64_t index_offset;
+   uint32_t vertex_count;
+   uint32_t index_count;
+   uint32_t layout;
+   uint32_t material;
+   float placement[4];
+};
+
+static_assert(sizeof(SnapshotHeader) == 120 && sizeof(SnapshotLayout) == 88 && sizeof(SnapshotMaterial) == 32
+   && sizeof(SnapshotProgram) == 56 && sizeof(SnapshotMesh) == 48, "records are written as they are in memory");
+static_assert(std::is_trivially_copyable<SnapshotHeader>::value && std::is_trivially_copyable<SnapshotMesh>::value,
+   "records are read in place");
+
+// Read-only mapping of a whole file
+class MappedFile
+{
+public:
+   MappedFile() = default;
+
+   MappedFile(const MappedFile&) = delete;
+   MappedFile& operator=(const MappedFile&) = delete;
+
+   ~MappedFile() { close(); }
+
+   bool open(const char* path)
+   {
+      close();
+#if defined(_WIN32)
+      file = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+      if (file == INVALID_HANDLE_VALUE)
+         return false;
+
+      LARGE_INTEGER file_size {};
+      GetFileSizeEx(file, &file_size);
+      size = size_t(file_size.QuadPart);
+      mapping = size ? CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr) : nullptr;
+      bytes = mapping ? static_cast<const unsigned char*>(MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0)) : nullptr;
+#else
+      descriptor = ::open(path, O_RDONLY);
+      if (descriptor < 0)
+         return false;
+
+      struct stat status {};
+      fstat(descriptor, &status);
+      size = size_t(status.st_size);
+      void* address = size ? mmap(nullptr, size, PROT_READ, MAP_PRIVATE, descriptor, 0) : MAP_FAILED;
+      bytes = address == MAP_FAILED ? nullptr : static_cast<const unsigned char*>(address);
+
+      // The data section is read front to back once, so read ahead aggressively
+      if (bytes)
+         madvise(const_cast<unsigned char*>(bytes), size, MADV_SEQUENTIAL);
+#endif
+      if (!bytes)
+         close();
+      return bytes != nullptr;
+   }
+
+   void close()
+   {
+#if defined(_WIN32)
+      if (bytes)
+         UnmapViewOfFile(bytes);
+      if (mapping)
+         CloseHandle(mapping);
+      if (file != INVALID_HANDLE_VALUE)
+         CloseHandle(file);
+      mapping = nullptr;
+      file = INVALID_HANDLE_VALUE;
+#else
+      if (bytes)
+         munmap(const_cast<unsigned char*>(bytes), size);
+      if (descriptor >= 0)
+         ::close(descriptor);
+      descriptor = -1;
+#endif
+      bytes = nullptr;
+      size = 0;
+   }
+
+   const unsigned char* data() const { return bytes; }
+   size_t get_size() const { return size; }
+
+   // Share of the file's pages already in the page cache, negative if the system can't tell
+   double resident_fraction() const
+   {
+#if defined(_WIN32)
+      return -1.0;
+#else
+      if (!bytes)
+         return -1.0;
+
+      const size_t page = size_t(sysconf(_SC_PAGESIZE));
+      std::vector<unsigned char> pages((size + page - 1) / page);
+      if (mincore(const_cast<unsigned char*>(bytes), size, pages.data()) != 0)
+         return -1.0;
+
+      size_t resident = 0;
+      for (unsigned char flags : pages)
+         resident += flags & 1;
+      return double(resident) / pages.size();
+#endif
+   }
+
+   // Drop a file from the page cache so the next open reads it from disk, false where that isn't possible
+   static bool drop_from_cache(const char* path)
+   {
+#if defined(_WIN32)
+      (void)path;
+      return false;
+#else
+      const int fd = ::open(path, O_RDONLY);
+      if (fd < 0)
+         return false;
+
+      // Only clean pages can be dropped
+      fdatasync(fd);
+      const bool dropped = posix_fadvise(fd, 0, 0, POSIX_FADV_DONTNEED) == 0;
+      ::close(fd);
+      return dropped;
+#endif
+   }
+
+private:
+   const unsigned char* bytes = nullptr;
+   size_t size = 0;
+#if defined(_WIN32)
+   HANDLE file = INVALID_HANDLE_VALUE;
+   HANDLE mapping = nullptr;
+#else
+   int descriptor = -1;
+#endif
+};
+
+// Checked view of a mapped snapshot, every accessor points into the mapping
+class SnapshotView
+{
+public:
+   // Returns false and sets the error if the bytes aren't a snapshot this code can read
+   bool open(const unsigned char* file, size_t file_size)
+   {
+      bytes = file;
+      size = file_size;
+      header = nullptr;
+
+      if (size < sizeof(SnapshotHeader))
+         return fail("file is smaller than the header");
+
+      const SnapshotHeader* candidate = reinterpret_cast<const SnapshotHeader*>(bytes);
+      if (std::memcmp(candidate->magic, snapshot_magic, sizeof(snapshot_magic)) != 0)
+         return fail("not a scene snapshot");
+      if (candidate->version != snapshot_version)
+         return fail("written by another version");
+      if (candidate->byte_order != snapshot_byte_order)
+         return fail("written with another byte order");
+      if (candidate->file_size != size)
+         return fail("truncated");
+      if (!inside(candidate->data, size) || !inside(candidate->meta, size) || candidate->data.offset % snapshot_data_alignment
+         || candidate->meta.offset % 8)
+         return fail("section outside the file");
+
+      const SnapshotRange tables[] { candidate->layouts, candidate->materials, candidate->programs, candidate->meshes };
+      const size_t record_sizes[] { sizeof(SnapshotLayout), sizeof(SnapshotMaterial), sizeof(SnapshotProgram), sizeof(SnapshotMesh) };
+      for (int i = 0; i < 4; ++i)
+         if (!inside(tables[i], candidate->meta.size) || tables[i].size % record_sizes[i] || tables[i].offset % 8)
+            return fail("table outside the meta section");
+
+      header = candidate;
+
+      // Indices between records and ranges into the sections, so nothing read later on the CPU can point outside
+      // the file. The index values themselves are only checked by check_indices, which has to read all of them
+      for (size_t i = 0; i < layout_count(); ++i)
+      {
+         const SnapshotLayout& layout = layouts()[i];
+         if (layout.attribute_count > snapshot_max_attributes || layout.stride == 0)
+            return fail("bad vertex layout");
+         for (uint32_t a = 0; a < layout.attribute_count; ++a)
+         {
+            // The whole attribute has to fit in the vertex, or reads of the last vertex run past the mesh
+            const SnapshotAttribute& attribute = layout.attributes[a];
+            const uint64_t bytes = uint64_t(attribute.components) * component_size(attribute.type);
+            if (attribute.components - 1 > 3 || bytes == 0 || attribute.offset + bytes > layout.stride)
+               return fail("bad vertex attribute");
+         }
+      }
+
+      for (size_t i = 0; i < program_count(); ++i)
+      {
+         const SnapshotProgram& program = programs()[i];
+         if (!inside(program.vertex_source, header->meta.size) || !inside(program.fragment_source, header->meta.size)
+            || !inside(program.binary, header->meta.size))
+            return fail("program outside the meta section");
+
+         // Sources are handed to GL where they lie, so they have to end in their terminator
+         for (SnapshotRange source : { program.vertex_source, program.fragment_source })
+            if (source.size == 0 || meta(source)[source.size - 1] != '\0')
+               return fail("shader source without terminator");
+      }
+
+      for (size_t i = 0; i < material_count(); ++i)
+         if (materials()[i].program >= program_count())
+            return fail("material uses a missing program");
+
+      for (size_t i = 0; i < mesh_count(); ++i)
+      {
+         const SnapshotMesh& mesh = meshes()[i];
+         if (mesh.layout >= layout_count() || mesh.material >= material_count())
+            return fail("mesh uses a missing layout or material");
+
+         const uint64_t stride = layouts()[mesh.layout].stride;
+         if (!inside({ mesh.vertex_offset, stride * mesh.vertex_count }, header->data.size)
+            || !inside({ mesh.index_offset, uint64_t(mesh.index_count) * 4 }, header->data.size) || mesh.index_offset % 4)
+            return fail("mesh outside the data section");
+      }
+
+      error.clear();
+      return true;
+   }
+
+   // Every index has to name a vertex of its own mesh, or a draw reads past it on the GPU
+   // Unlike open this reads the whole index data, so it is done once for a file rather than on every load
+   bool check_indices()
+   {
+      for (size_t i = 0; i < mesh_count(); ++i)
+      {
+         const SnapshotMesh& mesh = meshes()[i];
+         const uint32_t* indices = reinterpret_cast<const uint32_t*>(data() + mesh.index_offset);
+         for (uint32_t index = 0; index < mesh.index_count; ++index)
+            if (indices[index] >= mesh.vertex_count)
+               return fail("index past the end of its mesh");
+      }
+      return true;
+   }
+
+   const std::string& get_error() const { return error; }
+   const SnapshotHeader& get_header() const { return *header; }
+
+   // The data section, ready to become one GPU buffer
+   const unsigned char* data() const { return bytes + header->data.offset; }
+   size_t data_size() const { return size_t(header->data.size); }
+
+   // Bytes of a range in the meta section
+   const char* meta(SnapshotRange range) const { return reinterpret_cast<const char*>(bytes + header->meta.offset + range.offset); }
+
+   const SnapshotLayout* layouts() const { return table<SnapshotLayout>(header->layouts); }
+   const SnapshotMaterial* materials() const { return table<SnapshotMaterial>(header->materials); }
+   const SnapshotProgram* programs() const { return table<SnapshotProgram>(header->programs); }
+   const SnapshotMesh* meshes() const { return table<SnapshotMesh>(header->meshes); }
+
+   size_t layout_count() const { return size_t(header->layouts.size / sizeof(SnapshotLayout)); }
+   size_t material_count() const { return size_t(header->materials.size / sizeof(SnapshotMaterial)); }
+   size_t program_count() const { return size_t(header->programs.size / sizeof(SnapshotProgram)); }
+   size_t mesh_count() const { return size_t(header->meshes.size / sizeof(SnapshotMesh)); }
+
+private:
+   // Bytes of one component of a vertex attribute type, 0 for anything that isn't one
+   static uint64_t component_size(uint32_t type)
+   {
+      switch (type)
+      {
+      case GL_BYTE: case GL_UNSIGNED_BYTE: return 1;
+      case GL_SHORT: case GL_UNSIGNED_SHORT: case GL_HALF_FLOAT: return 2;
+      case GL_INT: case GL_UNSIGNED_INT: case GL_FLOAT: case GL_FIXED: return 4;
+      case GL_DOUBLE: return 8;
+      default: return 0;
+      }
+   }
+
+   static bool inside(SnapshotRange range, uint64_t limit)
+   {
+      return range.offset <= limit && range.size <= limit - range.offset;
+   }
+
+   template <class Record>
+   const Record* table(SnapshotRange range) const
+   {
+      return reinterpret_cast<const Record*>(bytes + header->meta.offset + range.offset);
+   }
+
+   bool fail(const char* message)
+   {
+      error = message;
+      header = nullptr;
+      return false;
+   }
+
+   const unsigned char* bytes = nullptr;
+   size_t size = 0;
+   const SnapshotHeader* header = nullptr;
+   std::string error;
+};
+
+// Writes a snapshot, the data section is streamed to the file as it is added, the meta section is kept in
+// memory and written after it by finish()
+class SnapshotWriter
+{
+public:
+   explicit SnapshotWriter(const char* path) : file(std::fopen(path, "wb"))
+   {
+      // The header is written last, once the sections are known
+      const SnapshotHeader empty {};
+      ok = file && std::fwrite(&empty, sizeof(empty), 1, file) == 1;
+      data_start = sizeof(empty) + pad(sizeof(empty));
+   }
+
+   SnapshotWriter(const SnapshotWriter&) = delete;
+   SnapshotWriter& operator=(const SnapshotWriter&) = delete;
+
+   ~SnapshotWriter()
+   {
+      if (file)
+         std::fclose(file);
+   }
+
+   // Offset of the blob in the data section
+   uint64_t add_data(const void* blob, size_t bytes)
+   {
+      const uint64_t offset = data_size;
+      ok = ok && std::fwrite(blob, 1, bytes, file) == bytes;
+      data_size += bytes;
+      data_size += pad(data_start + data_size);
+      return offset;
+   }
+
+   SnapshotRange add_meta(const void* blob, size_t bytes)
+   {
+      while (meta.size() % 8)
+         meta.push_back(0);
+
+      const SnapshotRange range { meta.size(), bytes };
+      meta.insert(meta.end(), static_cast<const char*>(blob), static_cast<const char*>(blob) + bytes);
+      return range;
+   }
+
+   std::vector<SnapshotLayout> layouts;
+   std::vector<SnapshotMaterial> materials;
+   std::vector<SnapshotProgram> programs;
+   std::vector<SnapshotMesh> meshes;
+
+   // Writes the tables and the header, false if anything failed along the way
+   bool finish()
+   {
+      if (!ok)
+         return false;
+
+      SnapshotHeader header {};
+      std::memcpy(header.magic, snapshot_magic, sizeof(snapshot_magic));
+      header.version = snapshot_version;
+      header.byte_order = snapshot_byte_order;
+      header.layouts = add_meta(layouts.data(), layouts.size() * sizeof(SnapshotLayout));
+      header.materials = add_meta(materials.data(), materials.size() * sizeof(SnapshotMaterial));
+      header.programs = add_meta(programs.data(), programs.size() * sizeof(SnapshotProgram));
+      header.meshes = add_meta(meshes.data(), meshes.size() * sizeof(SnapshotMesh));
+
+      header.data = { data_start, data_size };
+      header.meta = { data_start + data_size, meta.size() };
+      header.file_size = header.meta.offset + header.meta.size;
+
+      ok = std::fwrite(meta.data(), 1, meta.size(), file) == meta.size();
+      ok = ok && std::fseek(file, 0, SEEK_SET) == 0 && std::fwrite(&header, sizeof(header), 1, file) == 1;
+      ok = std::fclose(file) == 0 && ok;
+      file = nullptr;
+      return ok;
+   }
+
+private:
+   // Zeros up to the next alignment boundary, so every blob and the data section itself start on one
+   uint64_t pad(uint64_t position)
+   {
+      static const char zeros[snapshot_data_alignment] {};
+      const size_t padding = size_t((snapshot_data_alignment - position % snapshot_data_alignment) % snapshot_data_alignment);
+      ok = ok && std::fwrite(zeros, 1, padding, file) == padding;
+      return padding;
+   }
+
+   std::FILE* file;
+   bool ok;
+   uint64_t data_start = 0, data_size = 0;
+   std::vector<char> meta;
+};
@@ -0,0 +1,275 @@
+#include <glad/glad.h>
+#include <GLFW/glfw3.h>
+#include <cassert>
+#include <chrono>
+#include <iostream>
+#include <vector>
+#include "vmath.h"
+
+// Throw an exception and terminate GLFW
+void throw_ex(const char* msg)
+{
+   std::cout << msg << '\n';
+   glfwTerminate();
+   std::exit(-1);
+}
+
+// Resize callback function
+void framebuffer_size_callback(GLFWwindow*, int width, int height)
+{
+   assert(width > 0 && height > 0);
+   glViewport(0, 0, width, height);
+}
+
+// Compile a shader and print the info log if it fails
+unsigned compile_shader(GLenum type, const char* source)
+{
+   unsigned shader = glCreateShader(type);
+   glShaderSource(shader, 1, &source, nullptr);
+   glCompileShader(shader);
+
+   int success = 0;
+   char info_log[512] = "\0";
+   glGetShaderiv(shader, GL_COMPILE_STATUS, &success);
+
+   if (!success)
+   {
+      glGetShaderInfoLog(shader, sizeof(info_log), nullptr, info_log);
+      std::cout << "Failed to compile the shader: " << info_log;
+   }
+   return shader;
+}
+
+// Link a vertex and a fragment shader into a program and clean up the shaders
+unsigned link_program(const char* vertex_source, const char* fragment_source)
+{
+   unsigned vertex_shader = compile_shader(GL_VERTEX_SHADER, vertex_source);
+   unsigned fragment_shader = compile_shader(GL_FRAGMENT_SHADER, fragment_source);
+
+   unsigned program = glCreateProgram();
+   glAttachShader(program, vertex_shader);
+   glAttachShader(program, fragment_shader);
+   glLinkProgram(program);
+
+   int success = 0;
+   char info_log[512] = "\0";
+   glGetProgramiv(program, GL_LINK_STATUS, &success);
+
+   if (!success)
+   {
+      glGetProgramInfoLog(program, sizeof(info_log), nullptr, info_log);
+      std::cout << "Failed to link the shader program: " << info_log;
+   }
+
+   glDeleteShader(vertex_shader);
+   glDeleteShader(fragment_shader);
+   return program;
+}
+
+// Run fn a few times and return the fastest run in milliseconds
+template <typename Fn>
+double time_best_of(int runs, Fn fn)
+{
+   double best = 1e30;
+   for (int i = 0; i < runs; ++i)
+   {
+      const auto start = std::chrono::steady_clock::now();
+      fn();
+      const std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+      best = elapsed.count() < best ? elapsed.count() : best;
+   }
+   return best;
+}
+
+// Compare the SIMD paths of vmath against scalar code
+void run_benchmarks()
+{
+   using namespace vmath;
+
+   const std::size_t count = 1 << 20;
+   std::vector<float> x(count), y(count), z(count), out_x(count), out_y(count), out_z(count);
+   std::vector<vec3> points(count);
+   for (std::size_t i = 0; i < count; ++i)
+   {
+      x[i] = points[i].x = float(i % 1000) * .001f;
+      y[i] = points[i].y = float(i % 777) * .002f;
+      z[i] = points[i].z = float(i % 555) * .003f;
+   }
+
+   const mat4 m = translate({ 1.f, 2.f, 3.f }) * to_mat4(angle_axis(.5f, normalize({ 1.f, 1.f, 0.f })));
+   const points_soa in { x.data(), y.data(), z.data(), count };
+   const points_soa out { out_x.data(), out_y.data(), out_z.data(), count };
+
+   // One point at a time from an array of structures
+   const double aos_ms = time_best_of(10, [&]
+   {
+      for (std::size_t i = 0; i < count; ++i)
+      {
+         const vec4 p = m * vec4 { points[i].x, points[i].y, points[i].z, 1.f };
+         out_x[i] = p.x;
+         out_y[i] = p.y;
+         out_z[i] = p.z;
+      }
+   });
+   const double soa_scalar_ms = time_best_of(10, [&] { transform_points_scalar(m, in, out); });
+   const double soa_simd_ms = time_best_of(10, [&] { transform_points(m, in, out); });
+
+   // Matrix products
+   std::vector<mat4> matrices(4096, m);
+   float sink = 0.f;
+   const double mat_scalar_ms = time_best_of(10, [&]
+   {
+      mat4 r = identity4();
+      for (const mat4& a : matrices)
+         r = a * r;
+      sink += r.c[3].x;
+   });
+   const double mat_simd_ms = time_best_of(10, [&]
+   {
+      mat4 r = identity4();
+      for (const mat4& a : matrices)
+         r = mul(a, r);
+      sink += r.c[3].x;
+   });
+
+#if VMATH_AVX
+   const char* isa = "AVX";
+#elif VMATH_SSE
+   const char* isa = "SSE";
+#elif VMATH_NEON
+   const char* isa = "NEON";
+#else
+   const char* isa = "scalar";
+#endif
+
+   std::cout << "vmath benchmarks (" << isa << ", best of 10)\n"
+             << "   transform " << count << " points, AoS scalar: " << aos_ms << " ms\n"
+             << "   transform " << count << " points, SoA scalar: " << soa_scalar_ms << " ms\n"
+             << "   transform " << count << " points, SoA SIMD:   " << soa_simd_ms << " ms\n"
+             << "   " << matrices.size() << " mat4 products, scalar: " << mat_scalar_ms << " ms\n"
+             << "   " << matrices.size() << " mat4 products, SIMD:   " << mat_simd_ms << " ms\n"
+             << "   (checksum " << sink + out_x[count / 2] << ")\n";
+}
+
+// Pentagon vertices and indices built at compile time
+constexpr auto pentagon_vertices = vmath::regular_polygon<5>(0.5f);
+constexpr auto pentagon_indices = vmath::fan_indices<5>();
+static_assert(pentagon_vertices[0].y > 0.49f && pentagon_vertices[0].y < 0.51f, "Top vertex should be at the radius");
+static_assert(pentagon_indices.size() == 9, "A pentagon is three triangles");
+
+// Main function
+int main()
+{
+   run_benchmarks();
+
+   // Vertex shader
+   const char* vertex_shader_source =
+      "#version 330 core\n"
+      "layout (location = 0) in vec3 aPos;\n"
+      "uniform mat4 model;\n"
+      "void main()\n"
+      "{\n"
+      "   gl_Position = model * vec4(aPos, 1.0);\n"
+      "}\0";
+
+   // Fragment shader
+   const char* fragment_shader_source =
+      "#version 330 core\n"
+      "out vec4 FragColor;\n"
+      "void main()\n"
+      "{\n"
+      "   FragColor = vec4(1.0f, 0.5f, 0.f, 1.0f);\n"
+      "}\0";
+
+   // Initialize GLFW and tell it the version and profile
+   glfwInit();
+   glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
+   glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
+   glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+
+   // Initialize the window
+   GLFWwindow* window = glfwCreateWindow(800, 600, "SIMD math.", nullptr, nullptr);
+   if (!window)
+      throw_ex("Failed to create the window!");
+
+   // Set the current window
+   glfwMakeContextCurrent(window);
+
+   // Initialize GLAD
+   if (!gladLoadGLLoader(GLADloadproc(glfwGetProcAddress)))
+      throw_ex("Failed to initialize GLAD!");
+
+   // Set the viewport
+   glViewport(0, 0, 800, 600);
+
+   // Set window resize callback
+   glfwSetFramebufferSizeCallback(window, framebuffer_size_callback);
+
+   // Create the shader program
+   unsigned shader_program = link_program(vertex_shader_source, fragment_shader_source);
+   const int model_location = glGetUniformLocation(shader_program, "model");
+
+   // Create the buffer objects
+   unsigned EBO = 0;
+   glGenBuffers(1, &EBO);
+
+   unsigned VBO = 0;
+   glGenBuffers(1, &VBO);
+
+   unsigned VAO = 0;
+   glGenVertexArrays(1, &VAO);
+
+   // Initialize the VAO
+   glBindVertexArray(VAO);
+
+   // Copy the compile-time vertices and indices in buffers
+   glBindBuffer(GL_ARRAY_BUFFER, VBO);
+   glBufferData(GL_ARRAY_BUFFER, sizeof(pentagon_vertices), pentagon_vertices.data(), GL_STATIC_DRAW);
+
+   glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, EBO);
+   glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(pentagon_indices), pentagon_indices.data(), GL_STATIC_DRAW);
+
+   // Link vertex attributes
+   glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(vmath::vec3), (void*)0);
+   glEnableVertexAttribArray(0);
+
+   // Unbind VAO
+   glBindBuffer(GL_ARRAY_BUFFER, 0);
+   glBindVertexArray(0);
+
+   // Create the render loop
+   while (!glfwWindowShouldClose(window))
+   {
+      // Check if the window should close
+      if (glfwGetKey(window, GLFW_KEY_ESCAPE) == GLFW_PRESS)
+         glfwSetWindowShouldClose(window, true);
+
+      // Spin the pentagon around the Z axis with a quaternion
+      const vmath::quat spin = vmath::angle_axis(float(glfwGetTime()), { 0.f, 0.f, 1.f });
+      const vmath::mat4 model = vmath::to_mat4(spin);
+
+      // Render
+      glClearColor(.5f, .5f, .5f, 1.f);
+      glClear(GL_COLOR_BUFFER_BIT);
+
+      // Use the shader program and bind VAO
+      glUseProgram(shader_program);
+      glUniformMatrix4fv(model_location, 1, GL_FALSE, model.data());
+      glBindVertexArray(VAO);
+
+      // Draw the pentagon
+      glDrawElements(GL_TRIANGLES, GLsizei(pentagon_indices.size()), GL_UNSIGNED_INT, 0);
+
+      // Swap buffers and check and call events
+      glfwSwapBuffers(window);
+      glfwPollEvents();
+   }
+
+   // Clean up
+   glDeleteVertexArrays(1, &VAO);
+   glDeleteBuffers(1, &VBO);
+   glDeleteBuffers(1, &EBO);
+   glDeleteProgram(shader_program);
+   glfwTerminate();
+   return 0;
+}
@@ -0,0 +1,403 @@
+#pragma once
+#include <array>
+#include <cmath>
+#include <cstddef>
+
+// Header-only math library
+// vec2/3/4, mat3/4 and quat are plain structs with constexpr operators, so geometry can be built at
+// compile time. The runtime functions below (mul, transform_points) use SSE/AVX/NEON when the compiler
+// targets them and fall back to scalar code otherwise. Define VMATH_FORCE_SCALAR to disable intrinsics.
+
+#if !defined(VMATH_FORCE_SCALAR)
+#  if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#    define VMATH_SSE 1
+#    include <immintrin.h>
+#    if defined(__AVX__)
+#      define VMATH_AVX 1
+#    endif
+#  elif defined(__ARM_NEON)
+#    define VMATH_NEON 1
+#    include <arm_neon.h>
+#  endif
+#endif
+
+#if VMATH_SSE || VMATH_NEON
+#  define VMATH_SIMD 1
+#endif
+
+namespace vmath
+{
+   constexpr float pi = 3.14159265358979f;
+
+   // Compile-time sine and cosine, std::sin and std::cos are not constexpr
+   constexpr float sin_cx(float x)
+   {
+      // Reduce to [-pi, pi]
+      while (x > pi)
+         x -= 2.f * pi;
+      while (x < -pi)
+         x += 2.f * pi;
+
+      // Taylor series, the terms shrink fast enough on [-pi, pi]
+      float term = x;
+      float sum = x;
+      for (int i = 1; i < 12; ++i)
+      {
+         term *= -x * x / float((2 * i) * (2 * i + 1));
+         sum += term;
+      }
+      return sum;
+   }
+
+   constexpr float cos_cx(float x)
+   {
+      return sin_cx(x + pi * .5f);
+   }
+
+   // Vectors
+   struct vec2
+   {
+      float x, y;
+   };
+
+   struct vec3
+   {
+      float x, y, z;
+   };
+
+   struct vec4
+   {
+      float x, y, z, w;
+   };
+
+   constexpr vec2 operator+(vec2 a, vec2 b) { return { a.x + b.x, a.y + b.y }; }
+   constexpr vec2 operator-(vec2 a, vec2 b) { return { a.x - b.x, a.y - b.y }; }
+   constexpr vec2 operator*(vec2 a, float s) { return { a.x * s, a.y * s }; }
+   constexpr vec2 operator*(vec2 a, vec2 b) { return { a.x * b.x, a.y * b.y }; }
+   constexpr float dot(vec2 a, vec2 b) { return a.x * b.x + a.y * b.y; }
+
+   constexpr vec3 operator+(vec3 a, vec3 b) { return { a.x + b.x, a.y + b.y, a.z + b.z }; }
+   constexpr vec3 operator-(vec3 a, vec3 b) { return { a.x - b.x, a.y - b.y, a.z - b.z }; }
+   constexpr vec3 operator-(vec3 a) { return { -a.x, -a.y, -a.z }; }
+   constexpr vec3 operator*(vec3 a, float s) { return { a.x * s, a.y * s, a.z * s }; }
+   constexpr vec3 operator*(vec3 a, vec3 b) { return { a.x * b.x, a.y * b.y, a.z * b.z }; }
+   constexpr float dot(vec3 a, vec3 b) { return a.x * b.x + a.y * b.y + a.z * b.z; }
+   constexpr vec3 cross(vec3 a, vec3 b) { return { a.y * b.z - a.z * b.y, a.z * b.x - a.x * b.z, a.x * b.y - a.y * b.x }; }
+
+   constexpr vec4 operator+(vec4 a, vec4 b) { return { a.x + b.x, a.y + b.y, a.z + b.z, a.w + b.w }; }
+   constexpr vec4 operator-(vec4 a, vec4 b) { return { a.x - b.x, a.y - b.y, a.z - b.z, a.w - b.w }; }
+   constexpr vec4 operator*(vec4 a, float s) { return { a.x * s, a.y * s, a.z * s, a.w * s }; }
+   constexpr vec4 operator*(vec4 a, vec4 b) { return { a.x * b.x, a.y * b.y, a.z * b.z, a.w * b.w }; }
+   constexpr float dot(vec4 a, vec4 b) { return a.x * b.x + a.y * b.y + a.z * b.z + a.w * b.w; }
+
+   inline float length(vec2 a) { return std::sqrt(dot(a, a)); }
+   inline float length(vec3 a) { return std::sqrt(dot(a, a)); }
+   inline float length(vec4 a) { return std::sqrt(dot(a, a)); }
+   inline vec3 normalize(vec3 a) { return a * (1.f / length(a)); }
+
+   // Column-major matrices, data() can be passed straight to glUniformMatrix
+   struct mat3
+   {
+      vec3 c[3];
+
+      const float* data() const { return &c[0].x; }
+   };
+
+   struct mat4
+   {
+      vec4 c[4];
+
+      const float* data() const { return &c[0].x; }
+   };
+
+   constexpr mat3 identity3()
+   {
+      return { { { 1.f, 0.f, 0.f }, { 0.f, 1.f, 0.f }, { 0.f, 0.f, 1.f } } };
+   }
+
+   constexpr mat4 identity4()
+   {
+      return { { { 1.f, 0.f, 0.f, 0.f }, { 0.f, 1.f, 0.f, 0.f }, { 0.f, 0.f, 1.f, 0.f }, { 0.f, 0.f, 0.f, 1.f } } };
+   }
+
+   constexpr vec3 operator*(const mat3& m, vec3 v)
+   {
+      return m.c[0] * v.x + m.c[1] * v.y + m.c[2] * v.z;
+   }
+
+   constexpr mat3 operator*(const mat3& a, const mat3& b)
+   {
+      return { { a * b.c[0], a * b.c[1], a * b.c[2] } };
+   }
+
+   constexpr vec4 operator*(const mat4& m, vec4 v)
+   {
+      return m.c[0] * v.x + m.c[1] * v.y + m.c[2] * v.z + m.c[3] * v.w;
+   }
+
+   constexpr mat4 operator*(const mat4& a, const mat4& b)
+   {
+      return { { a * b.c[0], a * b.c[1], a * b.c[2], a * b.c[3] } };
+   }
+
+   constexpr mat4 translate(vec3 t)
+   {
+      mat4 m = identity4();
+      m.c[3] = { t.x, t.y, t.z, 1.f };
+      return m;
+   }
+
+   constexpr mat4 scale(vec3 s)
+   {
+      mat4 m = identity4();
+      m.c[0].x = s.x;
+      m.c[1].y = s.y;
+      m.c[2].z = s.z;
+      return m;
+   }
+
+   inline mat4 perspective(float fov_y, float aspect, float near_plane, float far_plane)
+   {
+      const float f = 1.f / std::tan(fov_y * .5f);
+      mat4 m {};
+      m.c[0].x = f / aspect;
+      m.c[1].y = f;
+      m.c[2].z = (far_plane + near_plane) / (near_plane - far_plane);
+      m.c[2].w = -1.f;
+      m.c[3].z = 2.f * far_plane * near_plane / (near_plane - far_plane);
+      return m;
+   }
+
+   // Quaternions, x/y/z is the vector part and w the scalar part
+   struct quat
+   {
+      float x, y, z, w;
+   };
+
+   constexpr quat identity_quat() { return { 0.f, 0.f, 0.f, 1.f }; }
+
+   constexpr quat operator*(quat a, quat b)
+   {
+      return {
+         a.w * b.x + a.x * b.w + a.y * b.z - a.z * b.y,
+         a.w * b.y - a.x * b.z + a.y * b.w + a.z * b.x,
+         a.w * b.z + a.x * b.y - a.y * b.x + a.z * b.w,
+         a.w * b.w - a.x * b.x - a.y * b.y - a.z * b.z
+      };
+   }
+
+   constexpr quat conjugate(quat q) { return { -q.x, -q.y, -q.z, q.w }; }
+
+   // Axis has to be normalized
+   constexpr quat angle_axis_cx(float angle, vec3 axis)
+   {
+      const float s = sin_cx(angle * .5f);
+      return { axis.x * s, axis.y * s, axis.z * s, cos_cx(angle * .5f) };
+   }
+
+   inline quat angle_axis(float angle, vec3 axis)
+   {
+      const float s = std::sin(angle * .5f);
+      return { axis.x * s, axis.y * s, axis.z * s, std::cos(angle * .5f) };
+   }
+
+   // Rotate a vector by a unit quaternion
+   constexpr vec3 rotate(quat q, vec3 v)
+   {
+      const vec3 u { q.x, q.y, q.z };
+      const vec3 t = cross(u, v) * 2.f;
+      return v + t * q.w + cross(u, t);
+   }
+
+   constexpr mat3 to_mat3(quat q)
+   {
+      const float xx = q.x * q.x, yy = q.y * q.y, zz = q.z * q.z;
+      const float xy = q.x * q.y, xz = q.x * q.z, yz = q.y * q.z;
+      const float wx = q.w * q.x, wy = q.w * q.y, wz = q.w * q.z;
+      return { {
+         { 1.f - 2.f * (yy + zz), 2.f * (xy + wz), 2.f * (xz - wy) },
+         { 2.f * (xy - wz), 1.f - 2.f * (xx + zz), 2.f * (yz + wx) },
+         { 2.f * (xz + wy), 2.f * (yz - wx), 1.f - 2.f * (xx + yy) }
+      } };
+   }
+
+   constexpr mat4 to_mat4(quat q)
+   {
+      const mat3 r = to_mat3(q);
+      return { {
+         { r.c[0].x, r.c[0].y, r.c[0].z, 0.f },
+         { r.c[1].x, r.c[1].y, r.c[1].z, 0.f },
+         { r.c[2].x, r.c[2].y, r.c[2].z, 0.f },
+         { 0.f, 0.f, 0.f, 1.f }
+      } };
+   }
+
+   // Regular polygon on the XY plane, first vertex points up, vertices go clockwise
+   template <std::size_t N>
+   constexpr std::array<vec3, N> regular_polygon(float radius)
+   {
+      std::array<vec3, N> vertices {};
+      for (std::size_t i = 0; i < N; ++i)
+      {
+         const float angle = pi * .5f - 2.f * pi * float(i) / float(N);
+         vertices[i] = { cos_cx(angle) * radius, sin_cx(angle) * radius, 0.f };
+      }
+      return vertices;
+   }
+
+   // Triangle fan indices around vertex 0 for a convex polygon
+   template <std::size_t N>
+   constexpr std::array<unsigned, (N - 2) * 3> fan_indices()
+   {
+      std::array<unsigned, (N - 2) * 3> indices {};
+      for (std::size_t i = 0; i < N - 2; ++i)
+      {
+         indices[i * 3 + 0] = 0;
+         indices[i * 3 + 1] = unsigned(i + 1);
+         indices[i * 3 + 2] = unsigned(i + 2);
+      }
+      return indices;
+   }
+
+   // Intrinsics wrappers
+   // f32x4 is four floats in a register, f32xw is the widest register the target has
+   namespace simd
+   {
+#if VMATH_SSE
+      using f32x4 = __m128;
+
+      inline f32x4 load(const float* p) { return _mm_loadu_ps(p); }
+      inline void store(float* p, f32x4 a) { _mm_storeu_ps(p, a); }
+      inline f32x4 splat(float s) { return _mm_set1_ps(s); }
+      inline f32x4 add(f32x4 a, f32x4 b) { return _mm_add_ps(a, b); }
+      inline f32x4 mul(f32x4 a, f32x4 b) { return _mm_mul_ps(a, b); }
+#  if defined(__FMA__)
+      inline f32x4 madd(f32x4 a, f32x4 b, f32x4 c) { return _mm_fmadd_ps(a, b, c); }
+#  else
+      inline f32x4 madd(f32x4 a, f32x4 b, f32x4 c) { return _mm_add_ps(_mm_mul_ps(a, b), c); }
+#  endif
+#elif VMATH_NEON
+      using f32x4 = float32x4_t;
+
+      inline f32x4 load(const float* p) { return vld1q_f32(p); }
+      inline void store(float* p, f32x4 a) { vst1q_f32(p, a); }
+      inline f32x4 splat(float s) { return vdupq_n_f32(s); }
+      inline f32x4 add(f32x4 a, f32x4 b) { return vaddq_f32(a, b); }
+      inline f32x4 mul(f32x4 a, f32x4 b) { return vmulq_f32(a, b); }
+#  if defined(__aarch64__)
+      inline f32x4 madd(f32x4 a, f32x4 b, f32x4 c) { return vfmaq_f32(c, a, b); }
+#  else
+      inline f32x4 madd(f32x4 a, f32x4 b, f32x4 c) { return vmlaq_f32(c, a, b); }
+#  endif
+#else
+      struct f32x4
+      {
+         float v[4];
+      };
+
+      inline f32x4 load(const float* p) { return { { p[0], p[1], p[2], p[3] } }; }
+      inline void store(float* p, f32x4 a) { for (int i = 0; i < 4; ++i) p[i] = a.v[i]; }
+      inline f32x4 splat(float s) { return { { s, s, s, s } }; }
+      inline f32x4 add(f32x4 a, f32x4 b) { for (int i = 0; i < 4; ++i) a.v[i] += b.v[i]; return a; }
+      inline f32x4 mul(f32x4 a, f32x4 b) { for (int i = 0; i < 4; ++i) a.v[i] *= b.v[i]; return a; }
+      inline f32x4 madd(f32x4 a, f32x4 b, f32x4 c) { for (int i = 0; i < 4; ++i) c.v[i] += a.v[i] * b.v[i]; return c; }
+#endif
+
+#if VMATH_AVX
+      using f32xw = __m256;
+      constexpr std::size_t width = 8;
+
+      inline f32xw load_w(const float* p) { return _mm256_loadu_ps(p); }
+      inline void store_w(float* p, f32xw a) { _mm256_storeu_ps(p, a); }
+      inline f32xw splat_w(float s) { return _mm256_set1_ps(s); }
+#  if defined(__FMA__)
+      inline f32xw madd_w(f32xw a, f32xw b, f32xw c) { return _mm256_fmadd_ps(a, b, c); }
+#  else
+      inline f32xw madd_w(f32xw a, f32xw b, f32xw c) { return _mm256_add_ps(_mm256_mul_ps(a, b), c); }
+#  endif
+#else
+      using f32xw = f32x4;
+      constexpr std::size_t width = 4;
+
+      inline f32xw load_w(const float* p) { return load(p); }
+      inline void store_w(float* p, f32xw a) { store(p, a); }
+      inline f32xw splat_w(float s) { return splat(s); }
+      inline f32xw madd_w(f32xw a, f32xw b, f32xw c) { return madd(a, b, c); }
+#endif
+   }
+
+   // Runtime matrix products, same results as operator* but one column per register
+   inline vec4 mul(const mat4& m, vec4 v)
+   {
+#if !VMATH_SIMD
+      return m * v;
+#else
+      using namespace simd;
+      f32x4 r = mul(load(&m.c[0].x), splat(v.x));
+      r = madd(load(&m.c[1].x), splat(v.y), r);
+      r = madd(load(&m.c[2].x), splat(v.z), r);
+      r = madd(load(&m.c[3].x), splat(v.w), r);
+
+      vec4 out;
+      store(&out.x, r);
+      return out;
+#endif
+   }
+
+   inline mat4 mul(const mat4& a, const mat4& b)
+   {
+      return { { mul(a, b.c[0]), mul(a, b.c[1]), mul(a, b.c[2]), mul(a, b.c[3]) } };
+   }
+
+   // Points in structure-of-arrays form, one array per component
+   struct points_soa
+   {
+      float* x;
+      float* y;
+      float* z;
+      std::size_t count;
+   };
+
+   // Transform points as positions (w = 1) in plain scalar code
+   inline void transform_points_scalar(const mat4& m, const points_soa& in, const points_soa& out)
+   {
+      for (std::size_t i = 0; i < in.count; ++i)
+      {
+         const vec4 p = m * vec4 { in.x[i], in.y[i], in.z[i], 1.f };
+         out.x[i] = p.x;
+         out.y[i] = p.y;
+         out.z[i] = p.z;
+      }
+   }
+
+   // Transform points as positions (w = 1), width points at a time
+   // in and out may be the same arrays
+   inline void transform_points(const mat4& m, const points_soa& in, const points_soa& out)
+   {
+#if !VMATH_SIMD
+      transform_points_scalar(m, in, out);
+#else
+      using namespace simd;
+      const f32xw m00 = splat_w(m.c[0].x), m01 = splat_w(m.c[1].x), m02 = splat_w(m.c[2].x), m03 = splat_w(m.c[3].x);
+      const f32xw m10 = splat_w(m.c[0].y), m11 = splat_w(m.c[1].y), m12 = splat_w(m.c[2].y), m13 = splat_w(m.c[3].y);
+      const f32xw m20 = splat_w(m.c[0].z), m21 = splat_w(m.c[1].z), m22 = splat_w(m.c[2].z), m23 = splat_w(m.c[3].z);
+
+      std::size_t i = 0;
+      for (; i + width <= in.count; i += width)
+      {
+         const f32xw x = load_w(in.x + i);
+         const f32xw y = load_w(in.y + i);
+         const f32xw z = load_w(in.z + i);
+
+         store_w(out.x + i, madd_w(m00, x, madd_w(m01, y, madd_w(m02, z, m03))));
+         store_w(out.y + i, madd_w(m10, x, madd_w(m11, y, madd_w(m12, z, m13))));
+         store_w(out.z + i, madd_w(m20, x, madd_w(m21, y, madd_w(m22, z, m23))));
+      }
+
+      // Leftover points
+      const points_soa tail_in { in.x + i, in.y + i, in.z + i, in.count - i };
+      const points_soa tail_out { out.x + i, out.y + i, out.z + i, in.count - i };
+      transform_points_scalar(m, tail_in, tail_out);
+#endif
+   }
+}
@@ -0,0 +1,503 @@
+#include <glad/glad.h>
+#include <GLFW/glfw3.h>
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <future>
+#include <iostream>
+#include <map>
+#include <string>
+#include <vector>
+#include "startup_timeline.h"
+
+// Throw an exception and terminate GLFW
+void throw_ex(const char* msg)
+{
+   std::cout << msg << '\n';
+   glfwTerminate();
+   std::exit(-1);
+}
+
+// Resize callback function
+void framebuffer_size_callback(GLFWwindow*, int width, int height)
+{
+   assert(width > 0 && height > 0);
+   glViewport(0, 0, width, height);
+}
+
+// Compile a shader and print the info log if it fails
+unsigned compile_shader(GLenum type, const char* source)
+{
+   unsigned shader = glCreateShader(type);
+   glShaderSource(shader, 1, &source, nullptr);
+   glCompileShader(shader);
+
+   int success = 0;
+   char info_log[512] = "\0";
+   glGetShaderiv(shader, GL_COMPILE_STATUS, &success);
+
+   if (!success)
+   {
+      glGetShaderInfoLog(shader, sizeof(info_log), nullptr, info_log);
+      std::cout << "Failed to compile the shader: " << info_log;
+   }
+   return shader;
+}
+
+// Link a vertex and a fragment shader into a program and clean up the shaders
+unsigned link_program(const char* vertex_source, const char* fragment_source)
+{
+   unsigned vertex_shader = compile_shader(GL_VERTEX_SHADER, vertex_source);
+   unsigned fragment_shader = compile_shader(GL_FRAGMENT_SHADER, fragment_source);
+
+   unsigned program = glCreateProgram();
+   glAttachShader(program, vertex_shader);
+   glAttachShader(program, fragment_shader);
+   glLinkProgram(program);
+
+   int success = 0;
+   char info_log[512] = "\0";
+   glGetProgramiv(program, GL_LINK_STATUS, &success);
+
+   if (!success)
+   {
+      glGetProgramInfoLog(program, sizeof(info_log), nullptr, info_log);
+      std::cout << "Failed to link the shader program: " << info_log;
+   }
+
+   glDeleteShader(vertex_shader);
+   glDeleteShader(fragment_shader);
+   return program;
+}
+
+// Shader sources with #include "name" lines, expanded by preprocess
+const std::map<std::string, std::string> shader_library {
+   { "terrain.vert",
+      "layout (location = 0) in vec3 aPos;\n"
+      "layout (location = 1) in vec3 aNormal;\n"
+      "layout (location = 2) in vec2 aTexCoord;\n"
+      "out vec3 Normal;\n"
+      "out vec2 TexCoord;\n"
+      "out float Depth;\n"
+      "void main()\n"
+      "{\n"
+      "   Normal = aNormal;\n"
+      "   TexCoord = aTexCoord;\n"
+      "   Depth = aPos.z * 0.5 + 0.5;\n"
+      "   // Fixed oblique view, far rows higher up the screen\n"
+      "   gl_Position = vec4(aPos.x * 0.9, aPos.z * 0.55 + aPos.y * 0.6 - 0.1, Depth, 1.0);\n"
+      "}\n" },
+   { "terrain.frag",
+      "#include \"lighting.glsl\"\n"
+      "#include \"fog.glsl\"\n"
+      "in vec3 Normal;\n"
+      "in vec2 TexCoord;\n"
+      "in float Depth;\n"
+      "uniform sampler2D albedo;\n"
+      "out vec4 FragColor;\n"
+      "void main()\n"
+      "{\n"
+      "   vec3 color = texture(albedo, TexCoord).rgb;\n"
+      "#ifdef DETAIL\n"
+      "   color *= 0.8 + 0.4 * texture(albedo, TexCoord * 17.0).r;\n"
+      "#endif\n"
+      "   color = light(color, normalize(Normal));\n"
+      "#ifdef FOG\n"
+      "   color = fog(color, Depth);\n"
+      "#endif\n"
+      "   FragColor = vec4(color, 1.0);\n"
+      "}\n" },
+   { "lighting.glsl",
+      "vec3 light(vec3 color, vec3 normal)\n"
+      "{\n"
+      "   return color * (0.25 + 0.75 * max(dot(normal, normalize(vec3(0.3, 1.0, -0.5))), 0.0));\n"
+      "}\n" },
+   { "fog.glsl",
+      "vec3 fog(vec3 color, float depth)\n"
+      "{\n"
+      "   return mix(color, vec3(0.6, 0.65, 0.7), smoothstep(0.4, 1.0, depth));\n"
+      "}\n" },
+};
+
+// Expand the includes of a library source, with a version line and defines in front
+std::string preprocess(const std::string& name, const std::vector<std::string>& defines)
+{
+   std::string source = "#version 330 core\n";
+   for (const std::string& define : defines)
+      source += "#define " + define + '\n';
+
+   std::string body = shader_library.at(name);
+   for (size_t include = body.find("#include \""); include != std::string::npos; include = body.find("#include \""))
+   {
+      const size_t begin = include + 10, end = body.find('"', begin);
+      const size_t line_end = body.find('\n', end);
+      body.replace(include, line_end - include + 1, shader_library.at(body.substr(begin, end - begin)));
+   }
+   return source + body;
+}
+
+// Every combination of the optional features, a real engine would know its variants ahead like this
+struct ShaderVariant
+{
+   std::string vertex, fragment;
+};
+
+std::vector<ShaderVariant> preprocess_shaders()
+{
+   std::vector<ShaderVariant> variants;
+   for (int features = 0; features < 4; ++features)
+   {
+      std::vector<std::string> defines;
+      if (features & 1)
+         defines.push_back("FOG");
+      if (features & 2)
+         defines.push_back("DETAIL");
+      variants.push_back({ preprocess("terrain.vert", defines), preprocess("terrain.frag", defines) });
+   }
+   return variants;
+}
+
+// Smooth value noise summed over octaves, the shared source of the terrain and its texture
+float lattice(int x, int y, uint32_t seed)
+{
+   uint32_t h = uint32_t(x) * 374761393u + uint32_t(y) * 668265263u + seed * 2246822519u;
+   h = (h ^ (h >> 13)) * 1274126177u;
+   return float(h ^ (h >> 16)) / 4294967295.f;
+}
+
+float value_noise(float x, float y, uint32_t seed)
+{
+   const int x0 = int(std::floor(x)), y0 = int(std::floor(y));
+   const float fx = x - x0, fy = y - y0;
+   const float sx = fx * fx * (3.f - 2.f * fx), sy = fy * fy * (3.f - 2.f * fy);
+   const float top = lattice(x0, y0, seed) + (lattice(x0 + 1, y0, seed) - lattice(x0, y0, seed)) * sx;
+   const float bottom = lattice(x0, y0 + 1, seed) + (lattice(x0 + 1, y0 + 1, seed) - lattice(x0, y0 + 1, seed)) * sx;
+   return top + (bottom - top) * sy;
+}
+
+float fbm(float x, float y, int octaves, uint32_t seed)
+{
+   float sum = 0.f, amplitude = .5f;
+   for (int octave = 0; octave < octaves; ++octave)
+   {
+      sum += value_noise(x, y, seed + octave) * amplitude;
+      x *= 2.f;
+      y *= 2.f;
+      amplitude *= .5f;
+   }
+   return sum;
+}
+
+// Terrain grid with position, normal and texture coordinate per vertex, normals averaged from the faces
+struct Mesh
+{
+   std::vector<float> vertices;
+   std::vector<unsigned> indices;
+};
+
+Mesh process_mesh(int size)
+{
+   Mesh mesh;
+   std::vector<float> heights(size_t(size) * size);
+   for (int z = 0; z < size; ++z)
+      for (int x = 0; x < size; ++x)
+         heights[size_t(z) * size + x] = fbm(x * 8.f / size, z * 8.f / size, 6, 7) * .8f - .4f;
+
+   std::vector<float> normals(heights.size() * 3, 0.f);
+   for (int z = 0; z + 1 < size; ++z)
+      for (int x = 0; x + 1 < size; ++x)
+      {
+         const unsigned corner = unsigned(z * size + x);
+         const unsigned quad[6] { corner, corner + size, corner + 1, corner + 1, corner + size, corner + size + 1 };
+         mesh.indices.insert(mesh.indices.end(), quad, quad + 6);
+
+         for (int triangle = 0; triangle < 2; ++triangle)
+         {
+            float p[3][3];
+            for (int v = 0; v < 3; ++v)
+            {
+               const unsigned index = quad[triangle * 3 + v];
+               p[v][0] = float(index % size) * 2.f / (size - 1);
+               p[v][1] = heights[index];
+               p[v][2] = float(index / size) * 2.f / (size - 1);
+            }
+            const float a[3] { p[1][0] - p[0][0], p[1][1] - p[0][1], p[1][2] - p[0][2] };
+            const float b[3] { p[2][0] - p[0][0], p[2][1] - p[0][1], p[2][2] - p[0][2] };
+            const float n[3] { a[1] * b[2] - a[2] * b[1], a[2] * b[0] - a[0] * b[2], a[0] * b[1] - a[1] * b[0] };
+            for (int v = 0; v < 3; ++v)
+               for (int c = 0; c < 3; ++c)
+                  normals[size_t(quad[triangle * 3 + v]) * 3 + c] += n[c];
+         }
+      }
+
+   mesh.vertices.reserve(heights.size() * 8);
+   for (size_t i = 0; i < heights.size(); ++i)
+   {
+      const float* n = &normals[i * 3];
+      const float length = std::max(std::sqrt(n[0] * n[0] + n[1] * n[1] + n[2] * n[2]), 1e-12f);
+      const float u = float(i % size) / (size - 1), v = float(i / size) / (size - 1);
+      const float vertex[8] { u * 2.f - 1.f, heights[i], v * 2.f - 1.f, n[0] / length, n[1] / length, n[2] / length, u, v };
+      mesh.vertices.insert(mesh.vertices.end(), vertex, vertex + 8);
+   }
+   return mesh;
+}
+
+// RGBA albedo from the same noise, grass to rock
+std::vector<unsigned char> make_texture(int size)
+{
+   std::vector<unsigned char> pixels(size_t(size) * size * 4);
+   for (int y = 0; y < size; ++y)
+      for (int x = 0; x < size; ++x)
+      {
+         const float n = fbm(x * 32.f / size, y * 32.f / size, 5, 11);
+         unsigned char* pixel = &pixels[(size_t(y) * size + x) * 4];
+         pixel[0] = (unsigned char)(255 * (.25f + .45f * n));
+         pixel[1] = (unsigned char)(255 * (.45f + .25f * n));
+         pixel[2] = (unsigned char)(255 * (.2f + .3f * n));
+         pixel[3] = 255;
+      }
+   return pixels;
+}
+
+// Main function
+// Usage: startup_profiler [--sequential]
+int main(int argc, char** argv)
+{
+   // Everything is timed from here
+   StartupTimeline timeline;
+   const bool sequential = argc > 1 && std::strcmp(argv[1], "--sequential") == 0;
+   const std::string mode = sequential ? "sequential" : "parallel";
+
+   const int mesh_size = 512, texture_size = 1024;
+   StartupHistory history("startup_history.txt");
+
+   // CPU-only work, started on workers before anything else in parallel mode, run in place when first needed otherwise
+   std::future<void> history_ready;
+   std::future<std::vector<ShaderVariant>> shaders_ready;
+   std::future<Mesh> mesh_ready;
+   std::future<std::vector<unsigned char>> texture_ready;
+   if (!sequential)
+   {
+      history_ready = std::async(std::launch::async, [&]
+      {
+         auto stage = timeline.stage("read history");
+         history.load();
+      });
+      shaders_ready = std::async(std::launch::async, [&]
+      {
+         auto stage = timeline.stage("preprocess shaders");
+         return preprocess_shaders();
+      });
+      mesh_ready = std::async(std::launch::async, [&]
+      {
+         auto stage = timeline.stage("process mesh");
+         return process_mesh(mesh_size);
+      });
+      texture_ready = std::async(std::launch::async, [&]
+      {
+         auto stage = timeline.stage("generate texture");
+         return make_texture(texture_size);
+      });
+   }
+
+   // Initialize GLFW and tell it the version and profile
+   {
+      auto stage = timeline.stage("glfwInit");
+      glfwInit();
+      glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
+      glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
+      glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+   }
+
+   // Initialize the window
+   GLFWwindow* window = nullptr;
+   {
+      auto stage = timeline.stage("create window");
+      window = glfwCreateWindow(800, 600, "Startup profiler.", nullptr, nullptr);
+      if (!window)
+         throw_ex("Failed to create the window!");
+
+      // Set the current window
+      glfwMakeContextCurrent(window);
+   }
+
+   // Initialize GLAD
+   {
+      auto stage = timeline.stage("load GL functions");
+      if (!gladLoadGLLoader(GLADloadproc(glfwGetProcAddress)))
+         throw_ex("Failed to initialize GLAD!");
+   }
+
+   // Set the viewport
+   glViewport(0, 0, 800, 600);
+
+   // Set window resize callback
+   glfwSetFramebufferSizeCallback(window, framebuffer_size_callback);
+
+   // Compile every variant, the last one has all the features and is the one drawn
+   std::vector<unsigned> programs;
+   {
+      std::vector<ShaderVariant> variants;
+      if (sequential)
+      {
+         auto stage = timeline.stage("preprocess shaders");
+         variants = preprocess_shaders();
+      }
+      else
+      {
+         auto stage = timeline.wait("preprocess shaders");
+         variants = shaders_ready.get();
+      }
+
+      auto stage = timeline.stage("compile shaders");
+      for (const ShaderVariant& variant : variants)
+         programs.push_back(link_program(variant.vertex.c_str(), variant.fragment.c_str()));
+   }
+   const unsigned shader_program = programs.back();
+
+   // Upload the terrain
+   unsigned VAO = 0, VBO = 0, EBO = 0;
+   GLsizei index_count = 0;
+   {
+      Mesh mesh;
+      if (sequential)
+      {
+         auto stage = timeline.stage("process mesh");
+         mesh = process_mesh(mesh_size);
+      }
+      else
+      {
+         auto stage = timeline.wait("process mesh");
+         mesh = mesh_ready.get();
+      }
+
+      auto stage = timeline.stage("upload mesh");
+      glGenVertexArrays(1, &VAO);
+      glGenBuffers(1, &VBO);
+      glGenBuffers(1, &EBO);
+
+      glBindVertexArray(VAO);
+      glBindBuffer(GL_ARRAY_BUFFER, VBO);
+      glBufferData(GL_ARRAY_BUFFER, mesh.vertices.size() * sizeof(float), mesh.vertices.data(), GL_STATIC_DRAW);
+      glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, EBO);
+      glBufferData(GL_ELEMENT_ARRAY_BUFFER, mesh.indices.size() * sizeof(unsigned), mesh.indices.data(), GL_STATIC_DRAW);
+
+      glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void*)0);
+      glEnableVertexAttribArray(0);
+      glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void*)(3 * sizeof(float)));
+      glEnableVertexAttribArray(1);
+      glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void*)(6 * sizeof(float)));
+      glEnableVertexAttribArray(2);
+      glBindVertexArray(0);
+      index_count = GLsizei(mesh.indices.size());
+   }
+
+   // Upload the texture
+   unsigned texture = 0;
+   {
+      std::vector<unsigned char> pixels;
+      if (sequential)
+      {
+         auto stage = timeline.stage("generate texture");
+         pixels = make_texture(texture_size);
+      }
+      else
+      {
+         auto stage = timeline.wait("generate texture");
+         pixels = texture_ready.get();
+      }
+
+      auto stage = timeline.stage("upload texture");
+      glGenTextures(1, &texture);
+      glBindTexture(GL_TEXTURE_2D, texture);
+      glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, texture_size, texture_size, 0, GL_RGBA, GL_UNSIGNED_BYTE, pixels.data());
+      glGenerateMipmap(GL_TEXTURE_2D);
+      glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+      glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+      glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
+      glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
+   }
+
+   glEnable(GL_DEPTH_TEST);
+   auto render = [&]
+   {
+      glClearColor(.5f, .5f, .5f, 1.f);
+      glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+      glUseProgram(shader_program);
+      glBindTexture(GL_TEXTURE_2D, texture);
+      glBindVertexArray(VAO);
+      glDrawElements(GL_TRIANGLES, index_count, GL_UNSIGNED_INT, (void*)0);
+      glBindVertexArray(0);
+   };
+
+   // The first frame counts once it has actually been drawn
+   {
+      auto stage = timeline.stage("first frame");
+      render();
+      glfwSwapBuffers(window);
+      glFinish();
+   }
+   const double first_frame_ms = timeline.now_ms();
+
+   // The history is only needed to judge the result, so it's waited for after the first frame
+   if (sequential)
+   {
+      auto stage = timeline.stage("read history");
+      history.load();
+   }
+   else
+   {
+      auto stage = timeline.wait("read history");
+      history_ready.get();
+   }
+
+   std::cout << "Startup (" << mode << "), " << first_frame_ms << " ms to the first frame\n";
+   timeline.print(std::cout, first_frame_ms);
+
+   const double baseline = history.baseline(mode);
+   if (history.is_regression(mode, first_frame_ms))
+      std::cout << "   REGRESSION: the median of the last " << mode << " runs was " << baseline << " ms\n";
+   else if (baseline > 0.0)
+      std::cout << "   Median of the last " << mode << " runs: " << baseline << " ms\n";
+   history.append(mode, first_frame_ms);
+
+   double stats_time = glfwGetTime();
+   int frames = 0;
+
+   // Create the render loop
+   while (!glfwWindowShouldClose(window))
+   {
+      // Check if the window should close
+      if (glfwGetKey(window, GLFW_KEY_ESCAPE) == GLFW_PRESS)
+         glfwSetWindowShouldClose(window, true);
+
+      // Render
+      render();
+
+      // Swap buffers and check and call events
+      glfwSwapBuffers(window);
+      glfwPollEvents();
+
+      // Print the frame time once a second
+      ++frames;
+      const double now = glfwGetTime();
+      if (now - stats_time >= 1.0)
+      {
+         std::cout << (now - stats_time) * 1000.0 / frames << " ms/frame\n";
+         stats_time = now;
+         frames = 0;
+      }
+   }
+
+   // Clean up
+   glDeleteVertexArrays(1, &VAO);
+   glDeleteBuffers(1, &VBO);
+   glDeleteBuffers(1, &EBO);
+   glDeleteTextures(1, &texture);
+   for (unsigned program : programs)
+      glDeleteProgram(program);
+   glfwTerminate();
+   return 0;
+}
@@ -0,0 +1,238 @@
+#pragma once
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <fstream>
+#include <iomanip>
+#include <map>
+#include <mutex>
+#include <ostream>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Timeline of the stages of startup on every thread, and the critical path through them
+// Stages are recorded with a scope object from any thread. Waits on other threads' results are recorded as
+// stages too, naming the stage they wait for, so the critical path can be walked back from the first frame:
+// a wait that actually blocked hands the path over to the stage it waited for, and anything that finished
+// before it was needed is off the path and shows up as slack instead.
+
+class StartupTimeline
+{
+public:
+   using Clock = std::chrono::steady_clock;
+
+   struct Stage
+   {
+      std::string name;
+      std::string waits_for;
+      int thread;
+      double start_ms, end_ms;
+   };
+
+   // Records from its construction to its destruction
+   class Scope
+   {
+   public:
+      Scope(StartupTimeline& timeline, std::string name, std::string waits_for)
+         : timeline(timeline), name(std::move(name)), waits_for(std::move(waits_for)), start_ms(timeline.now_ms()) {}
+
+      Scope(const Scope&) = delete;
+      Scope& operator=(const Scope&) = delete;
+
+      ~Scope() { timeline.add(std::move(name), std::move(waits_for), start_ms, timeline.now_ms()); }
+
+   private:
+      StartupTimeline& timeline;
+      std::string name, waits_for;
+      double start_ms;
+   };
+
+   // The thread that makes the timeline is the main thread, thread 0
+   StartupTimeline() : origin(Clock::now()) { thread_index(); }
+
+   Scope stage(std::string name) { return Scope(*this, std::move(name), ""); }
+
+   // Blocking on the result of another stage
+   Scope wait(const std::string& stage_name) { return Scope(*this, "wait for " + stage_name, stage_name); }
+
+   double now_ms() const { return std::chrono::duration<double, std::milli>(Clock::now() - origin).count(); }
+
+   // Stages in start order
+   std::vector<Stage> get_stages() const
+   {
+      std::lock_guard<std::mutex> lock(mutex);
+      std::vector<Stage> sorted = stages;
+      std::sort(sorted.begin(), sorted.end(), [](const Stage& a, const Stage& b) { return a.start_ms < b.start_ms; });
+      return sorted;
+   }
+
+   // Walk back from a point on the main thread, usually the first frame, the path comes out in time order
+   std::vector<Stage> critical_path(double end_ms) const
+   {
+      const std::vector<Stage> all = get_stages();
+      std::vector<Stage> path;
+      int thread = 0;
+      double time = end_ms;
+
+      const double epsilon = .01;
+      for (;;)
+      {
+         const Stage* latest = nullptr;
+         for (const Stage& stage : all)
+            if (stage.thread == thread && stage.end_ms <= time + epsilon && stage.start_ms < time
+               && (!latest || stage.end_ms > latest->end_ms))
+               latest = &stage;
+
+         if (!latest)
+         {
+            // A worker's first stage starts when the main thread started the worker
+            if (thread == 0)
+               break;
+            thread = 0;
+            continue;
+         }
+
+         const Stage* awaited = nullptr;
+         if (!latest->waits_for.empty())
+            for (const Stage& stage : all)
+               if (stage.name == latest->waits_for)
+                  awaited = &stage;
+
+         if (awaited && awaited->end_ms > latest->start_ms + epsilon)
+         {
+            path.push_back(*awaited);
+            thread = awaited->thread;
+            time = awaited->start_ms;
+         }
+         else
+         {
+            if (latest->waits_for.empty())
+               path.push_back(*latest);
+            time = latest->start_ms;
+         }
+      }
+      std::reverse(path.begin(), path.end());
+      return path;
+   }
+
+   // Gantt chart of every stage, the critical path, and the slack of work that stayed off it
+   void print(std::ostream& out, double first_frame_ms) const
+   {
+      const std::vector<Stage> all = get_stages();
+      const int width = 50;
+      const double scale = width / std::max(first_frame_ms, 1.0);
+
+      out << std::fixed << std::setprecision(1);
+      for (const Stage& stage : all)
+      {
+         const int begin = std::min(width - 1, int(stage.start_ms * scale));
+         const int length = std::max(1, std::min(width - begin, int((stage.end_ms - stage.start_ms) * scale + .5)));
+         out << "   " << (stage.thread == 0 ? std::string("main    ") : "worker " + std::to_string(stage.thread))
+             << " |" << std::string(size_t(begin), ' ') << std::string(size_t(length), stage.waits_for.empty() ? '#' : '.')
+             << std::string(size_t(width - begin - length), ' ') << "| " << std::setw(7) << stage.start_ms << std::setw(8)
+             << stage.end_ms - stage.start_ms << " ms  " << stage.name << '\n';
+      }
+
+      const std::vector<Stage> path = critical_path(first_frame_ms);
+      double on_path = 0.0;
+      out << "   Critical path:";
+      for (size_t i = 0; i < path.size(); ++i)
+      {
+         on_path += path[i].end_ms - path[i].start_ms;
+         out << (i ? " -> " : " ") << path[i].name << " (" << path[i].end_ms - path[i].start_ms << ')';
+      }
+      out << "\n   " << on_path << " of " << first_frame_ms << " ms accounted for\n";
+
+      // Slack: how much later a worker stage could have finished before anything waited on it
+      for (const Stage& wait : all)
+         for (const Stage& stage : all)
+            if (!wait.waits_for.empty() && stage.name == wait.waits_for && stage.end_ms <= wait.start_ms)
+               out << "   " << stage.name << " finished " << wait.start_ms - stage.end_ms << " ms before it was needed\n";
+      out << std::defaultfloat << std::setprecision(6);
+   }
+
+private:
+   void add(std::string name, std::string waits_for, double start_ms, double end_ms)
+   {
+      const int thread = thread_index();
+      std::lock_guard<std::mutex> lock(mutex);
+      stages.push_back({ std::move(name), std::move(waits_for), thread, start_ms, end_ms });
+   }
+
+   // Small numbers in order of first use instead of the opaque thread ids
+   int thread_index()
+   {
+      std::lock_guard<std::mutex> lock(mutex);
+      auto it = threads.find(std::this_thread::get_id());
+      if (it != threads.end())
+         return it->second;
+      const int index = int(threads.size());
+      threads[std::this_thread::get_id()] = index;
+      return index;
+   }
+
+   Clock::time_point origin;
+   mutable std::mutex mutex;
+   std::vector<Stage> stages;
+   std::map<std::thread::id, int> threads;
+};
+
+// Time to first frame of earlier runs, one "<mode> <milliseconds>" line per run
+// A run counts as a regression when it is more than the tolerance slower than the median of the last runs
+// of the same mode, the median keeps one noisy run from moving the baseline
+class StartupHistory
+{
+public:
+   explicit StartupHistory(std::string path) : path(std::move(path)) {}
+
+   void load()
+   {
+      std::ifstream file(path);
+      std::string line;
+      while (std::getline(file, line))
+      {
+         std::istringstream fields(line);
+         Run run;
+         if (fields >> run.mode >> run.ms)
+            runs.push_back(run);
+      }
+   }
+
+   // Median of the last runs of the mode, negative without any
+   double baseline(const std::string& mode, size_t last_runs = 10) const
+   {
+      std::vector<double> times;
+      for (auto it = runs.rbegin(); it != runs.rend() && times.size() < last_runs; ++it)
+         if (it->mode == mode)
+            times.push_back(it->ms);
+      if (times.empty())
+         return -1.0;
+
+      std::sort(times.begin(), times.end());
+      return times[times.size() / 2];
+   }
+
+   bool is_regression(const std::string& mode, double ms, double tolerance = .1) const
+   {
+      const double median = baseline(mode);
+      return median > 0.0 && ms > median * (1.0 + tolerance);
+   }
+
+   void append(const std::string& mode, double ms)
+   {
+      runs.push_back({ mode, ms });
+      std::ofstream(path, std::ios::app) << mode << ' ' << ms << '\n';
+   }
+
+private:
+   struct Run
+   {
+      std::string mode;
+      double ms;
+   };
+
+   std::string path;
+   std::vector<Run> runs;
+};
@@ -0,0 +1,674 @@
+#include <glad/glad.h>
+#include <GLFW/glfw3.h>
+#include <algorithm>
+#include <atomic>
+#include <cassert>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <deque>
+#include <iostream>
+#include <random>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+// Throw an exception and terminate GLFW
+void throw_ex(const char* msg)
+{
+   std::cout << msg << '\n';
+   glfwTerminate();
+   std::exit(-1);
+}
+
+// Resize callback function
+void framebuffer_size_callback(GLFWwindow*, int width, int height)
+{
+   assert(width > 0 && height > 0);
+   glViewport(0, 0, width, height);
+}
+
+// Compile a shader and print the info log if it fails
+unsigned compile_shader(GLenum type, const char* source)
+{
+   unsigned shader = glCreateShader(type);
+   glShaderSource(shader, 1, &source, nullptr);
+   glCompileShader(shader);
+
+   int success = 0;
+   char info_log[512] = "\0";
+   glGetShaderiv(shader, GL_COMPILE_STATUS, &success);
+
+   if (!success)
+   {
+      glGetShaderInfoLog(shader, sizeof(info_log), nullptr, info_log);
+      std::cout << "Failed to compile the shader: " << info_log;
+   }
+   return shader;
+}
+
+// Link a vertex and a fragment shader into a program and clean up the shaders
+unsigned link_program(const char* vertex_source, const char* fragment_source)
+{
+   unsigned vertex_shader = compile_shader(GL_VERTEX_SHADER, vertex_source);
+   unsigned fragment_shader = compile_shader(GL_FRAGMENT_SHADER, fragment_source);
+
+   unsigned program = glCreateProgram();
+   glAttachShader(program, vertex_shader);
+   glAttachShader(program, fragment_shader);
+   glLinkProgram(program);
+
+   int success = 0;
+   char info_log[512] = "\0";
+   glGetProgramiv(program, GL_LINK_STATUS, &success);
+
+   if (!success)
+   {
+      glGetProgramInfoLog(program, sizeof(info_log), nullptr, info_log);
+      std::cout << "Failed to link the shader program: " << info_log;
+   }
+
+   glDeleteShader(vertex_shader);
+   glDeleteShader(fragment_shader);
+   return program;
+}
+
+// Run fn(begin, end) over [0, count) split between all cores
+template <typename Fn>
+void parallel_for(size_t count, Fn fn)
+{
+   const size_t thread_count = std::min<size_t>(std::max(1u, std::thread::hardware_concurrency()), (count + 63) / 64);
+   if (thread_count <= 1)
+   {
+      fn(size_t(0), count);
+      return;
+   }
+
+   std::vector<std::thread> threads;
+   const size_t per_thread = (count + thread_count - 1) / thread_count;
+   for (size_t begin = 0; begin < count; begin += per_thread)
+      threads.emplace_back(fn, begin, std::min(begin + per_thread, count));
+
+   for (std::thread& thread : threads)
+      thread.join();
+}
+
+struct Point
+{
+   float x, y;
+};
+
+// Polygon with an outer ring and any number of holes, rings are stored back to back
+// ring_start[r] is the first point of ring r, ring 0 is the outer ring
+struct Polygon
+{
+   std::vector<Point> points;
+   std::vector<unsigned> ring_start;
+   float color[3];
+};
+
+float cross(Point o, Point a, Point b)
+{
+   return (a.x - o.x) * (b.y - o.y) - (a.y - o.y) * (b.x - o.x);
+}
+
+// Twice the signed area, positive for counter-clockwise rings
+float signed_area(const Point* points, size_t count)
+{
+   float area = 0.f;
+   for (size_t i = 0, j = count - 1; i < count; j = i++)
+      area += (points[j].x - points[i].x) * (points[j].y + points[i].y);
+   return area;
+}
+
+bool point_in_triangle(Point p, Point a, Point b, Point c)
+{
+   return cross(a, b, p) >= 0.f && cross(b, c, p) >= 0.f && cross(c, a, p) >= 0.f;
+}
+
+// Ear clipping triangulation, holes are cut in by bridging them to the outer ring first
+// Expects the outer ring counter-clockwise and holes clockwise, indices refer to polygon.points
+void triangulate(const Polygon& polygon, std::vector<unsigned>& indices)
+{
+   const std::vector<Point>& points = polygon.points;
+   const size_t ring_count = polygon.ring_start.size();
+   auto ring_end = [&](size_t ring) { return ring + 1 < ring_count ? polygon.ring_start[ring + 1] : unsigned(points.size()); };
+
+   // Outer ring
+   std::vector<unsigned> ring;
+   for (unsigned i = polygon.ring_start[0]; i < ring_end(0); ++i)
+      ring.push_back(i);
+
+   // Holes from right to left, each joined to the outer ring through its rightmost point
+   std::vector<std::pair<unsigned, size_t>> holes;
+   for (size_t h = 1; h < ring_count; ++h)
+   {
+      unsigned rightmost = polygon.ring_start[h];
+      for (unsigned i = polygon.ring_start[h]; i < ring_end(h); ++i)
+         if (points[i].x > points[rightmost].x)
+            rightmost = i;
+      holes.push_back({ rightmost, h });
+   }
+   std::sort(holes.begin(), holes.end(), [&](const auto& a, const auto& b) { return points[a.first].x > points[b.first].x; });
+
+   for (const auto& hole : holes)
+   {
+      const Point m = points[hole.first];
+
+      // Closest edge hit by a ray from m to the right
+      float best_x = 1e30f;
+      size_t bridge = 0;
+      for (size_t i = 0; i < ring.size(); ++i)
+      {
+         const Point a = points[ring[i]], b = points[ring[(i + 1) % ring.size()]];
+         if ((a.y <= m.y) == (b.y <= m.y))
+            continue;
+
+         const float x = a.x + (m.y - a.y) * (b.x - a.x) / (b.y - a.y);
+         if (x >= m.x && x < best_x)
+         {
+            best_x = x;
+            bridge = points[ring[i]].x > points[ring[(i + 1) % ring.size()]].x ? i : (i + 1) % ring.size();
+         }
+      }
+
+      // A reflex vertex inside the triangle (m, hit, bridge) would block the bridge, take the one closest in angle
+      const Point hit { best_x, m.y };
+      Point p = points[ring[bridge]];
+      float best_tangent = 1e30f;
+      for (size_t i = 0; i < ring.size(); ++i)
+      {
+         const Point prev = points[ring[(i + ring.size() - 1) % ring.size()]], v = points[ring[i]];
+         const Point next = points[ring[(i + 1) % ring.size()]];
+         if (cross(prev, v, next) >= 0.f || v.x < m.x)
+            continue;
+
+         const bool inside = m.y < p.y ? point_in_triangle(v, m, hit, p) : point_in_triangle(v, m, p, hit);
+         const float tangent = std::fabs(v.y - m.y) / std::max(v.x - m.x, 1e-12f);
+         if (inside && tangent < best_tangent)
+         {
+            best_tangent = tangent;
+            bridge = i;
+         }
+      }
+      p = points[ring[bridge]];
+
+      // Splice: ... bridge, hole from m around back to m, bridge, ...
+      std::vector<unsigned> spliced(ring.begin(), ring.begin() + bridge + 1);
+      const unsigned hole_begin = polygon.ring_start[hole.second], hole_size = ring_end(hole.second) - hole_begin;
+      for (unsigned k = 0; k <= hole_size; ++k)
+         spliced.push_back(hole_begin + (hole.first - hole_begin + k) % hole_size);
+      spliced.push_back(ring[bridge]);
+      spliced.insert(spliced.end(), ring.begin() + bridge + 1, ring.end());
+      ring.swap(spliced);
+   }
+
+   // Clip ears until a triangle is left
+   std::vector<unsigned> prev(ring.size()), next(ring.size());
+   for (size_t i = 0; i < ring.size(); ++i)
+   {
+      prev[i] = unsigned((i + ring.size() - 1) % ring.size());
+      next[i] = unsigned((i + 1) % ring.size());
+   }
+
+   size_t remaining = ring.size();
+   unsigned current = 0, stalled = 0;
+   while (remaining > 3)
+   {
+      const unsigned a = prev[current], c = next[current];
+      const Point pa = points[ring[a]], pb = points[ring[current]], pc = points[ring[c]];
+
+      bool ear = cross(pa, pb, pc) > 0.f;
+      if (ear)
+      {
+         const float min_x = std::min({ pa.x, pb.x, pc.x }), max_x = std::max({ pa.x, pb.x, pc.x });
+         const float min_y = std::min({ pa.y, pb.y, pc.y }), max_y = std::max({ pa.y, pb.y, pc.y });
+
+         // No other vertex may sit inside the ear, only reflex ones can and duplicated bridge points don't count
+         for (unsigned v = next[c]; v != a; v = next[v])
+         {
+            const Point pv = points[ring[v]];
+            if (pv.x < min_x || pv.x > max_x || pv.y < min_y || pv.y > max_y)
+               continue;
+            if (ring[v] == ring[a] || ring[v] == ring[current] || ring[v] == ring[c])
+               continue;
+            if (cross(points[ring[prev[v]]], pv, points[ring[next[v]]]) > 0.f)
+               continue;
+            if (point_in_triangle(pv, pa, pb, pc))
+            {
+               ear = false;
+               break;
+            }
+         }
+      }
+
+      // Give up on a clean ear after a full lap, happens on degenerate input
+      if (ear || stalled > remaining)
+      {
+         indices.insert(indices.end(), { ring[a], ring[current], ring[c] });
+         next[a] = c;
+         prev[c] = a;
+         --remaining;
+         stalled = 0;
+         current = c;
+      }
+      else
+      {
+         ++stalled;
+         current = next[current];
+      }
+   }
+
+   indices.insert(indices.end(), { ring[prev[current]], ring[current], ring[next[current]] });
+}
+
+// Hash of a polygon's rings, FNV-1a over the raw point bits a word at a time
+std::uint64_t polygon_hash(const Polygon& polygon)
+{
+   std::uint64_t hash = 1469598103934665603ull;
+   auto mix = [&](const void* data, size_t words)
+   {
+      const unsigned char* p = static_cast<const unsigned char*>(data);
+      for (size_t i = 0; i < words; ++i)
+      {
+         std::uint32_t word;
+         std::memcpy(&word, p + i * sizeof(word), sizeof(word));
+         hash = (hash ^ word) * 1099511628211ull;
+      }
+   };
+
+   mix(polygon.ring_start.data(), polygon.ring_start.size());
+   mix(polygon.points.data(), polygon.points.size() * 2);
+   return hash;
+}
+
+// Triangulations by polygon hash
+// Entries keep the outline they were made from, so a hash collision is a miss and not somebody else's
+// triangles. Entries not used for a whole frame are dropped once the cache is over capacity
+class TessellationCache
+{
+public:
+   explicit TessellationCache(size_t capacity) : capacity(capacity) {}
+
+   const std::vector<unsigned>* find(std::uint64_t hash, const Polygon& polygon)
+   {
+      auto it = entries.find(hash);
+      if (it == entries.end() || !same_outline(it->second, polygon))
+         return nullptr;
+
+      it->second.last_used = frame;
+      return &it->second.indices;
+   }
+
+   const std::vector<unsigned>* insert(std::uint64_t hash, const Polygon& polygon, std::vector<unsigned>&& indices)
+   {
+      auto it = entries.find(hash);
+      if (it == entries.end())
+      {
+         Entry& entry = entries[hash];
+         entry = { polygon.points, polygon.ring_start, frame, std::move(indices) };
+         return &entry.indices;
+      }
+
+      // The same polygon twice in a batch shares the first triangulation
+      if (same_outline(it->second, polygon))
+         return &it->second.indices;
+
+      // A collision doesn't replace the entry, lookups this frame may still point at it, it just isn't cached
+      uncached.push_back(std::move(indices));
+      return &uncached.back();
+   }
+
+   // Call once per frame, after the frame's lookups are done with
+   void end_frame()
+   {
+      if (entries.size() > capacity)
+         for (auto it = entries.begin(); it != entries.end();)
+            it = it->second.last_used < frame ? entries.erase(it) : std::next(it);
+      uncached.clear();
+      ++frame;
+   }
+
+   size_t size() const { return entries.size(); }
+
+private:
+   struct Entry
+   {
+      std::vector<Point> points;
+      std::vector<unsigned> ring_start;
+      std::uint64_t last_used;
+      std::vector<unsigned> indices;
+   };
+
+   // Bitwise, like the hash
+   static bool same_outline(const Entry& entry, const Polygon& polygon)
+   {
+      return entry.points.size() == polygon.points.size() && entry.ring_start == polygon.ring_start
+         && (polygon.points.empty() || std::memcmp(entry.points.data(), polygon.points.data(), polygon.points.size() * sizeof(Point)) == 0);
+   }
+
+   std::unordered_map<std::uint64_t, Entry> entries;
+   std::deque<std::vector<unsigned>> uncached;
+   size_t capacity;
+   std::uint64_t frame = 0;
+};
+
+// Vertex layout
+struct Vertex
+{
+   float x, y;
+   float r, g, b;
+};
+
+// What one batch build did
+struct BatchStats
+{
+   size_t tessellated;
+   size_t cached;
+   size_t index_count;
+   double milliseconds;
+};
+
+// Tessellate every polygon that is not cached yet in parallel, then write all of them straight into the
+// mapped vertex and index buffers, also in parallel
+BatchStats build_batch(const std::vector<Polygon>& polygons, TessellationCache& cache,
+   unsigned VBO, unsigned EBO, size_t& vertex_capacity, size_t& index_capacity)
+{
+   const auto start = std::chrono::steady_clock::now();
+   const size_t count = polygons.size();
+
+   // Look everything up, remember the misses
+   std::vector<const std::vector<unsigned>*> triangulations(count);
+   std::vector<std::uint64_t> hashes(count);
+   std::vector<size_t> misses;
+   parallel_for(count, [&](size_t begin, size_t end)
+   {
+      for (size_t i = begin; i < end; ++i)
+         hashes[i] = polygon_hash(polygons[i]);
+   });
+   for (size_t i = 0; i < count; ++i)
+   {
+      triangulations[i] = cache.find(hashes[i], polygons[i]);
+      if (!triangulations[i])
+         misses.push_back(i);
+   }
+
+   // Tessellate the misses across all cores
+   std::vector<std::vector<unsigned>> fresh(misses.size());
+   parallel_for(misses.size(), [&](size_t begin, size_t end)
+   {
+      for (size_t i = begin; i < end; ++i)
+         triangulate(polygons[misses[i]], fresh[i]);
+   });
+
+   for (size_t i = 0; i < misses.size(); ++i)
+      triangulations[misses[i]] = cache.insert(hashes[misses[i]], polygons[misses[i]], std::move(fresh[i]));
+
+   // Where every polygon goes in the batch
+   std::vector<size_t> vertex_offset(count + 1, 0), index_offset(count + 1, 0);
+   for (size_t i = 0; i < count; ++i)
+   {
+      vertex_offset[i + 1] = vertex_offset[i] + polygons[i].points.size();
+      index_offset[i + 1] = index_offset[i] + triangulations[i]->size();
+   }
+
+   // Grow the buffers if needed, otherwise just orphan them through the map
+   glBindBuffer(GL_ARRAY_BUFFER, VBO);
+   glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, EBO);
+   if (vertex_offset[count] > vertex_capacity)
+   {
+      vertex_capacity = vertex_offset[count];
+      glBufferData(GL_ARRAY_BUFFER, vertex_capacity * sizeof(Vertex), nullptr, GL_STREAM_DRAW);
+   }
+   if (index_offset[count] > index_capacity)
+   {
+      index_capacity = index_offset[count];
+      glBufferData(GL_ELEMENT_ARRAY_BUFFER, index_capacity * sizeof(unsigned), nullptr, GL_STREAM_DRAW);
+   }
+
+   Vertex* vertices = static_cast<Vertex*>(glMapBufferRange(GL_ARRAY_BUFFER, 0, vertex_offset[count] * sizeof(Vertex),
+      GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT));
+   unsigned* indices = static_cast<unsigned*>(glMapBufferRange(GL_ELEMENT_ARRAY_BUFFER, 0, index_offset[count] * sizeof(unsigned),
+      GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT));
+
+   if (vertices && indices)
+      parallel_for(count, [&](size_t begin, size_t end)
+      {
+         for (size_t i = begin; i < end; ++i)
+         {
+            const Polygon& polygon = polygons[i];
+            Vertex* out_vertex = vertices + vertex_offset[i];
+            for (const Point& point : polygon.points)
+               *out_vertex++ = { point.x, point.y, polygon.color[0], polygon.color[1], polygon.color[2] };
+
+            unsigned* out_index = indices + index_offset[i];
+            for (unsigned index : *triangulations[i])
+               *out_index++ = unsigned(vertex_offset[i]) + index;
+         }
+      });
+
+   if (vertices)
+      glUnmapBuffer(GL_ARRAY_BUFFER);
+   if (indices)
+      glUnmapBuffer(GL_ELEMENT_ARRAY_BUFFER);
+   glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+   cache.end_frame();
+
+   const std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+   return { misses.size(), count - misses.size(), index_offset[count], elapsed.count() };
+}
+
+// Concave star with a square-ish hole, outer ring counter-clockwise and hole clockwise
+Polygon make_shape(std::mt19937& random, float center_x, float center_y, float size)
+{
+   std::uniform_int_distribution<int> point_count(16, 64);
+   std::uniform_real_distribution<float> jitter(.6f, 1.f), color(.2f, 1.f);
+
+   Polygon polygon;
+   polygon.color[0] = color(random);
+   polygon.color[1] = color(random);
+   polygon.color[2] = color(random);
+
+   const int outer = point_count(random);
+   polygon.ring_start.push_back(0);
+   for (int i = 0; i < outer; ++i)
+   {
+      const float angle = 6.2831853f * i / outer, radius = size * (i % 2 ? jitter(random) : 1.f);
+      polygon.points.push_back({ center_x + std::cos(angle) * radius, center_y + std::sin(angle) * radius });
+   }
+
+   // Every other shape gets a hole
+   if (random() % 2)
+   {
+      polygon.ring_start.push_back(unsigned(polygon.points.size()));
+      for (int i = 0; i < 6; ++i)
+      {
+         const float angle = -6.2831853f * i / 6, radius = size * .25f;
+         polygon.points.push_back({ center_x + std::cos(angle) * radius, center_y + std::sin(angle) * radius });
+      }
+   }
+   return polygon;
+}
+
+// Rotate a shape around its first ring's centroid, which changes its hash
+void rotate_shape(Polygon& polygon, float angle)
+{
+   float cx = 0.f, cy = 0.f;
+   const unsigned outer_end = polygon.ring_start.size() > 1 ? polygon.ring_start[1] : unsigned(polygon.points.size());
+   for (unsigned i = 0; i < outer_end; ++i)
+   {
+      cx += polygon.points[i].x / outer_end;
+      cy += polygon.points[i].y / outer_end;
+   }
+
+   const float c = std::cos(angle), s = std::sin(angle);
+   for (Point& point : polygon.points)
+   {
+      const float x = point.x - cx, y = point.y - cy;
+      point = { cx + x * c - y * s, cy + x * s + y * c };
+   }
+}
+
+// Main function
+int main()
+{
+   // Vertex shader
+   const char* vertex_shader_source =
+      "#version 330 core\n"
+      "layout (location = 0) in vec2 aPos;\n"
+      "layout (location = 1) in vec3 aColor;\n"
+      "out vec3 Color;\n"
+      "void main()\n"
+      "{\n"
+      "   Color = aColor;\n"
+      "   gl_Position = vec4(aPos, 0.0, 1.0);\n"
+      "}\0";
+
+   // Fragment shader
+   const char* fragment_shader_source =
+      "#version 330 core\n"
+      "in vec3 Color;\n"
+      "out vec4 FragColor;\n"
+      "void main()\n"
+      "{\n"
+      "   FragColor = vec4(Color, 1.0f);\n"
+      "}\0";
+
+   // Initialize GLFW and tell it the version and profile
+   glfwInit();
+   glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
+   glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
+   glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+
+   // Initialize the window
+   GLFWwindow* window = glfwCreateWindow(800, 600, "Tessellation.", nullptr, nullptr);
+   if (!window)
+      throw_ex("Failed to create the window!");
+
+   // Set the current window
+   glfwMakeContextCurrent(window);
+
+   // Initialize GLAD
+   if (!gladLoadGLLoader(GLADloadproc(glfwGetProcAddress)))
+      throw_ex("Failed to initialize GLAD!");
+
+   // Set the viewport
+   glViewport(0, 0, 800, 600);
+
+   // Set window resize callback
+   glfwSetFramebufferSizeCallback(window, framebuffer_size_callback);
+
+   // Create the shader program
+   unsigned shader_program = link_program(vertex_shader_source, fragment_shader_source);
+
+   // A grid of concave shapes, some with holes
+   std::mt19937 random(1234);
+   std::vector<Polygon> polygons;
+   const int grid = 150;
+   for (int row = 0; row < grid; ++row)
+      for (int column = 0; column < grid; ++column)
+         polygons.push_back(make_shape(random, -1.f + (column + .5f) * 2.f / grid, -1.f + (row + .5f) * 2.f / grid, .9f / grid));
+
+   // Make sure the rings wind the way triangulate expects
+   for (Polygon& polygon : polygons)
+      for (size_t ring = 0; ring < polygon.ring_start.size(); ++ring)
+      {
+         Point* first = polygon.points.data() + polygon.ring_start[ring];
+         Point* last = ring + 1 < polygon.ring_start.size() ? polygon.points.data() + polygon.ring_start[ring + 1]
+                                                            : polygon.points.data() + polygon.points.size();
+         const bool counter_clockwise = signed_area(first, last - first) > 0.f;
+         if (counter_clockwise != (ring == 0))
+            std::reverse(first, last);
+      }
+
+   // Create the buffer objects
+   unsigned EBO = 0;
+   glGenBuffers(1, &EBO);
+
+   unsigned VBO = 0;
+   glGenBuffers(1, &VBO);
+
+   unsigned VAO = 0;
+   glGenVertexArrays(1, &VAO);
+
+   // Initialize the VAO
+   glBindVertexArray(VAO);
+   glBindBuffer(GL_ARRAY_BUFFER, VBO);
+   glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, EBO);
+
+   // Link vertex attributes
+   glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)0);
+   glEnableVertexAttribArray(0);
+   glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)(2 * sizeof(float)));
+   glEnableVertexAttribArray(1);
+
+   // Tessellate everything once with a cold cache
+   TessellationCache cache(polygons.size() * 2);
+   size_t vertex_capacity = 0, index_capacity = 0;
+   BatchStats batch = build_batch(polygons, cache, VBO, EBO, vertex_capacity, index_capacity);
+   std::cout << "Cold: " << batch.tessellated << " polygons in " << batch.milliseconds << " ms ("
+             << batch.tessellated / batch.milliseconds * 1000.0 << " polygons/s)\n";
+
+   // Unbind VAO
+   glBindVertexArray(0);
+
+   // Every frame a few shapes turn, only those are tessellated again
+   const size_t changes_per_frame = 200;
+   double stats_time = glfwGetTime(), batch_ms = 0.0;
+   size_t tessellated = 0, cached = 0;
+   int frames = 0;
+
+   // Create the render loop
+   while (!glfwWindowShouldClose(window))
+   {
+      // Check if the window should close
+      if (glfwGetKey(window, GLFW_KEY_ESCAPE) == GLFW_PRESS)
+         glfwSetWindowShouldClose(window, true);
+
+      for (size_t i = 0; i < changes_per_frame; ++i)
+         rotate_shape(polygons[random() % polygons.size()], .05f);
+
+      glBindVertexArray(VAO);
+      batch = build_batch(polygons, cache, VBO, EBO, vertex_capacity, index_capacity);
+      tessellated += batch.tessellated;
+      cached += batch.cached;
+      batch_ms += batch.milliseconds;
+
+      // Render
+      glClearColor(.5f, .5f, .5f, 1.f);
+      glClear(GL_COLOR_BUFFER_BIT);
+
+      // Draw every shape in one call
+      glUseProgram(shader_program);
+      glDrawElements(GL_TRIANGLES, GLsizei(batch.index_count), GL_UNSIGNED_INT, 0);
+      glBindVertexArray(0);
+
+      // Print the throughput once a second
+      ++frames;
+      const double now = glfwGetTime();
+      if (now - stats_time >= 1.0)
+      {
+         std::cout << (tessellated + cached) / (batch_ms / 1000.0) << " polygons/s through the batch, "
+                   << tessellated / frames << " tessellated and " << cached / frames << " cached per frame, "
+                   << batch_ms / frames << " ms/frame, " << cache.size() << " cache entries\n";
+         stats_time = now;
+         batch_ms = 0.0;
+         tessellated = cached = 0;
+         frames = 0;
+      }
+
+      // Swap buffers and check and call events
+      glfwSwapBuffers(window);
+      glfwPollEvents();
+   }
+
+   // Clean up
+   glDeleteVertexArrays(1, &VAO);
+   glDeleteBuffers(1, &VBO);
+   glDeleteBuffers(1, &EBO);
+   glDeleteProgram(shader_program);
+   glfwTerminate();
+   return 0;
+}
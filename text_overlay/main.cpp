@@ -0,0 +1,395 @@
+#include <glad/glad.h>
+#include <GLFW/glfw3.h>
+#include <algorithm>
+#include <cassert>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+#include "text_renderer.h"
+
+// Not in every GLAD build, the values are fixed by the extension specs
+#ifndef GL_GPU_MEMORY_INFO_TOTAL_AVAILABLE_MEMORY_NVX
+#  define GL_GPU_MEMORY_INFO_TOTAL_AVAILABLE_MEMORY_NVX 0x9048
+#  define GL_GPU_MEMORY_INFO_CURRENT_AVAILABLE_VIDMEM_NVX 0x9049
+#endif
+#ifndef GL_TEXTURE_FREE_MEMORY_ATI
+#  define GL_TEXTURE_FREE_MEMORY_ATI 0x87FC
+#endif
+
+// Throw an exception and terminate GLFW
+void throw_ex(const char* msg)
+{
+   std::cout << msg << '\n';
+   glfwTerminate();
+   std::exit(-1);
+}
+
+// Resize callback function
+void framebuffer_size_callback(GLFWwindow*, int width, int height)
+{
+   assert(width > 0 && height > 0);
+   glViewport(0, 0, width, height);
+}
+
+// Compile a shader and print the info log if it fails
+unsigned compile_shader(GLenum type, const char* source)
+{
+   unsigned shader = glCreateShader(type);
+   glShaderSource(shader, 1, &source, nullptr);
+   glCompileShader(shader);
+
+   int success = 0;
+   char info_log[512] = "\0";
+   glGetShaderiv(shader, GL_COMPILE_STATUS, &success);
+
+   if (!success)
+   {
+      glGetShaderInfoLog(shader, sizeof(info_log), nullptr, info_log);
+      std::cout << "Failed to compile the shader: " << info_log;
+   }
+   return shader;
+}
+
+// Link a vertex and a fragment shader into a program and clean up the shaders
+unsigned link_program(const char* vertex_source, const char* fragment_source)
+{
+   unsigned vertex_shader = compile_shader(GL_VERTEX_SHADER, vertex_source);
+   unsigned fragment_shader = compile_shader(GL_FRAGMENT_SHADER, fragment_source);
+
+   unsigned program = glCreateProgram();
+   glAttachShader(program, vertex_shader);
+   glAttachShader(program, fragment_shader);
+   glLinkProgram(program);
+
+   int success = 0;
+   char info_log[512] = "\0";
+   glGetProgramiv(program, GL_LINK_STATUS, &success);
+
+   if (!success)
+   {
+      glGetProgramInfoLog(program, sizeof(info_log), nullptr, info_log);
+      std::cout << "Failed to link the shader program: " << info_log;
+   }
+
+   glDeleteShader(vertex_shader);
+   glDeleteShader(fragment_shader);
+   return program;
+}
+
+// GL_TIME_ELAPSED queries in a ring, results are read a few frames late so reading never stalls
+class GpuTimer
+{
+public:
+   static constexpr int ring_size = 4;
+
+   GpuTimer() { glGenQueries(ring_size, queries); }
+   ~GpuTimer() { glDeleteQueries(ring_size, queries); }
+
+   GpuTimer(const GpuTimer&) = delete;
+   GpuTimer& operator=(const GpuTimer&) = delete;
+
+   // Skips the frame if the query it would reuse is still waiting for its result
+   void begin()
+   {
+      timing = !pending[next];
+      if (timing)
+         glBeginQuery(GL_TIME_ELAPSED, queries[next]);
+   }
+
+   void end()
+   {
+      if (!timing)
+         return;
+
+      glEndQuery(GL_TIME_ELAPSED);
+      pending[next] = true;
+      next = (next + 1) % ring_size;
+   }
+
+   // Oldest finished measurement in milliseconds, or a negative value if none is ready yet
+   double poll()
+   {
+      for (int i = 0; i < ring_size; ++i)
+      {
+         const int index = (next + i) % ring_size;
+         if (!pending[index])
+            continue;
+
+         int available = 0;
+         glGetQueryObjectiv(queries[index], GL_QUERY_RESULT_AVAILABLE, &available);
+         if (!available)
+            return -1.0;
+
+         GLuint64 nanoseconds = 0;
+         glGetQueryObjectui64v(queries[index], GL_QUERY_RESULT, &nanoseconds);
+         pending[index] = false;
+
+         // llvmpipe returns garbage for the very first query, nothing real takes a second
+         return nanoseconds < 1000000000ull ? nanoseconds / 1e6 : -1.0;
+      }
+      return -1.0;
+   }
+
+private:
+   unsigned queries[ring_size] {};
+   bool pending[ring_size] {};
+   int next = 0;
+   bool timing = false;
+};
+
+// Whether the context exposes an extension, asked at runtime since the GLAD build may not know it at all
+bool has_gl_extension(const char* name)
+{
+   int count = 0;
+   glGetIntegerv(GL_NUM_EXTENSIONS, &count);
+   for (int i = 0; i < count; ++i)
+   {
+      const char* extension = reinterpret_cast<const char*>(glGetStringi(GL_EXTENSIONS, unsigned(i)));
+      if (extension && std::strcmp(extension, name) == 0)
+         return true;
+   }
+   return false;
+}
+
+// Free and total GPU memory in MB as the driver reports it, false when it has no way to
+bool driver_memory(int& free_mb, int& total_mb)
+{
+   // The extension list doesn't change for the life of the context
+   static const bool nvx_memory_info = has_gl_extension("GL_NVX_gpu_memory_info");
+   static const bool ati_meminfo = has_gl_extension("GL_ATI_meminfo");
+
+   if (nvx_memory_info)
+   {
+      int free_kb = 0, total_kb = 0;
+      glGetIntegerv(GL_GPU_MEMORY_INFO_CURRENT_AVAILABLE_VIDMEM_NVX, &free_kb);
+      glGetIntegerv(GL_GPU_MEMORY_INFO_TOTAL_AVAILABLE_MEMORY_NVX, &total_kb);
+      free_mb = free_kb / 1024;
+      total_mb = total_kb / 1024;
+      return true;
+   }
+   if (ati_meminfo)
+   {
+      // Free pool, largest free block, free auxiliary pool, largest auxiliary block, all in KB, no total
+      int texture_free[4] {};
+      glGetIntegerv(GL_TEXTURE_FREE_MEMORY_ATI, texture_free);
+      free_mb = texture_free[0] / 1024;
+      total_mb = -1;
+      return true;
+   }
+   return false;
+}
+
+// Main function
+int main()
+{
+   // Vertex shader, one small triangle per draw call placed by a uniform
+   const char* vertex_shader_source =
+      "#version 330 core\n"
+      "layout (location = 0) in vec2 aPos;\n"
+      "uniform vec3 placement;\n"
+      "out vec3 Color;\n"
+      "void main()\n"
+      "{\n"
+      "   Color = vec3(0.3 + 0.7 * fract(placement.z * 0.618), 0.4, 1.0 - 0.7 * fract(placement.z * 0.382));\n"
+      "   gl_Position = vec4(aPos * 0.02 + placement.xy, 0.0, 1.0);\n"
+      "}\0";
+
+   // Fragment shader
+   const char* fragment_shader_source =
+      "#version 330 core\n"
+      "in vec3 Color;\n"
+      "out vec4 FragColor;\n"
+      "void main()\n"
+      "{\n"
+      "   FragColor = vec4(Color, 1.0);\n"
+      "}\0";
+
+   // Initialize GLFW and tell it the version and profile
+   glfwInit();
+   glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
+   glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
+   glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+
+   // Initialize the window
+   GLFWwindow* window = glfwCreateWindow(800, 600, "Text overlay.", nullptr, nullptr);
+   if (!window)
+      throw_ex("Failed to create the window!");
+
+   // Set the current window
+   glfwMakeContextCurrent(window);
+
+   // Initialize GLAD
+   if (!gladLoadGLLoader(GLADloadproc(glfwGetProcAddress)))
+      throw_ex("Failed to initialize GLAD!");
+
+   // Set the viewport
+   glViewport(0, 0, 800, 600);
+
+   // Set window resize callback
+   glfwSetFramebufferSizeCallback(window, framebuffer_size_callback);
+
+   // Create the shader program
+   unsigned shader_program = link_program(vertex_shader_source, fragment_shader_source);
+   const int placement_location = glGetUniformLocation(shader_program, "placement");
+
+   // The scope makes sure the text renderer and the timer are deleted before glfwTerminate
+   {
+      // Glyph atlas from the cache when there is one, the first run generates and writes it
+      const auto atlas_start = std::chrono::steady_clock::now();
+      TextRenderer text("glyph_atlas.sdf");
+      std::cout << "Glyph atlas " << (text.atlas_was_cached() ? "loaded from glyph_atlas.sdf in " : "generated and cached in ")
+                << std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - atlas_start).count() << " ms\n";
+
+      // Triangle
+      float vertices[] {
+         -1.f, -1.f,
+          1.f, -1.f,
+          0.f,  1.f
+      };
+
+      unsigned VBO = 0, VAO = 0;
+      glGenVertexArrays(1, &VAO);
+      glGenBuffers(1, &VBO);
+      glBindVertexArray(VAO);
+      glBindBuffer(GL_ARRAY_BUFFER, VBO);
+      glBufferData(GL_ARRAY_BUFFER, sizeof(vertices), vertices, GL_STATIC_DRAW);
+      glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, 2 * sizeof(float), (void*)0);
+      glEnableVertexAttribArray(0);
+      glBindVertexArray(0);
+
+      GpuTimer hud_timer;
+      int draw_count = 1024;
+      bool show_hud = true, h_down = false, up_down = false, down_down = false;
+
+      // Frame time statistics, shown for the last complete half second so the numbers can be read
+      double window_start = glfwGetTime(), last_frame = window_start, frame_sum = 0.0, frame_min = 1e9, frame_max = 0.0;
+      double shown_average = 0.0, shown_min = 0.0, shown_max = 0.0;
+      double hud_cpu_sum = 0.0, hud_gpu_sum = 0.0, shown_hud_cpu = 0.0, shown_hud_gpu = 0.0;
+      int window_frames = 0, hud_gpu_samples = 0;
+      double stats_time = window_start;
+
+      // Create the render loop
+      while (!glfwWindowShouldClose(window))
+      {
+         // Check if the window should close
+         if (glfwGetKey(window, GLFW_KEY_ESCAPE) == GLFW_PRESS)
+            glfwSetWindowShouldClose(window, true);
+
+         // H toggles the overlay, up and down double and halve the draw calls
+         const bool h_pressed = glfwGetKey(window, GLFW_KEY_H) == GLFW_PRESS;
+         const bool up_pressed = glfwGetKey(window, GLFW_KEY_UP) == GLFW_PRESS;
+         const bool down_pressed = glfwGetKey(window, GLFW_KEY_DOWN) == GLFW_PRESS;
+         if (h_pressed && !h_down)
+            show_hud = !show_hud;
+         if (up_pressed && !up_down)
+            draw_count = std::min(draw_count * 2, 65536);
+         if (down_pressed && !down_down)
+            draw_count = std::max(draw_count / 2, 1);
+         h_down = h_pressed;
+         up_down = up_pressed;
+         down_down = down_pressed;
+
+         const double now = glfwGetTime(), frame_ms = (now - last_frame) * 1000.0;
+         last_frame = now;
+         frame_sum += frame_ms;
+         frame_min = std::min(frame_min, frame_ms);
+         frame_max = std::max(frame_max, frame_ms);
+         ++window_frames;
+         if (now - window_start >= .5)
+         {
+            shown_average = frame_sum / window_frames;
+            shown_min = frame_min;
+            shown_max = frame_max;
+            shown_hud_cpu = hud_cpu_sum / window_frames;
+            shown_hud_gpu = hud_gpu_samples ? hud_gpu_sum / hud_gpu_samples : 0.0;
+            window_start = now;
+            frame_sum = hud_cpu_sum = hud_gpu_sum = 0.0;
+            frame_min = 1e9;
+            frame_max = 0.0;
+            window_frames = hud_gpu_samples = 0;
+         }
+
+         // Render
+         glClearColor(.5f, .5f, .5f, 1.f);
+         glClear(GL_COLOR_BUFFER_BIT);
+
+         // The scene is a grid of triangles, one draw call each
+         glUseProgram(shader_program);
+         glBindVertexArray(VAO);
+         const int side = int(std::ceil(std::sqrt(double(draw_count))));
+         for (int i = 0; i < draw_count; ++i)
+         {
+            glUniform3f(placement_location, -.95f + 1.9f * (i % side + .5f) / side, -.95f + 1.9f * (i / side + .5f) / side, float(i));
+            glDrawArrays(GL_TRIANGLES, 0, 3);
+         }
+         glBindVertexArray(0);
+
+         if (show_hud)
+         {
+            const auto hud_start = std::chrono::steady_clock::now();
+            hud_timer.begin();
+
+            int width = 0, height = 0;
+            glfwGetFramebufferSize(window, &width, &height);
+
+            // Formatted into a fixed buffer, nothing here allocates once the instance array has grown
+            char line[160];
+            const float size = 18.f, left = 10.f;
+            float y = 10.f;
+            std::snprintf(line, sizeof(line), "Frame %6.2f ms  %5.1f fps  min %.2f  max %.2f", shown_average,
+               shown_average > 0.0 ? 1000.0 / shown_average : 0.0, shown_min, shown_max);
+            text.add(left, y, size, line, shown_average > 17.0 ? 0xff4080ffu : 0xff80ff80u);
+            std::snprintf(line, sizeof(line), "Draw calls %d (%d scene, 1 text)", draw_count + 1, draw_count);
+            text.add(left, y += size, size, line);
+
+            int free_mb = 0, total_mb = 0;
+            const double tracked_kb = (sizeof(vertices) + text.get_memory_bytes()) / 1024.0;
+            if (!driver_memory(free_mb, total_mb))
+               std::snprintf(line, sizeof(line), "Memory %.1f KB tracked, driver reports none", tracked_kb);
+            else if (total_mb < 0)
+               std::snprintf(line, sizeof(line), "Memory %.1f KB tracked, %d MB free", tracked_kb, free_mb);
+            else
+               std::snprintf(line, sizeof(line), "Memory %.1f KB tracked, %d of %d MB free", tracked_kb, free_mb, total_mb);
+            text.add(left, y += size, size, line);
+
+            std::snprintf(line, sizeof(line), "HUD %.3f ms CPU  %.3f ms GPU  %zu glyphs", shown_hud_cpu, shown_hud_gpu, text.get_glyph_count());
+            text.add(left, y += size, size, line, 0xffc0c0c0u);
+            text.add(left, float(height) - 30.f, 14.f, "H hides the overlay, up and down change the draw calls", 0xffc0c0c0u);
+
+            text.flush(width, height);
+
+            hud_timer.end();
+            hud_cpu_sum += std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - hud_start).count();
+         }
+
+         const double hud_gpu = hud_timer.poll();
+         if (hud_gpu >= 0.0)
+         {
+            hud_gpu_sum += hud_gpu;
+            ++hud_gpu_samples;
+         }
+
+         // Swap buffers and check and call events
+         glfwSwapBuffers(window);
+         glfwPollEvents();
+
+         // Print the same numbers once a second
+         if (now - stats_time >= 1.0)
+         {
+            std::cout << "Frame " << shown_average << " ms, " << draw_count + (show_hud ? 1 : 0) << " draw calls, HUD " << shown_hud_cpu
+                      << " ms CPU " << shown_hud_gpu << " ms GPU for " << text.get_glyph_count() << " glyphs\n";
+            stats_time = now;
+         }
+      }
+
+      glDeleteVertexArrays(1, &VAO);
+      glDeleteBuffers(1, &VBO);
+   }
+
+   // Clean up
+   glDeleteProgram(shader_program);
+   glfwTerminate();
+   return 0;
+}
@@ -0,0 +1,386 @@
+#pragma once
+#include <glad/glad.h>
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+
+// Text from a signed distance field glyph atlas, drawn as one instanced quad per glyph
+// The glyph shapes come from a built-in 5x8 bitmap font. Every font pixel is a square, and each texel of the
+// atlas stores the distance from its center to the nearest edge of those squares, positive inside, so the
+// shader gets a clean outline at any size by thresholding at .5 and an outline for free at a lower threshold.
+// Generating the atlas is the only expensive part, it is done once and written to a cache file, which is
+// used as long as its header matches the current atlas parameters and font.
+//
+// Text is queued with add() and everything queued goes out in flush() as a single draw: the quad corners come
+// from gl_VertexID, each instance is 20 bytes of position, size, glyph and color.
+
+// Columns of the ASCII glyphs 32 to 126, bit 0 is the top row
+constexpr unsigned char font_5x8[95][5] {
+   { 0x00, 0x00, 0x00, 0x00, 0x00 }, { 0x00, 0x00, 0x5f, 0x00, 0x00 }, { 0x00, 0x07, 0x00, 0x07, 0x00 },
+   { 0x14, 0x7f, 0x14, 0x7f, 0x14 }, { 0x24, 0x2a, 0x7f, 0x2a, 0x12 }, { 0x23, 0x13, 0x08, 0x64, 0x62 },
+   { 0x36, 0x49, 0x56, 0x20, 0x50 }, { 0x00, 0x00, 0x07, 0x00, 0x00 }, { 0x00, 0x1c, 0x22, 0x41, 0x00 },
+   { 0x00, 0x41, 0x22, 0x1c, 0x00 }, { 0x2a, 0x1c, 0x7f, 0x1c, 0x2a }, { 0x08, 0x08, 0x3e, 0x08, 0x08 },
+   { 0x00, 0x80, 0x60, 0x00, 0x00 }, { 0x08, 0x08, 0x08, 0x08, 0x08 }, { 0x00, 0x60, 0x60, 0x00, 0x00 },
+   { 0x20, 0x10, 0x08, 0x04, 0x02 }, { 0x3e, 0x51, 0x49, 0x45, 0x3e }, { 0x00, 0x42, 0x7f, 0x40, 0x00 },
+   { 0x42, 0x61, 0x51, 0x49, 0x46 }, { 0x21, 0x41, 0x45, 0x4b, 0x31 }, { 0x18, 0x14, 0x12, 0x7f, 0x10 },
+   { 0x27, 0x45, 0x45, 0x45, 0x39 }, { 0x3c, 0x4a, 0x49, 0x49, 0x30 }, { 0x01, 0x71, 0x09, 0x05, 0x03 },
+   { 0x36, 0x49, 0x49, 0x49, 0x36 }, { 0x06, 0x49, 0x49, 0x29, 0x1e }, { 0x00, 0x36, 0x36, 0x00, 0x00 },
+   { 0x00, 0x56, 0x36, 0x00, 0x00 }, { 0x08, 0x14, 0x22, 0x41, 0x00 }, { 0x14, 0x14, 0x14, 0x14, 0x14 },
+   { 0x00, 0x41, 0x22, 0x14, 0x08 }, { 0x02, 0x01, 0x51, 0x09, 0x06 }, { 0x32, 0x49, 0x79, 0x41, 0x3e },
+   { 0x7e, 0x11, 0x11, 0x11, 0x7e }, { 0x7f, 0x49, 0x49, 0x49, 0x36 }, { 0x3e, 0x41, 0x41, 0x41, 0x22 },
+   { 0x7f, 0x41, 0x41, 0x22, 0x1c }, { 0x7f, 0x49, 0x49, 0x49, 0x41 }, { 0x7f, 0x09, 0x09, 0x09, 0x01 },
+   { 0x3e, 0x41, 0x49, 0x49, 0x7a }, { 0x7f, 0x08, 0x08, 0x08, 0x7f }, { 0x00, 0x41, 0x7f, 0x41, 0x00 },
+   { 0x20, 0x40, 0x41, 0x3f, 0x01 }, { 0x7f, 0x08, 0x14, 0x22, 0x41 }, { 0x7f, 0x40, 0x40, 0x40, 0x40 },
+   { 0x7f, 0x02, 0x0c, 0x02, 0x7f }, { 0x7f, 0x04, 0x08, 0x10, 0x7f }, { 0x3e, 0x41, 0x41, 0x41, 0x3e },
+   { 0x7f, 0x09, 0x09, 0x09, 0x06 }, { 0x3e, 0x41, 0x51, 0x21, 0x5e }, { 0x7f, 0x09, 0x19, 0x29, 0x46 },
+   { 0x46, 0x49, 0x49, 0x49, 0x31 }, { 0x01, 0x01, 0x7f, 0x01, 0x01 }, { 0x3f, 0x40, 0x40, 0x40, 0x3f },
+   { 0x1f, 0x20, 0x40, 0x20, 0x1f }, { 0x3f, 0x40, 0x38, 0x40, 0x3f }, { 0x63, 0x14, 0x08, 0x14, 0x63 },
+   { 0x07, 0x08, 0x70, 0x08, 0x07 }, { 0x61, 0x51, 0x49, 0x45, 0x43 }, { 0x00, 0x7f, 0x41, 0x41, 0x00 },
+   { 0x02, 0x04, 0x08, 0x10, 0x20 }, { 0x00, 0x41, 0x41, 0x7f, 0x00 }, { 0x04, 0x02, 0x01, 0x02, 0x04 },
+   { 0x80, 0x80, 0x80, 0x80, 0x80 }, { 0x00, 0x01, 0x02, 0x04, 0x00 }, { 0x20, 0x54, 0x54, 0x54, 0x78 },
+   { 0x7f, 0x48, 0x44, 0x44, 0x38 }, { 0x38, 0x44, 0x44, 0x44, 0x20 }, { 0x38, 0x44, 0x44, 0x48, 0x7f },
+   { 0x38, 0x54, 0x54, 0x54, 0x18 }, { 0x08, 0x7e, 0x09, 0x01, 0x02 }, { 0x18, 0xa4, 0xa4, 0xa4, 0x7c },
+   { 0x7f, 0x08, 0x04, 0x04, 0x78 }, { 0x00, 0x44, 0x7d, 0x40, 0x00 }, { 0x40, 0x80, 0x84, 0x7d, 0x00 },
+   { 0x7f, 0x10, 0x28, 0x44, 0x00 }, { 0x00, 0x41, 0x7f, 0x40, 0x00 }, { 0x7c, 0x04, 0x18, 0x04, 0x78 },
+   { 0x7c, 0x08, 0x04, 0x04, 0x78 }, { 0x38, 0x44, 0x44, 0x44, 0x38 }, { 0xfc, 0x24, 0x24, 0x24, 0x18 },
+   { 0x18, 0x24, 0x24, 0x28, 0xfc }, { 0x7c, 0x08, 0x04, 0x04, 0x08 }, { 0x48, 0x54, 0x54, 0x54, 0x20 },
+   { 0x04, 0x3f, 0x44, 0x40, 0x20 }, { 0x3c, 0x40, 0x40, 0x20, 0x7c }, { 0x1c, 0x20, 0x40, 0x20, 0x1c },
+   { 0x3c, 0x40, 0x30, 0x40, 0x3c }, { 0x44, 0x28, 0x10, 0x28, 0x44 }, { 0x1c, 0xa0, 0xa0, 0xa0, 0x7c },
+   { 0x44, 0x64, 0x54, 0x4c, 0x44 }, { 0x00, 0x08, 0x36, 0x41, 0x00 }, { 0x00, 0x00, 0x7f, 0x00, 0x00 },
+   { 0x00, 0x41, 0x36, 0x08, 0x00 }, { 0x10, 0x08, 0x08, 0x10, 0x08 }
+};
+
+class GlyphAtlas
+{
+public:
+   static constexpr int first_char = 32, glyph_count = 95, columns = 16, rows = 6;
+   // A cell is 8 by 10 font pixels: the 5x8 glyph, spacing, and room for the distance to fall off
+   static constexpr int pixel_texels = 4, cell_width = 8 * pixel_texels, cell_height = 10 * pixel_texels;
+   static constexpr int glyph_left = 3 * pixel_texels / 2, glyph_top = pixel_texels;
+   // Distance in texels that maps to the full range of a byte around .5
+   static constexpr int spread = 4;
+   static constexpr int width = columns * cell_width, height = rows * cell_height;
+
+   // Uses the cache file if it matches, otherwise generates the atlas and writes the cache, true if it was cached
+   bool load_or_generate(const std::string& path)
+   {
+      if (load(path))
+         return true;
+
+      generate();
+      save(path);
+      return false;
+   }
+
+   void generate()
+   {
+      texels.assign(size_t(width) * height, 0);
+      for (int glyph = 0; glyph < glyph_count; ++glyph)
+      {
+         const int cell_x = glyph % columns * cell_width, cell_y = glyph / columns * cell_height;
+         for (int y = 0; y < cell_height; ++y)
+            for (int x = 0; x < cell_width; ++x)
+            {
+               const float distance = signed_distance(glyph, x + .5f, y + .5f);
+               const float value = 127.5f + distance * 127.5f / spread;
+               texels[size_t(cell_y + y) * width + size_t(cell_x + x)] = (unsigned char)std::min(255.f, std::max(0.f, value + .5f));
+            }
+      }
+   }
+
+   // R8 texture of the atlas, linear filtering is what makes the distance field work
+   unsigned create_texture() const
+   {
+      unsigned texture = 0;
+      glGenTextures(1, &texture);
+      glBindTexture(GL_TEXTURE_2D, texture);
+      glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+      glTexImage2D(GL_TEXTURE_2D, 0, GL_R8, width, height, 0, GL_RED, GL_UNSIGNED_BYTE, texels.data());
+      glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+      glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+      glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+      glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+      glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+      glBindTexture(GL_TEXTURE_2D, 0);
+      return texture;
+   }
+
+   const std::vector<unsigned char>& get_texels() const { return texels; }
+
+private:
+   struct CacheHeader
+   {
+      char magic[8];
+      uint32_t width, height, cell_width, cell_height, pixel_texels, spread;
+      uint32_t font_hash;
+   };
+
+   static CacheHeader current_header()
+   {
+      // FNV-1a of the font, so editing a glyph invalidates the cache
+      uint32_t hash = 2166136261u;
+      for (const auto& glyph : font_5x8)
+         for (unsigned char column : glyph)
+            hash = (hash ^ column) * 16777619u;
+
+      return { { 'G', 'L', 'S', 'D', 'F', '0', '0', '1' }, width, height, cell_width, cell_height, pixel_texels, spread, hash };
+   }
+
+   bool load(const std::string& path)
+   {
+      std::ifstream file(path, std::ios::binary);
+      CacheHeader header {};
+      const CacheHeader expected = current_header();
+      if (!file.read(reinterpret_cast<char*>(&header), sizeof(header)) || std::memcmp(&header, &expected, sizeof(header)) != 0)
+         return false;
+
+      texels.resize(size_t(width) * height);
+      return bool(file.read(reinterpret_cast<char*>(texels.data()), std::streamsize(texels.size())));
+   }
+
+   void save(const std::string& path) const
+   {
+      const CacheHeader header = current_header();
+      std::ofstream file(path, std::ios::binary);
+      file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+      file.write(reinterpret_cast<const char*>(texels.data()), std::streamsize(texels.size()));
+   }
+
+   // Font pixel of a glyph, outside the 5x8 grid counts as off
+   static bool pixel(int glyph, int column, int row)
+   {
+      return column >= 0 && column < 5 && row >= 0 && row < 8 && (font_5x8[glyph][column] >> row & 1);
+   }
+
+   // Distance from a point of the cell to the nearest font pixel of the other kind, positive inside the glyph
+   static float signed_distance(int glyph, float x, float y)
+   {
+      const float font_x = (x - glyph_left) / pixel_texels, font_y = (y - glyph_top) / pixel_texels;
+      const bool inside = pixel(glyph, int(std::floor(font_x)), int(std::floor(font_y)));
+
+      // The spread is at most a font pixel, so one ring around the grid covers every candidate
+      float nearest = float(spread);
+      for (int row = -1; row <= 8; ++row)
+         for (int column = -1; column <= 5; ++column)
+         {
+            if (pixel(glyph, column, row) == inside)
+               continue;
+
+            const float left = float(glyph_left + column * pixel_texels), top = float(glyph_top + row * pixel_texels);
+            const float dx = std::max(std::max(left - x, x - left - pixel_texels), 0.f);
+            const float dy = std::max(std::max(top - y, y - top - pixel_texels), 0.f);
+            nearest = std::min(nearest, std::sqrt(dx * dx + dy * dy));
+         }
+      return inside ? nearest : -nearest;
+   }
+
+   std::vector<unsigned char> texels;
+};
+
+class TextRenderer
+{
+public:
+   // Advance of one character as a fraction of the line height, 6 of the 10 font pixels
+   static constexpr float glyph_advance = .6f;
+
+   explicit TextRenderer(const std::string& cache_path)
+   {
+      from_cache = atlas.load_or_generate(cache_path);
+      texture = atlas.create_texture();
+
+      const char* vertex_shader_source =
+         "#version 330 core\n"
+         "layout (location = 0) in vec3 aPlacement;\n"
+         "layout (location = 1) in uint aGlyph;\n"
+         "layout (location = 2) in vec4 aColor;\n"
+         "uniform vec2 viewport;\n"
+         "out vec2 TexCoord;\n"
+         "out vec4 Color;\n"
+         "void main()\n"
+         "{\n"
+         "   vec2 corner = vec2(gl_VertexID & 1, gl_VertexID >> 1);\n"
+         "   vec2 pixel = aPlacement.xy + corner * vec2(0.8, 1.0) * aPlacement.z;\n"
+         "   gl_Position = vec4(pixel.x / viewport.x * 2.0 - 1.0, 1.0 - pixel.y / viewport.y * 2.0, 0.0, 1.0);\n"
+         "   TexCoord = (vec2(aGlyph % 16u, aGlyph / 16u) + corner) / vec2(16.0, 6.0);\n"
+         "   Color = aColor;\n"
+         "}\0";
+
+      // Premultiplied output, the glyph over a dark outline half a font pixel wide
+      const char* fragment_shader_source =
+         "#version 330 core\n"
+         "in vec2 TexCoord;\n"
+         "in vec4 Color;\n"
+         "uniform sampler2D atlas;\n"
+         "out vec4 FragColor;\n"
+         "void main()\n"
+         "{\n"
+         "   float distance = texture(atlas, TexCoord).r;\n"
+         "   float width = max(fwidth(distance) * 0.7, 0.01);\n"
+         "   float fill = smoothstep(0.5 - width, 0.5 + width, distance);\n"
+         "   float outline = smoothstep(0.25 - width, 0.25 + width, distance) * 0.75;\n"
+         "   FragColor = vec4(Color.rgb * fill, max(fill, outline)) * Color.a;\n"
+         "}\0";
+
+      unsigned vertex_shader = compile_shader(GL_VERTEX_SHADER, vertex_shader_source);
+      unsigned fragment_shader = compile_shader(GL_FRAGMENT_SHADER, fragment_shader_source);
+
+      program = glCreateProgram();
+      glAttachShader(program, vertex_shader);
+      glAttachShader(program, fragment_shader);
+      glLinkProgram(program);
+      check_link(program);
+      glDeleteShader(vertex_shader);
+      glDeleteShader(fragment_shader);
+
+      glUseProgram(program);
+      glUniform1i(glGetUniformLocation(program, "atlas"), 0);
+      viewport_location = glGetUniformLocation(program, "viewport");
+      glUseProgram(0);
+
+      glGenVertexArrays(1, &VAO);
+      glGenBuffers(1, &instance_buffer);
+      glBindVertexArray(VAO);
+      glBindBuffer(GL_ARRAY_BUFFER, instance_buffer);
+      glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(Instance), (void*)0);
+      glVertexAttribIPointer(1, 1, GL_UNSIGNED_INT, sizeof(Instance), (void*)offsetof(Instance, glyph));
+      glVertexAttribPointer(2, 4, GL_UNSIGNED_BYTE, GL_TRUE, sizeof(Instance), (void*)offsetof(Instance, color));
+      for (unsigned location = 0; location < 3; ++location)
+      {
+         glEnableVertexAttribArray(location);
+         glVertexAttribDivisor(location, 1);
+      }
+      glBindVertexArray(0);
+      glBindBuffer(GL_ARRAY_BUFFER, 0);
+   }
+
+   TextRenderer(const TextRenderer&) = delete;
+   TextRenderer& operator=(const TextRenderer&) = delete;
+
+   ~TextRenderer()
+   {
+      glDeleteProgram(program);
+      glDeleteVertexArrays(1, &VAO);
+      glDeleteBuffers(1, &instance_buffer);
+      glDeleteTextures(1, &texture);
+   }
+
+   // Queue text with its top left corner at x, y in pixels, size is the line height in pixels and color is 0xAABBGGRR
+   void add(float x, float y, float size, const char* text, uint32_t color = 0xffffffffu)
+   {
+      const float left = x;
+      for (; *text; ++text)
+      {
+         const int character = (unsigned char)*text;
+         if (character == '\n')
+         {
+            x = left;
+            y += size;
+            continue;
+         }
+         if (character > GlyphAtlas::first_char && character < GlyphAtlas::first_char + GlyphAtlas::glyph_count)
+            instances.push_back({ x - .15f * size, y, size, uint32_t(character - GlyphAtlas::first_char), color });
+         x += glyph_advance * size;
+      }
+   }
+
+   // Width in pixels of the longest line of text
+   static float measure(const char* text, float size)
+   {
+      size_t longest = 0, line = 0;
+      for (; *text; ++text)
+      {
+         line = *text == '\n' ? 0 : line + 1;
+         longest = std::max(longest, line);
+      }
+      return float(longest) * glyph_advance * size;
+   }
+
+   // Draw everything queued since the last flush in one call, on top of whatever is there
+   void flush(int viewport_width, int viewport_height)
+   {
+      if (instances.empty())
+         return;
+
+      // Orphan the storage every frame, so the draw of the last frame never holds up this upload
+      glBindBuffer(GL_ARRAY_BUFFER, instance_buffer);
+      if (instances.size() > capacity)
+         capacity = std::max(instances.size(), capacity * 2);
+      glBufferData(GL_ARRAY_BUFFER, GLsizeiptr(capacity * sizeof(Instance)), nullptr, GL_STREAM_DRAW);
+      glBufferSubData(GL_ARRAY_BUFFER, 0, GLsizeiptr(instances.size() * sizeof(Instance)), instances.data());
+      glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+      glEnable(GL_BLEND);
+      glBlendFunc(GL_ONE, GL_ONE_MINUS_SRC_ALPHA);
+      glUseProgram(program);
+      glUniform2f(viewport_location, float(viewport_width), float(viewport_height));
+      glActiveTexture(GL_TEXTURE0);
+      glBindTexture(GL_TEXTURE_2D, texture);
+      glBindVertexArray(VAO);
+      glDrawArraysInstanced(GL_TRIANGLE_STRIP, 0, 4, GLsizei(instances.size()));
+      glBindVertexArray(0);
+      glDisable(GL_BLEND);
+
+      last_glyph_count = instances.size();
+      instances.clear();
+   }
+
+   bool atlas_was_cached() const { return from_cache; }
+   size_t get_glyph_count() const { return last_glyph_count; }
+
+   // GPU memory of the atlas and the instance buffer
+   size_t get_memory_bytes() const { return size_t(GlyphAtlas::width) * GlyphAtlas::height + capacity * sizeof(Instance); }
+
+private:
+   // Compile a shader and print the info log if it fails
+   static unsigned compile_shader(GLenum type, const char* source)
+   {
+      unsigned shader = glCreateShader(type);
+      glShaderSource(shader, 1, &source, nullptr);
+      glCompileShader(shader);
+
+      int success = 0;
+      char info_log[512] = "\0";
+      glGetShaderiv(shader, GL_COMPILE_STATUS, &success);
+
+      if (!success)
+      {
+         glGetShaderInfoLog(shader, sizeof(info_log), nullptr, info_log);
+         std::cout << "Failed to compile the text shader: " << info_log;
+      }
+      return shader;
+   }
+
+   // Check the link status and print the info log if it fails
+   static void check_link(unsigned program)
+   {
+      int success = 0;
+      char info_log[512] = "\0";
+      glGetProgramiv(program, GL_LINK_STATUS, &success);
+
+      if (!success)
+      {
+         glGetProgramInfoLog(program, sizeof(info_log), nullptr, info_log);
+         std::cout << "Failed to link the text shader program: " << info_log;
+      }
+   }
+
+   struct Instance
+   {
+      float x, y, size;
+      uint32_t glyph;
+      uint32_t color;
+   };
+
+   GlyphAtlas atlas;
+   bool from_cache = false;
+   unsigned texture = 0, program = 0, VAO = 0, instance_buffer = 0;
+   int viewport_location = -1;
+   std::vector<Instance> instances;
+   size_t capacity = 0, last_glyph_count = 0;
+};
@@ -0,0 +1,590 @@
+#include <glad/glad.h>
+#include <GLFW/glfw3.h>
+#include <algorithm>
+#include <atomic>
+#include <cassert>
+#include <cmath>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Throw an exception and terminate GLFW
+void throw_ex(const char* msg)
+{
+   std::cout << msg << '\n';
+   glfwTerminate();
+   std::exit(-1);
+}
+
+// Resize callback function
+void framebuffer_size_callback(GLFWwindow*, int width, int height)
+{
+   assert(width > 0 && height > 0);
+   glViewport(0, 0, width, height);
+}
+
+// Compile a shader and print the info log if it fails
+unsigned compile_shader(GLenum type, const char* source)
+{
+   unsigned shader = glCreateShader(type);
+   glShaderSource(shader, 1, &source, nullptr);
+   glCompileShader(shader);
+
+   int success = 0;
+   char info_log[512] = "\0";
+   glGetShaderiv(shader, GL_COMPILE_STATUS, &success);
+
+   if (!success)
+   {
+      glGetShaderInfoLog(shader, sizeof(info_log), nullptr, info_log);
+      std::cout << "Failed to compile the shader: " << info_log;
+   }
+   return shader;
+}
+
+// Link a vertex and a fragment shader into a program and clean up the shaders
+unsigned link_program(const char* vertex_source, const char* fragment_source)
+{
+   unsigned vertex_shader = compile_shader(GL_VERTEX_SHADER, vertex_source);
+   unsigned fragment_shader = compile_shader(GL_FRAGMENT_SHADER, fragment_source);
+
+   unsigned program = glCreateProgram();
+   glAttachShader(program, vertex_shader);
+   glAttachShader(program, fragment_shader);
+   glLinkProgram(program);
+
+   int success = 0;
+   char info_log[512] = "\0";
+   glGetProgramiv(program, GL_LINK_STATUS, &success);
+
+   if (!success)
+   {
+      glGetProgramInfoLog(program, sizeof(info_log), nullptr, info_log);
+      std::cout << "Failed to link the shader program: " << info_log;
+   }
+
+   glDeleteShader(vertex_shader);
+   glDeleteShader(fragment_shader);
+   return program;
+}
+
+// Column-major 4x4 matrix, laid out the way glUniformMatrix4fv and mat4 attributes expect
+struct Mat4
+{
+   float m[16];
+};
+
+Mat4 identity()
+{
+   Mat4 r {};
+   r.m[0] = r.m[5] = r.m[10] = r.m[15] = 1.f;
+   return r;
+}
+
+Mat4 multiply(const Mat4& a, const Mat4& b)
+{
+   Mat4 r {};
+   for (int col = 0; col < 4; ++col)
+      for (int row = 0; row < 4; ++row)
+         r.m[col * 4 + row] =
+            a.m[0 * 4 + row] * b.m[col * 4 + 0] +
+            a.m[1 * 4 + row] * b.m[col * 4 + 1] +
+            a.m[2 * 4 + row] * b.m[col * 4 + 2] +
+            a.m[3 * 4 + row] * b.m[col * 4 + 3];
+   return r;
+}
+
+Mat4 translate(float x, float y, float z)
+{
+   Mat4 r = identity();
+   r.m[12] = x;
+   r.m[13] = y;
+   r.m[14] = z;
+   return r;
+}
+
+Mat4 rotate_z(float angle)
+{
+   Mat4 r = identity();
+   r.m[0] = std::cos(angle);
+   r.m[1] = std::sin(angle);
+   r.m[4] = -r.m[1];
+   r.m[5] = r.m[0];
+   return r;
+}
+
+Mat4 scale(float s)
+{
+   Mat4 r = identity();
+   r.m[0] = r.m[5] = r.m[10] = s;
+   return r;
+}
+
+Mat4 perspective(float fov_y, float aspect, float near_plane, float far_plane)
+{
+   const float f = 1.f / std::tan(fov_y * .5f);
+   Mat4 r {};
+   r.m[0] = f / aspect;
+   r.m[5] = f;
+   r.m[10] = (far_plane + near_plane) / (near_plane - far_plane);
+   r.m[11] = -1.f;
+   r.m[14] = 2.f * far_plane * near_plane / (near_plane - far_plane);
+   return r;
+}
+
+// Work-stealing job system
+// Every thread owns a queue, pops its own jobs from the back and steals from the front of the others
+class JobSystem
+{
+public:
+   explicit JobSystem(unsigned worker_count)
+   {
+      // Queue 0 belongs to the thread that calls parallel_for
+      for (unsigned i = 0; i <= worker_count; ++i)
+         queues.push_back(std::make_unique<Queue>());
+
+      for (unsigned i = 1; i <= worker_count; ++i)
+         workers.emplace_back([this, i] { worker_loop(i); });
+   }
+
+   ~JobSystem()
+   {
+      {
+         std::lock_guard<std::mutex> lock(sleep_mutex);
+         running = false;
+      }
+      wake.notify_all();
+
+      for (std::thread& worker : workers)
+         worker.join();
+   }
+
+   // Split [0, count) into chunks, run fn(begin, end) on every chunk and wait for all of them
+   void parallel_for(size_t count, size_t chunk, const std::function<void(size_t, size_t)>& fn)
+   {
+      if (count == 0)
+         return;
+
+      std::atomic<size_t> remaining((count + chunk - 1) / chunk);
+
+      // Spread the chunks over all queues so every thread starts with local work
+      size_t queue = 0;
+      for (size_t begin = 0; begin < count; begin += chunk)
+      {
+         const size_t end = std::min(begin + chunk, count);
+         push(queue, [&fn, &remaining, begin, end]
+         {
+            fn(begin, end);
+            remaining.fetch_sub(1, std::memory_order_release);
+         });
+         queue = (queue + 1) % queues.size();
+      }
+
+      // Take the lock so a worker can't miss the wake up between checking and sleeping
+      {
+         std::lock_guard<std::mutex> lock(sleep_mutex);
+      }
+      wake.notify_all();
+
+      // Help out instead of blocking until every chunk is done
+      std::function<void()> job;
+      while (remaining.load(std::memory_order_acquire) > 0)
+      {
+         if (pop_or_steal(0, job))
+            job();
+         else
+            std::this_thread::yield();
+      }
+   }
+
+   size_t thread_count() const { return queues.size(); }
+
+private:
+   struct Queue
+   {
+      std::mutex mutex;
+      std::deque<std::function<void()>> jobs;
+   };
+
+   void push(size_t index, std::function<void()> job)
+   {
+      std::lock_guard<std::mutex> lock(queues[index]->mutex);
+      queues[index]->jobs.push_back(std::move(job));
+      queued.fetch_add(1, std::memory_order_release);
+   }
+
+   bool pop_or_steal(size_t index, std::function<void()>& job)
+   {
+      // Own queue first, newest job is the one most likely still in cache
+      {
+         Queue& own = *queues[index];
+         std::lock_guard<std::mutex> lock(own.mutex);
+         if (!own.jobs.empty())
+         {
+            job = std::move(own.jobs.back());
+            own.jobs.pop_back();
+            queued.fetch_sub(1, std::memory_order_acq_rel);
+            return true;
+         }
+      }
+
+      // Steal the oldest job from another thread
+      for (size_t offset = 1; offset < queues.size(); ++offset)
+      {
+         Queue& victim = *queues[(index + offset) % queues.size()];
+         std::lock_guard<std::mutex> lock(victim.mutex);
+         if (!victim.jobs.empty())
+         {
+            job = std::move(victim.jobs.front());
+            victim.jobs.pop_front();
+            queued.fetch_sub(1, std::memory_order_acq_rel);
+            return true;
+         }
+      }
+      return false;
+   }
+
+   void worker_loop(size_t index)
+   {
+      std::function<void()> job;
+      while (true)
+      {
+         if (pop_or_steal(index, job))
+         {
+            job();
+            continue;
+         }
+
+         // Sleep until there is something to steal
+         std::unique_lock<std::mutex> lock(sleep_mutex);
+         wake.wait(lock, [this] { return !running || queued.load(std::memory_order_acquire) > 0; });
+         if (!running)
+            return;
+      }
+   }
+
+   std::vector<std::unique_ptr<Queue>> queues;
+   std::vector<std::thread> workers;
+   std::mutex sleep_mutex;
+   std::condition_variable wake;
+   std::atomic<size_t> queued { 0 };
+   bool running = true;
+};
+
+// Scene graph stored breadth-first, so every level only depends on the level before it
+struct SceneGraph
+{
+   std::vector<int> parent;
+   std::vector<int> level;
+   std::vector<Mat4> local;
+   std::vector<Mat4> world;
+
+   // Local transform is dirty and has to be recomputed
+   std::vector<unsigned char> dirty;
+
+   // Frame in which the world matrix last changed
+   std::vector<std::uint64_t> changed_frame;
+
+   // Nodes of level L are [level_start[L], level_start[L + 1])
+   std::vector<size_t> level_start;
+
+   // Orbit animation parameters
+   std::vector<float> orbit_radius;
+   std::vector<float> orbit_angle;
+   std::vector<float> orbit_speed;
+   std::vector<float> size;
+};
+
+// Add a node, nodes have to be added level by level
+int add_node(SceneGraph& graph, int parent, float radius, float angle, float speed, float size)
+{
+   const int level = parent < 0 ? 0 : graph.level[parent] + 1;
+   assert(graph.level.empty() || level >= graph.level.back());
+
+   graph.parent.push_back(parent);
+   graph.level.push_back(level);
+   graph.local.push_back(multiply(rotate_z(angle), multiply(translate(radius, 0.f, 0.f), scale(size))));
+   graph.world.push_back(identity());
+   graph.dirty.push_back(1);
+   graph.changed_frame.push_back(0);
+   graph.orbit_radius.push_back(radius);
+   graph.orbit_angle.push_back(angle);
+   graph.orbit_speed.push_back(speed);
+   graph.size.push_back(size);
+
+   if (level == static_cast<int>(graph.level_start.size()))
+      graph.level_start.push_back(graph.parent.size() - 1);
+   return static_cast<int>(graph.parent.size() - 1);
+}
+
+// Advance the orbits and mark the moved nodes dirty
+void animate_scene(SceneGraph& graph, float delta_time)
+{
+   for (size_t i = 0; i < graph.parent.size(); ++i)
+   {
+      if (graph.orbit_speed[i] == 0.f)
+         continue;
+
+      graph.orbit_angle[i] += graph.orbit_speed[i] * delta_time;
+      graph.local[i] = multiply(rotate_z(graph.orbit_angle[i]),
+         multiply(translate(graph.orbit_radius[i], 0.f, 0.f), scale(graph.size[i])));
+      graph.dirty[i] = 1;
+   }
+}
+
+// Compute world matrices level by level in parallel and write them straight into the mapped instance buffer
+// Nodes that are not dirty and whose parent did not move keep their world matrix, the buffer is only
+// written for nodes that changed since the last time this particular buffer was uploaded
+size_t update_transforms(SceneGraph& graph, JobSystem& jobs, std::uint64_t frame,
+   Mat4* upload, std::uint64_t upload_frame)
+{
+   std::atomic<size_t> updated(0);
+   const size_t level_count = graph.level_start.size();
+
+   for (size_t level = 0; level < level_count; ++level)
+   {
+      const size_t first = graph.level_start[level];
+      const size_t last = level + 1 < level_count ? graph.level_start[level + 1] : graph.parent.size();
+
+      jobs.parallel_for(last - first, 256, [&](size_t begin, size_t end)
+      {
+         size_t updated_here = 0;
+         for (size_t i = first + begin; i < first + end; ++i)
+         {
+            const int p = graph.parent[i];
+            const bool parent_changed = p >= 0 && graph.changed_frame[p] == frame;
+
+            if (graph.dirty[i] || parent_changed)
+            {
+               graph.world[i] = p >= 0 ? multiply(graph.world[p], graph.local[i]) : graph.local[i];
+               graph.dirty[i] = 0;
+               graph.changed_frame[i] = frame;
+               ++updated_here;
+            }
+
+            if (graph.changed_frame[i] > upload_frame)
+               upload[i] = graph.world[i];
+         }
+         updated.fetch_add(updated_here, std::memory_order_relaxed);
+      });
+   }
+   return updated.load();
+}
+
+// Main function
+int main()
+{
+   // Vertex shader, the model matrix is a per-instance attribute
+   const char* vertex_shader_source =
+      "#version 330 core\n"
+      "layout (location = 0) in vec3 aPos;\n"
+      "layout (location = 1) in mat4 aModel;\n"
+      "uniform mat4 view;\n"
+      "uniform mat4 projection;\n"
+      "void main()\n"
+      "{\n"
+      "   gl_Position = projection * view * aModel * vec4(aPos, 1.0);\n"
+      "}\0";
+
+   // Fragment shader
+   const char* fragment_shader_source =
+      "#version 330 core\n"
+      "out vec4 FragColor;\n"
+      "void main()\n"
+      "{\n"
+      "   FragColor = vec4(1.0f, 0.5f, 0.f, 1.0f);\n"
+      "}\0";
+
+   // Initialize GLFW and tell it the version and profile
+   glfwInit();
+   glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
+   glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
+   glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+
+   // Initialize the window
+   GLFWwindow* window = glfwCreateWindow(800, 600, "Transforms.", nullptr, nullptr);
+   if (!window)
+      throw_ex("Failed to create the window!");
+
+   // Set the current window
+   glfwMakeContextCurrent(window);
+
+   // Initialize GLAD
+   if (!gladLoadGLLoader(GLADloadproc(glfwGetProcAddress)))
+      throw_ex("Failed to initialize GLAD!");
+
+   // Set the viewport
+   glViewport(0, 0, 800, 600);
+
+   // Set window resize callback
+   glfwSetFramebufferSizeCallback(window, framebuffer_size_callback);
+
+   // Create the shader program
+   unsigned shader_program = link_program(vertex_shader_source, fragment_shader_source);
+   const int view_location = glGetUniformLocation(shader_program, "view");
+   const int projection_location = glGetUniformLocation(shader_program, "projection");
+
+   // Build a solar system: every even planet orbits, odd planets and their whole subtree stay still
+   SceneGraph graph;
+   const int sun = add_node(graph, -1, 0.f, 0.f, 0.f, 1.f);
+
+   std::vector<int> planets;
+   for (int i = 0; i < 8; ++i)
+      planets.push_back(add_node(graph, sun, .3f + .1f * i, i * .8f, i % 2 ? 0.f : .5f / (i + 1), .15f));
+
+   std::vector<int> moons;
+   for (int planet : planets)
+      for (int i = 0; i < 16; ++i)
+         moons.push_back(add_node(graph, planet, 1.2f, i * .39f, 0.f, .3f));
+
+   for (int moon : moons)
+      for (int i = 0; i < 16; ++i)
+         add_node(graph, moon, 1.2f, i * .39f, 0.f, .3f);
+
+   const size_t node_count = graph.parent.size();
+
+   // Triangle drawn once for every node
+   float vertices[]
+   {
+      -0.5f, -0.5f, 0.0f,
+       0.5f, -0.5f, 0.0f,
+       0.0f,  0.5f, 0.0f
+   };
+
+   // Create and fill the vertex buffer object
+   unsigned VBO = 0;
+   glGenBuffers(1, &VBO);
+   glBindBuffer(GL_ARRAY_BUFFER, VBO);
+   glBufferData(GL_ARRAY_BUFFER, sizeof(vertices), vertices, GL_STATIC_DRAW);
+
+   // One instance buffer per frame in flight, each guarded by a fence
+   const int frames_in_flight = 3;
+   unsigned instance_VBO[frames_in_flight] {};
+   unsigned VAO[frames_in_flight] {};
+   GLsync fence[frames_in_flight] {};
+   std::uint64_t uploaded_frame[frames_in_flight] {};
+   glGenBuffers(frames_in_flight, instance_VBO);
+   glGenVertexArrays(frames_in_flight, VAO);
+
+   for (int i = 0; i < frames_in_flight; ++i)
+   {
+      glBindVertexArray(VAO[i]);
+
+      // Link vertex attributes
+      glBindBuffer(GL_ARRAY_BUFFER, VBO);
+      glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 3 * sizeof(float), (void*)0);
+      glEnableVertexAttribArray(0);
+
+      // Link the model matrix, a mat4 attribute takes four locations
+      glBindBuffer(GL_ARRAY_BUFFER, instance_VBO[i]);
+      glBufferData(GL_ARRAY_BUFFER, node_count * sizeof(Mat4), nullptr, GL_DYNAMIC_DRAW);
+
+      for (unsigned column = 0; column < 4; ++column)
+      {
+         glVertexAttribPointer(1 + column, 4, GL_FLOAT, GL_FALSE, sizeof(Mat4), (void*)(column * 4 * sizeof(float)));
+         glEnableVertexAttribArray(1 + column);
+         glVertexAttribDivisor(1 + column, 1);
+      }
+   }
+
+   // Unbind VAO
+   glBindBuffer(GL_ARRAY_BUFFER, 0);
+   glBindVertexArray(0);
+
+   // Leave one core to the driver
+   JobSystem jobs(std::max(1u, std::thread::hardware_concurrency()) - 1);
+
+   std::uint64_t frame = 0;
+   double last_time = glfwGetTime();
+   double stats_time = last_time;
+   size_t updated_total = 0;
+   unsigned frames_since_stats = 0;
+
+   // Create the render loop
+   while (!glfwWindowShouldClose(window))
+   {
+      // Check if the window should close
+      if (glfwGetKey(window, GLFW_KEY_ESCAPE) == GLFW_PRESS)
+         glfwSetWindowShouldClose(window, true);
+
+      const double time = glfwGetTime();
+      animate_scene(graph, float(time - last_time));
+      last_time = time;
+      ++frame;
+
+      // Wait until the GPU is done with the buffer we are about to overwrite
+      const int current = frame % frames_in_flight;
+      if (fence[current])
+      {
+         glClientWaitSync(fence[current], GL_SYNC_FLUSH_COMMANDS_BIT, 1000000000);
+         glDeleteSync(fence[current]);
+         fence[current] = nullptr;
+      }
+
+      // Map without invalidating, unchanged matrices from the last upload stay valid
+      glBindBuffer(GL_ARRAY_BUFFER, instance_VBO[current]);
+      Mat4* upload = static_cast<Mat4*>(glMapBufferRange(GL_ARRAY_BUFFER, 0, node_count * sizeof(Mat4),
+         GL_MAP_WRITE_BIT | GL_MAP_UNSYNCHRONIZED_BIT));
+
+      // If the driver can't map it this frame the buffer keeps its last upload and is drawn as it is, the
+      // dirty flags stay set so the next successful upload catches up
+      if (upload)
+      {
+         updated_total += update_transforms(graph, jobs, frame, upload, uploaded_frame[current]);
+         uploaded_frame[current] = frame;
+         glUnmapBuffer(GL_ARRAY_BUFFER);
+      }
+      glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+      // Render
+      glClearColor(.5f, .5f, .5f, 1.f);
+      glClear(GL_COLOR_BUFFER_BIT);
+
+      int width = 0, height = 0;
+      glfwGetFramebufferSize(window, &width, &height);
+      const Mat4 view = translate(0.f, 0.f, -3.f);
+      const Mat4 projection = perspective(.785f, height > 0 ? float(width) / height : 1.f, .1f, 100.f);
+
+      // Use the shader program and upload the camera
+      glUseProgram(shader_program);
+      glUniformMatrix4fv(view_location, 1, GL_FALSE, view.m);
+      glUniformMatrix4fv(projection_location, 1, GL_FALSE, projection.m);
+
+      // Draw every node in a single instanced call
+      glBindVertexArray(VAO[current]);
+      glDrawArraysInstanced(GL_TRIANGLES, 0, 3, GLsizei(node_count));
+      fence[current] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+
+      // Print how much of the hierarchy had to be recomputed
+      ++frames_since_stats;
+      if (time - stats_time >= 1.0)
+      {
+         std::cout << "Updated " << updated_total / frames_since_stats << " of " << node_count
+                   << " nodes per frame on " << jobs.thread_count() << " threads\n";
+         updated_total = 0;
+         frames_since_stats = 0;
+         stats_time = time;
+      }
+
+      // Swap buffers and check and call events
+      glfwSwapBuffers(window);
+      glfwPollEvents();
+   }
+
+   // Clean up
+   for (GLsync sync : fence)
+      if (sync)
+         glDeleteSync(sync);
+   glDeleteVertexArrays(frames_in_flight, VAO);
+   glDeleteBuffers(frames_in_flight, instance_VBO);
+   glDeleteBuffers(1, &VBO);
+   glDeleteProgram(shader_program);
+   glfwTerminate();
+   return 0;
+}
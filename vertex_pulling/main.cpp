@@ -0,0 +1,546 @@
+#include <glad/glad.h>
+#include <GLFW/glfw3.h>
+#include <algorithm>
+#include <cassert>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <vector>
+
+// Throw an exception and terminate GLFW
+void throw_ex(const char* msg)
+{
+   std::cout << msg << '\n';
+   glfwTerminate();
+   std::exit(-1);
+}
+
+// Resize callback function
+void framebuffer_size_callback(GLFWwindow*, int width, int height)
+{
+   assert(width > 0 && height > 0);
+   glViewport(0, 0, width, height);
+}
+
+// Compile a shader and print the info log if it fails
+unsigned compile_shader(GLenum type, const char* source)
+{
+   unsigned shader = glCreateShader(type);
+   glShaderSource(shader, 1, &source, nullptr);
+   glCompileShader(shader);
+
+   int success = 0;
+   char info_log[512] = "\0";
+   glGetShaderiv(shader, GL_COMPILE_STATUS, &success);
+
+   if (!success)
+   {
+      glGetShaderInfoLog(shader, sizeof(info_log), nullptr, info_log);
+      std::cout << "Failed to compile the shader: " << info_log;
+   }
+   return shader;
+}
+
+// Check if a program linked successfully
+void check_link(unsigned program)
+{
+   int success = 0;
+   char info_log[512] = "\0";
+   glGetProgramiv(program, GL_LINK_STATUS, &success);
+
+   if (!success)
+   {
+      glGetProgramInfoLog(program, sizeof(info_log), nullptr, info_log);
+      std::cout << "Failed to link the shader program: " << info_log;
+   }
+}
+
+// Link a vertex and a fragment shader into a program and clean up the shaders
+unsigned link_program(const char* vertex_source, const char* fragment_source)
+{
+   unsigned vertex_shader = compile_shader(GL_VERTEX_SHADER, vertex_source);
+   unsigned fragment_shader = compile_shader(GL_FRAGMENT_SHADER, fragment_source);
+
+   unsigned program = glCreateProgram();
+   glAttachShader(program, vertex_shader);
+   glAttachShader(program, fragment_shader);
+   glLinkProgram(program);
+   check_link(program);
+
+   glDeleteShader(vertex_shader);
+   glDeleteShader(fragment_shader);
+   return program;
+}
+
+// Whether the context exposes an extension, asked at runtime since the GLAD build may not know it at all
+bool has_gl_extension(const char* name)
+{
+   int count = 0;
+   glGetIntegerv(GL_NUM_EXTENSIONS, &count);
+   for (int i = 0; i < count; ++i)
+   {
+      const char* extension = reinterpret_cast<const char*>(glGetStringi(GL_EXTENSIONS, unsigned(i)));
+      if (extension && std::strcmp(extension, name) == 0)
+         return true;
+   }
+   return false;
+}
+
+// Layout glMultiDrawArraysIndirect expects
+struct DrawArraysIndirectCommand
+{
+   unsigned count;
+   unsigned instance_count;
+   unsigned first;
+   unsigned base_instance;
+};
+
+// Vertex layouts, all in 32-bit words so the shader can read any of them from a uint array
+// Packed: vec2 position, RGBA8 color, 3 words. Wide: vec3 position, vec3 color, 6 words.
+// Compact: snorm16 x2 position, RGBA8 color, 2 words.
+enum VertexLayout : unsigned
+{
+   layout_packed,
+   layout_wide,
+   layout_compact,
+   layout_count
+};
+
+constexpr unsigned layout_words[layout_count] { 3, 6, 2 };
+
+// A mesh in the shared buffer, and the VAO it gets on the classic path
+struct Mesh
+{
+   VertexLayout layout;
+   unsigned vertex_word, vertex_count;
+   unsigned index_word, index_count;
+   unsigned VAO, VBO, EBO;
+};
+
+// Per-draw data, matches the std430 layout of the Draw struct in the shader
+struct DrawData
+{
+   unsigned vertex_word;
+   unsigned vertex_layout;
+   unsigned padding[2];
+   float placement[4];
+};
+
+enum class DrawMode
+{
+   VaoPerMesh,
+   PullingPerDraw,
+   PullingMultiDraw
+};
+
+const char* draw_mode_name(DrawMode mode)
+{
+   switch (mode)
+   {
+   case DrawMode::VaoPerMesh: return "VAO per mesh";
+   case DrawMode::PullingPerDraw: return "Vertex pulling, a draw per mesh";
+   case DrawMode::PullingMultiDraw: return "Vertex pulling, one multi-draw";
+   }
+   return "?";
+}
+
+uint32_t float_word(float value)
+{
+   uint32_t word = 0;
+   std::memcpy(&word, &value, sizeof(word));
+   return word;
+}
+
+// Same packing as the GLSL unpack functions, first component in the low bits
+uint32_t pack_unorm4x8(float r, float g, float b, float a)
+{
+   auto unorm = [](float value) { return uint32_t(std::lround(std::min(std::max(value, 0.f), 1.f) * 255.f)); };
+   return unorm(r) | unorm(g) << 8 | unorm(b) << 16 | unorm(a) << 24;
+}
+
+uint32_t pack_snorm2x16(float x, float y)
+{
+   auto snorm = [](float value) { return uint32_t(uint16_t(int16_t(std::lround(std::min(std::max(value, -1.f), 1.f) * 32767.f)))); };
+   return snorm(x) | snorm(y) << 16;
+}
+
+// Append one vertex in the given layout
+void write_vertex(std::vector<uint32_t>& words, VertexLayout layout, float x, float y, float r, float g, float b)
+{
+   switch (layout)
+   {
+   case layout_packed:
+      words.insert(words.end(), { float_word(x), float_word(y), pack_unorm4x8(r, g, b, 1.f) });
+      break;
+   case layout_wide:
+      words.insert(words.end(), { float_word(x), float_word(y), float_word(0.f), float_word(r), float_word(g), float_word(b) });
+      break;
+   default:
+      words.insert(words.end(), { pack_snorm2x16(x, y), pack_unorm4x8(r, g, b, 1.f) });
+      break;
+   }
+}
+
+// Main function
+int main()
+{
+   // Classic path: attributes come from the bound VAO, missing components default to z = 0 and alpha = 1
+   const char* vertex_shader_source_330 =
+      "#version 330 core\n"
+      "layout (location = 0) in vec3 aPos;\n"
+      "layout (location = 1) in vec4 aColor;\n"
+      "uniform vec4 placement;\n"
+      "uniform float time;\n"
+      "out vec4 Color;\n"
+      "void main()\n"
+      "{\n"
+      "   float angle = time + placement.w;\n"
+      "   vec2 p = mat2(cos(angle), sin(angle), -sin(angle), cos(angle)) * aPos.xy * placement.z + placement.xy;\n"
+      "   Color = aColor;\n"
+      "   gl_Position = vec4(p, aPos.z, 1.0);\n"
+      "}\0";
+
+   // Vertex pulling: no attributes, the draw's record says where its vertices are and how they are laid out
+   // gl_VertexID counts from the draw's first, which is where its indices start in the same buffer
+   // The header picks where the draw index comes from, a uniform or gl_DrawIDARB
+   const char* pulling_shader_body =
+      "layout (std430, binding = 0) readonly buffer Geometry { uint words[]; };\n"
+      "struct Draw\n"
+      "{\n"
+      "   uint vertex_word;\n"
+      "   uint vertex_layout;\n"
+      "   uvec2 padding;\n"
+      "   vec4 placement;\n"
+      "};\n"
+      "layout (std430, binding = 1) readonly buffer Draws { Draw draws[]; };\n"
+      "uniform float time;\n"
+      "out vec4 Color;\n"
+      "float word_float(uint i)\n"
+      "{\n"
+      "   return uintBitsToFloat(words[i]);\n"
+      "}\n"
+      "void main()\n"
+      "{\n"
+      "   Draw draw = draws[DRAW_INDEX];\n"
+      "   const uint strides[3] = uint[3](3u, 6u, 2u);\n"
+      "   uint base = draw.vertex_word + words[gl_VertexID] * strides[draw.vertex_layout];\n"
+      "   vec3 position;\n"
+      "   if (draw.vertex_layout == 0u)\n"
+      "   {\n"
+      "      position = vec3(word_float(base), word_float(base + 1u), 0.0);\n"
+      "      Color = unpackUnorm4x8(words[base + 2u]);\n"
+      "   }\n"
+      "   else if (draw.vertex_layout == 1u)\n"
+      "   {\n"
+      "      position = vec3(word_float(base), word_float(base + 1u), word_float(base + 2u));\n"
+      "      Color = vec4(word_float(base + 3u), word_float(base + 4u), word_float(base + 5u), 1.0);\n"
+      "   }\n"
+      "   else\n"
+      "   {\n"
+      "      position = vec3(unpackSnorm2x16(words[base]), 0.0);\n"
+      "      Color = unpackUnorm4x8(words[base + 1u]);\n"
+      "   }\n"
+      "   float angle = time + draw.placement.w;\n"
+      "   vec2 p = mat2(cos(angle), sin(angle), -sin(angle), cos(angle)) * position.xy * draw.placement.z + draw.placement.xy;\n"
+      "   gl_Position = vec4(p, position.z, 1.0);\n"
+      "}\0";
+
+   const std::string per_draw_source = std::string("#version 430 core\n"
+      "uniform uint draw_index;\n"
+      "#define DRAW_INDEX draw_index\n") + pulling_shader_body;
+   const std::string multi_draw_source = std::string("#version 430 core\n"
+      "#extension GL_ARB_shader_draw_parameters : require\n"
+      "#define DRAW_INDEX gl_DrawIDARB\n") + pulling_shader_body;
+
+   // Fragment shader
+   const char* fragment_shader_source =
+      "#version 330 core\n"
+      "in vec4 Color;\n"
+      "out vec4 FragColor;\n"
+      "void main()\n"
+      "{\n"
+      "   FragColor = Color;\n"
+      "}\0";
+
+   // Initialize GLFW, ask for 4.3 and fall back to 3.3
+   glfwInit();
+   glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 4);
+   glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
+   glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+
+   // Initialize the window
+   GLFWwindow* window = glfwCreateWindow(800, 600, "Vertex pulling.", nullptr, nullptr);
+   if (!window)
+   {
+      glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
+      glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
+      window = glfwCreateWindow(800, 600, "Vertex pulling.", nullptr, nullptr);
+   }
+   if (!window)
+      throw_ex("Failed to create the window!");
+
+   // Set the current window
+   glfwMakeContextCurrent(window);
+
+   // Initialize GLAD
+   if (!gladLoadGLLoader(GLADloadproc(glfwGetProcAddress)))
+      throw_ex("Failed to initialize GLAD!");
+
+   // Set the viewport
+   glViewport(0, 0, 800, 600);
+
+   // Set window resize callback
+   glfwSetFramebufferSizeCallback(window, framebuffer_size_callback);
+
+   // Storage buffers need 4.3, the multi-draw needs gl_DrawIDARB on top of that
+   const bool has_pulling = GLAD_GL_VERSION_4_3;
+   const bool has_multi_draw = has_pulling && has_gl_extension("GL_ARB_shader_draw_parameters");
+   std::vector<DrawMode> modes { DrawMode::VaoPerMesh };
+   if (has_pulling)
+      modes.push_back(DrawMode::PullingPerDraw);
+   if (has_multi_draw)
+      modes.push_back(DrawMode::PullingMultiDraw);
+   if (!has_pulling)
+      std::cout << "GL 3.3: no storage buffers, only the VAO per mesh path\n";
+   else if (!has_multi_draw)
+      std::cout << "No ARB_shader_draw_parameters: vertex pulling with a draw per mesh only\n";
+
+   // Create the shader programs
+   unsigned vao_program = link_program(vertex_shader_source_330, fragment_shader_source);
+   unsigned per_draw_program = has_pulling ? link_program(per_draw_source.c_str(), fragment_shader_source) : 0;
+   unsigned multi_draw_program = has_multi_draw ? link_program(multi_draw_source.c_str(), fragment_shader_source) : 0;
+
+   // Meshes: fans of polygons and stars with 3 to 18 points, every layout used by a third of them
+   const int mesh_count = 48;
+   std::vector<uint32_t> words;
+   std::vector<Mesh> meshes;
+   for (int m = 0; m < mesh_count; ++m)
+   {
+      Mesh mesh {};
+      mesh.layout = VertexLayout(m % layout_count);
+      const int points = 3 + m % 16;
+      const bool star = m / 16 == 1;
+      const int rim = star ? points * 2 : points;
+      const float hue = float(m) / mesh_count * 6.2831853f;
+
+      mesh.vertex_word = unsigned(words.size());
+      mesh.vertex_count = unsigned(rim + 1);
+      write_vertex(words, mesh.layout, 0.f, 0.f, 1.f, 1.f, 1.f);
+      for (int i = 0; i < rim; ++i)
+      {
+         const float angle = float(i) / rim * 6.2831853f, radius = star && i % 2 ? .45f : .95f;
+         write_vertex(words, mesh.layout, std::cos(angle) * radius, std::sin(angle) * radius,
+            .5f + .5f * std::cos(hue), .5f + .5f * std::cos(hue + 2.1f), .5f + .5f * std::cos(hue + 4.2f));
+      }
+
+      mesh.index_word = unsigned(words.size());
+      mesh.index_count = unsigned(rim * 3);
+      for (int i = 0; i < rim; ++i)
+         words.insert(words.end(), { 0u, unsigned(1 + i), unsigned(1 + (i + 1) % rim) });
+      meshes.push_back(mesh);
+   }
+
+   // Classic path: a VAO with its own vertex and index buffer for every mesh, the attribute setup follows the layout
+   for (Mesh& mesh : meshes)
+   {
+      const GLsizei stride = GLsizei(layout_words[mesh.layout] * sizeof(uint32_t));
+      glGenVertexArrays(1, &mesh.VAO);
+      glGenBuffers(1, &mesh.VBO);
+      glGenBuffers(1, &mesh.EBO);
+      glBindVertexArray(mesh.VAO);
+      glBindBuffer(GL_ARRAY_BUFFER, mesh.VBO);
+      glBufferData(GL_ARRAY_BUFFER, GLsizeiptr(mesh.vertex_count) * stride, &words[mesh.vertex_word], GL_STATIC_DRAW);
+      glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, mesh.EBO);
+      glBufferData(GL_ELEMENT_ARRAY_BUFFER, GLsizeiptr(mesh.index_count * sizeof(uint32_t)), &words[mesh.index_word], GL_STATIC_DRAW);
+
+      if (mesh.layout == layout_packed)
+      {
+         glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, stride, (void*)0);
+         glVertexAttribPointer(1, 4, GL_UNSIGNED_BYTE, GL_TRUE, stride, (void*)(2 * sizeof(float)));
+      }
+      else if (mesh.layout == layout_wide)
+      {
+         glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, stride, (void*)0);
+         glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, stride, (void*)(3 * sizeof(float)));
+      }
+      else
+      {
+         glVertexAttribPointer(0, 2, GL_SHORT, GL_TRUE, stride, (void*)0);
+         glVertexAttribPointer(1, 4, GL_UNSIGNED_BYTE, GL_TRUE, stride, (void*)(2 * sizeof(int16_t)));
+      }
+      glEnableVertexAttribArray(0);
+      glEnableVertexAttribArray(1);
+   }
+   glBindVertexArray(0);
+
+   // Draws: a 64x64 grid, every cell one of the meshes
+   const int grid = 64, draw_count = grid * grid;
+   std::vector<DrawData> draws(draw_count);
+   std::vector<int> draw_meshes(draw_count);
+   std::vector<DrawArraysIndirectCommand> commands(draw_count);
+   for (int i = 0; i < draw_count; ++i)
+   {
+      draw_meshes[size_t(i)] = i * 7 % mesh_count;
+      const Mesh& mesh = meshes[size_t(draw_meshes[size_t(i)])];
+      draws[size_t(i)] = { mesh.vertex_word, mesh.layout, { 0, 0 },
+         { -1.f + (i % grid + .5f) * 2.f / grid, -1.f + (i / grid + .5f) * 2.f / grid, .9f / grid, float(i) * .37f } };
+      commands[size_t(i)] = { mesh.index_count, 1, mesh.index_word, 0 };
+   }
+
+   // Pulling path: the geometry, the draw records and the commands are each one buffer, bound once
+   unsigned geometry_buffer = 0, draw_buffer = 0, indirect_buffer = 0, empty_VAO = 0;
+   glGenVertexArrays(1, &empty_VAO);
+   if (has_pulling)
+   {
+      glGenBuffers(1, &geometry_buffer);
+      glBindBuffer(GL_SHADER_STORAGE_BUFFER, geometry_buffer);
+      glBufferData(GL_SHADER_STORAGE_BUFFER, GLsizeiptr(words.size() * sizeof(uint32_t)), words.data(), GL_STATIC_DRAW);
+      glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, geometry_buffer);
+
+      glGenBuffers(1, &draw_buffer);
+      glBindBuffer(GL_SHADER_STORAGE_BUFFER, draw_buffer);
+      glBufferData(GL_SHADER_STORAGE_BUFFER, GLsizeiptr(draws.size() * sizeof(DrawData)), draws.data(), GL_STATIC_DRAW);
+      glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 1, draw_buffer);
+
+      glGenBuffers(1, &indirect_buffer);
+      glBindBuffer(GL_DRAW_INDIRECT_BUFFER, indirect_buffer);
+      glBufferData(GL_DRAW_INDIRECT_BUFFER, GLsizeiptr(commands.size() * sizeof(DrawArraysIndirectCommand)), commands.data(), GL_STATIC_DRAW);
+   }
+
+   const int vao_placement_location = glGetUniformLocation(vao_program, "placement");
+   const int vao_time_location = glGetUniformLocation(vao_program, "time");
+   const int per_draw_index_location = has_pulling ? glGetUniformLocation(per_draw_program, "draw_index") : -1;
+   const int per_draw_time_location = has_pulling ? glGetUniformLocation(per_draw_program, "time") : -1;
+   const int multi_draw_time_location = has_multi_draw ? glGetUniformLocation(multi_draw_program, "time") : -1;
+
+   // Everything in one mode, the work per draw is what differs
+   auto render = [&](DrawMode mode, float time)
+   {
+      if (mode == DrawMode::VaoPerMesh)
+      {
+         glUseProgram(vao_program);
+         glUniform1f(vao_time_location, time);
+         for (int i = 0; i < draw_count; ++i)
+         {
+            const Mesh& mesh = meshes[size_t(draw_meshes[size_t(i)])];
+            glBindVertexArray(mesh.VAO);
+            glUniform4fv(vao_placement_location, 1, draws[size_t(i)].placement);
+            glDrawElements(GL_TRIANGLES, GLsizei(mesh.index_count), GL_UNSIGNED_INT, (void*)0);
+         }
+      }
+      else if (mode == DrawMode::PullingPerDraw)
+      {
+         glUseProgram(per_draw_program);
+         glUniform1f(per_draw_time_location, time);
+         glBindVertexArray(empty_VAO);
+         for (int i = 0; i < draw_count; ++i)
+         {
+            glUniform1ui(per_draw_index_location, unsigned(i));
+            glDrawArrays(GL_TRIANGLES, GLint(commands[size_t(i)].first), GLsizei(commands[size_t(i)].count));
+         }
+      }
+      else
+      {
+         glUseProgram(multi_draw_program);
+         glUniform1f(multi_draw_time_location, time);
+         glBindVertexArray(empty_VAO);
+         glMultiDrawArraysIndirect(GL_TRIANGLES, (void*)0, draw_count, 0);
+      }
+      glBindVertexArray(0);
+   };
+
+   // Benchmark: CPU time to submit the frame, and the whole frame with glFinish
+   std::cout << draw_count << " draws of " << mesh_count << " meshes in " << layout_count << " layouts\n";
+   for (DrawMode mode : modes)
+   {
+      for (int frame = 0; frame < 3; ++frame)
+         render(mode, 0.f);
+      glFinish();
+
+      const int frames = 20;
+      double submit_ms = 0.0;
+      const auto start = std::chrono::steady_clock::now();
+      for (int frame = 0; frame < frames; ++frame)
+      {
+         glClear(GL_COLOR_BUFFER_BIT);
+         const auto submit_start = std::chrono::steady_clock::now();
+         render(mode, float(frame) * .01f);
+         submit_ms += std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - submit_start).count();
+         glFinish();
+      }
+      const double frame_ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count() / frames;
+      std::cout << draw_mode_name(mode) << ": " << submit_ms / frames << " ms to submit (" << draw_count / (submit_ms / frames)
+                << " draws/ms), " << frame_ms << " ms per frame\n";
+   }
+
+   size_t mode_index = modes.size() - 1;
+   bool m_down = false;
+   double stats_time = glfwGetTime(), submit_ms = 0.0;
+   int frames = 0;
+   std::cout << draw_mode_name(modes[mode_index]) << ", M switches\n";
+
+   // Create the render loop
+   while (!glfwWindowShouldClose(window))
+   {
+      // Check if the window should close
+      if (glfwGetKey(window, GLFW_KEY_ESCAPE) == GLFW_PRESS)
+         glfwSetWindowShouldClose(window, true);
+
+      const bool m_pressed = glfwGetKey(window, GLFW_KEY_M) == GLFW_PRESS;
+      if (m_pressed && !m_down)
+      {
+         mode_index = (mode_index + 1) % modes.size();
+         std::cout << draw_mode_name(modes[mode_index]) << '\n';
+         submit_ms = 0.0;
+         frames = 0;
+      }
+      m_down = m_pressed;
+
+      // Render
+      glClearColor(.5f, .5f, .5f, 1.f);
+      glClear(GL_COLOR_BUFFER_BIT);
+
+      const auto submit_start = std::chrono::steady_clock::now();
+      render(modes[mode_index], float(glfwGetTime()) * .5f);
+      submit_ms += std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - submit_start).count();
+
+      // Swap buffers and check and call events
+      glfwSwapBuffers(window);
+      glfwPollEvents();
+
+      // Print the submit time once a second
+      ++frames;
+      const double now = glfwGetTime();
+      if (now - stats_time >= 1.0)
+      {
+         std::cout << draw_mode_name(modes[mode_index]) << ": " << submit_ms / frames << " ms to submit, "
+                   << (now - stats_time) * 1000.0 / frames << " ms/frame\n";
+         stats_time = now;
+         submit_ms = 0.0;
+         frames = 0;
+      }
+   }
+
+   // Clean up
+   for (Mesh& mesh : meshes)
+   {
+      glDeleteVertexArrays(1, &mesh.VAO);
+      glDeleteBuffers(1, &mesh.VBO);
+      glDeleteBuffers(1, &mesh.EBO);
+   }
+   glDeleteVertexArrays(1, &empty_VAO);
+   if (has_pulling)
+   {
+      glDeleteBuffers(1, &geometry_buffer);
+      glDeleteBuffers(1, &draw_buffer);
+      glDeleteBuffers(1, &indirect_buffer);
+   }
+   glDeleteProgram(vao_program);
+   glDeleteProgram(per_draw_program);
+   glDeleteProgram(multi_draw_program);
+   glfwTerminate();
+   return 0;
+}